@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <new>
+
+namespace Starsurge {
+    // std::allocator replacement that hands out memory aligned to Align bytes, for SIMD friendly containers.
+    template<typename T, size_t Align>
+    class AlignedAllocator {
+    public:
+        typedef T value_type;
+        template<typename U>
+        struct rebind { typedef AlignedAllocator<U, Align> other; };
+
+        AlignedAllocator() {}
+        template<typename U>
+        AlignedAllocator(const AlignedAllocator<U, Align>&) {}
+
+        T * allocate(size_t n) {
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Align)));
+        }
+        void deallocate(T * p, size_t) {
+            ::operator delete(p, std::align_val_t(Align));
+        }
+
+        template<typename U>
+        friend bool operator==(const AlignedAllocator<T, Align>&, const AlignedAllocator<U, Align>&) { return true; }
+        template<typename U>
+        friend bool operator!=(const AlignedAllocator<T, Align>&, const AlignedAllocator<U, Align>&) { return false; }
+    };
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "Vector.h"
+#include "Matrix.h"
+
+namespace Starsurge {
+    // Axis-aligned bounding box.
+    struct AABB {
+        Vector3 Min;
+        Vector3 Max;
+
+        AABB() {}
+        AABB(Vector3 t_min, Vector3 t_max) : Min(t_min), Max(t_max) {}
+
+        Vector3 GetCenter() const;
+        Vector3 GetExtents() const;
+        bool Contains(const Vector3& point) const;
+        bool Intersects(const AABB& other) const;
+        // Bounds of this box after the transformation, still axis-aligned so it can grow under rotation.
+        AABB Transform(const Matrix4& m) const;
+
+        static AABB Merge(const AABB& a, const AABB& b);
+    };
+
+    struct BoundingSphere {
+        Vector3 Center;
+        float Radius;
+
+        BoundingSphere() : Radius(0) {}
+        BoundingSphere(Vector3 t_center, float t_radius) : Center(t_center), Radius(t_radius) {}
+
+        bool Contains(const Vector3& point) const;
+        bool Intersects(const BoundingSphere& other) const;
+        // Non-uniform scale grows the radius by the largest axis scale.
+        BoundingSphere Transform(const Matrix4& m) const;
+    };
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+namespace Starsurge {
+    enum class SIMDLevel {
+        Scalar = 0,
+        SSE2,
+        AVX2,
+        AVX512
+    };
+
+    // Function table for the batch kernels. There is one table per instruction set, each built in its own
+    // translation unit with its own compiler flags, and the best one the CPU supports is picked at startup.
+    //
+    // The structure-of-arrays kernels take a count that must be a multiple of BATCH_KERNEL_PADDING, the
+    // others handle any count.
+    static const size_t BATCH_KERNEL_PADDING = 16;
+
+    struct BatchKernels {
+        SIMDLevel level;
+
+        void (*Add)(float * x, float * y, float * z, const float * ox, const float * oy, const float * oz, size_t count);
+        void (*Offset)(float * x, float * y, float * z, float ox, float oy, float oz, size_t count);
+        void (*Scale)(float * x, float * y, float * z, float sx, float sy, float sz, size_t count);
+        void (*Normalize)(float * x, float * y, float * z, size_t count);
+        // matrix is a column-major 4x4, the points are treated as w = 1.
+        void (*Transform)(float * x, float * y, float * z, const float * matrix, size_t count);
+        void (*Dot)(const float * ax, const float * ay, const float * az, const float * bx, const float * by, const float * bz, float * out, size_t count);
+        void (*Cross)(const float * ax, const float * ay, const float * az, const float * bx, const float * by, const float * bz, float * ox, float * oy, float * oz, size_t count);
+
+        // Any count. min and max are 3 floats each, count must be at least 1.
+        void (*MinMax)(const float * x, const float * y, const float * z, size_t count, float * min, float * max);
+        // Any count. planes holds planeCount (a,b,c,d) planes facing inwards, a sphere is visible when it is
+        // not entirely behind any of them. visible gets a 0 or 1 per sphere.
+        void (*CullSpheres)(const float * planes, size_t planeCount, const float * x, const float * y, const float * z, const float * radius, size_t count, unsigned char * visible);
+        // Any count. Copies 12 float vertices (position, normal, uv, color) and rescales the 0-255 color to 0-1.
+        void (*PackVertices)(const float * in, float * out, size_t count);
+    };
+
+    SIMDLevel DetectSIMDLevel();
+    SIMDLevel GetSIMDLevel();
+    // Forces a lower (or equal) instruction set than the CPU supports, mostly for benchmarking. The
+    // STARSURGE_SIMD environment variable (scalar, sse2, avx2, avx512) does the same at startup.
+    bool ForceSIMDLevel(SIMDLevel level);
+    std::string GetSIMDLevelName(SIMDLevel level);
+    const BatchKernels & GetBatchKernels();
+
+    // Per instruction set tables, NULL when that instruction set wasn't compiled in.
+    const BatchKernels * GetScalarKernels();
+    const BatchKernels * GetSSE2Kernels();
+    const BatchKernels * GetAVX2Kernels();
+    const BatchKernels * GetAVX512Kernels();
+}
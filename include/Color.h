@@ -4,13 +4,23 @@
 namespace Starsurge {
     class Color : public Vector4 {
     public:
-        Color();
-        Color(float r, float g, float b, float a);
+        constexpr Color() : Vector4(0,0,0,255) {}
+        constexpr Color(float r, float g, float b, float a) : Vector4(r,g,b,a) {
+            // TODO: Clamp 0-255.
+        }
 
-        Color ToOpenGLFormat();
+        // Converts from 0-255 to the 0-1 range OpenGL works in.
+        constexpr Color ToOpenGLFormat() const {
+            return Color(this->data[0] / 255.0f, this->data[1] / 255.0f, this->data[2] / 255.0f, this->data[3] / 255.0f);
+        }
     };
 
     namespace Colors {
-        const Color WHITE = Color(255, 255, 255, 255);
+        inline constexpr Color WHITE = Color(255, 255, 255, 255);
+        inline constexpr Color BLACK = Color(0, 0, 0, 255);
+        inline constexpr Color RED = Color(255, 0, 0, 255);
+        inline constexpr Color GREEN = Color(0, 255, 0, 255);
+        inline constexpr Color BLUE = Color(0, 0, 255, 255);
+        inline constexpr Color MAGENTA = Color(255, 0, 255, 255);
     }
 }
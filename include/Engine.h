@@ -10,6 +10,25 @@
 #include "Component.h"
 #include "Mesh.h"
 #include "MeshRenderer.h"
+#include "RenderQueue.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshNormals.h"
+#include "GLObject.h"
+#include "GLStateCache.h"
+#include "GeometryPool.h"
+#include "VertexFormat.h"
+#include "MeshFile.h"
+#include "MappedFile.h"
+#include "ModelImporter.h"
 #include "Vector.h"
+#include "VectorExpression.h"
+#include "Matrix.h"
+#include "Quaternion.h"
+#include "Bounds.h"
+#include "Frustum.h"
+#include "Vector3Array.h"
 #include "Color.h"
+#include "Packing.h"
 #include "Utils.h"
+#include "CPUDispatch.h"
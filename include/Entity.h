@@ -1,6 +1,9 @@
 #pragma once
 #include <vector>
 #include "Vector.h"
+#include "Matrix.h"
+#include "Quaternion.h"
+#include "Bounds.h"
 #include "Component.h"
 
 namespace Starsurge {
@@ -12,6 +15,18 @@ namespace Starsurge {
         void Toggle();
         bool IsEnabled();
         std::string GetName();
+
+        void SetPosition(Vector3 t_position);
+        void SetRotation(Quaternion t_rotation);
+        void SetRotation(Vector3 euler);
+        void SetScale(Vector3 t_scale);
+        Vector3 GetPosition();
+        Quaternion GetRotation();
+        Vector3 GetScale();
+        Matrix4 GetModelMatrix();
+        // World space bounds of the entity's MeshRenderer. Without one, a point at the entity's position.
+        AABB GetWorldAABB();
+        BoundingSphere GetWorldBoundingSphere();
         template<typename T>
         void AddComponent(T * component) {
             if (FindComponent<T>() != NULL) {
@@ -36,7 +51,7 @@ namespace Starsurge {
         bool enabled;
 
         Vector3 position;
-        Vector3 rotation;
+        Quaternion rotation;
         Vector3 scaling;
 
         std::vector<Component*> components;
@@ -0,0 +1,31 @@
+#pragma once
+#include <vector>
+#include "Vector.h"
+#include "Matrix.h"
+#include "Bounds.h"
+#include "Vector3Array.h"
+
+namespace Starsurge {
+    // The six planes of a view frustum, each stored as (a, b, c, d) with the normal pointing inwards, so
+    // a point p is inside when a*p.x + b*p.y + c*p.z + d >= 0.
+    class Frustum {
+    public:
+        enum Plane { LEFT = 0, RIGHT, BOTTOM, TOP, NEAR_PLANE, FAR_PLANE, PLANE_COUNT };
+
+        Frustum();
+        // Extracts the planes from a projection*view matrix, or from projection*view*model for object space.
+        static Frustum FromMatrix(const Matrix4& viewProjection);
+
+        Vector4 GetPlane(Plane plane) const;
+        bool Intersects(const Vector3& point) const;
+        bool Intersects(const BoundingSphere& sphere) const;
+        bool Intersects(const AABB& box) const;
+
+        // Tests every sphere at once with the batch kernels, writing 1 (visible) or 0 (culled) into visible.
+        // radii and visible need at least centers.GetSize() entries. Large batches are split across up to
+        // threads workers, returns the number of visible spheres.
+        size_t CullSpheres(const Vector3Array& centers, const float * radii, unsigned char * visible, unsigned int threads = 1) const;
+    private:
+        alignas(16) float planes[PLANE_COUNT*4];
+    };
+}
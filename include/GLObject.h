@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+
+namespace Starsurge {
+    enum class GLObjectType { Buffer, VertexArray };
+
+    // Names waiting for glDelete*. Owners can be destroyed anywhere, on another thread or with no context
+    // current, so they only queue their names and the game loop deletes them on the GL thread once per
+    // frame. Names queued after the context is gone went with it and are never flushed.
+    class GLDeletionQueue {
+    public:
+        static void Queue(GLObjectType type, unsigned int name);
+        // Deletes everything queued so far. Needs the GL context current.
+        static void Flush();
+        static size_t NumberOfPending();
+    };
+
+    // Owns one GL object name. Move-only; destroying or resetting it queues the name on GLDeletionQueue.
+    class GLObject {
+    public:
+        GLObject() {}
+        ~GLObject();
+        GLObject(const GLObject&) = delete;
+        GLObject& operator=(const GLObject&) = delete;
+        GLObject(GLObject&& other) noexcept;
+        GLObject& operator=(GLObject&& other) noexcept;
+
+        // Generates a new object. Needs the GL context current.
+        static GLObject Create(GLObjectType type);
+
+        unsigned int Get() const { return this->name; }
+        GLObjectType GetType() const { return this->type; }
+        bool IsValid() const { return this->name != 0; }
+        void Reset();
+    private:
+        GLObjectType type = GLObjectType::Buffer;
+        unsigned int name = 0;
+    };
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+namespace Starsurge {
+    // Calls since the last GLStateCache::ResetStats(): Issued reached GL, Elided were dropped because GL
+    // was already in that state.
+    struct GLStateStats {
+        unsigned int Issued;
+        unsigned int Elided;
+    };
+
+    // Shadows the GL state the engine changes and drops calls that wouldn't change anything. Every bind
+    // and enable in the engine goes through here, so nothing needs unbinding after use; code calling GL
+    // directly has to Invalidate() afterwards. Only for the GL thread.
+    class GLStateCache {
+    public:
+        static constexpr unsigned int MAX_TEXTURE_UNITS = 32;
+
+        static void UseProgram(unsigned int program);
+        static void BindVertexArray(unsigned int vao);
+        // GL_ELEMENT_ARRAY_BUFFER is remembered per VAO, like GL does. Targets the cache doesn't know
+        // always go through.
+        static void BindBuffer(unsigned int target, unsigned int buffer);
+        // Binds texture to target on unit, switching the active unit only when needed.
+        static void BindTexture(unsigned int unit, unsigned int target, unsigned int texture);
+        static void SetBlending(bool enabled);
+        static void SetBlendFunc(unsigned int source, unsigned int destination);
+        static void SetDepthTest(bool enabled);
+        static void SetDepthWrite(bool enabled);
+
+        // Forgets everything, so each next call goes through. Needed for a new context or after GL calls
+        // that went around the cache.
+        static void Invalidate();
+        // Deleted names can be handed out again, so forget any binding of them. GLDeletionQueue calls
+        // these.
+        static void ForgetBuffers(const unsigned int * buffers, unsigned int count);
+        static void ForgetVertexArrays(const unsigned int * vaos, unsigned int count);
+
+        static GLStateStats GetStats();
+        static void ResetStats();
+    };
+}
@@ -1,8 +1,17 @@
 #pragma once
 #include <GLFW/glfw3.h>
 #include "Scene.h"
+#include "MeshRenderer.h"
+#include "RenderQueue.h"
+#include "GLStateCache.h"
+#include "Vector3Array.h"
 
 namespace Starsurge {
+    struct CullingStats {
+        unsigned int Visible;
+        unsigned int Culled;
+    };
+
     class Game {
     public:
         Game(std::string t_gamename);
@@ -10,6 +19,22 @@ namespace Starsurge {
         void Run();
 
         void SetScene(Scene * t_scene);
+
+        // Frustum culling of MeshRenderers against the scene's view projection, on by default.
+        void SetFrustumCulling(bool t_enabled);
+        // Large scenes split the plane tests across this many threads.
+        void SetCullingThreads(unsigned int t_threads);
+        // Counts from the last rendered frame.
+        CullingStats GetCullingStats();
+        // Draws every MeshRenderer sharing a mesh and materials with the others as one batch, an instanced
+        // draw call per submesh. On by default.
+        void SetInstancing(bool t_enabled);
+        // Draw order sorted to keep state changes down, see RenderQueue. On by default.
+        void SetDrawSorting(bool t_enabled);
+        // Counts from the last rendered frame.
+        RenderQueueStats GetRenderStats();
+        // GL state changes made and dropped as redundant by GLStateCache during the last rendered frame.
+        GLStateStats GetGLStateStats();
     protected:
         virtual void OnInitialize() = 0;
         virtual void OnUpdate() = 0;
@@ -17,7 +42,27 @@ namespace Starsurge {
         std::string gamename;
     private:
         void GameLoop();
+        // Fills the cull arrays below for entities, each entity's transform computed once per frame.
+        void PrepareEntities(const std::vector<Entity*> & entities);
+        // Drops the entities outside the frustum, along with their entries in the cull arrays.
+        void CullEntities(std::vector<Entity*> & entities);
         GLFWwindow * gameWindow;
         Scene * activeScene;
+
+        bool frustumCulling;
+        unsigned int cullingThreads;
+        CullingStats cullingStats;
+        // Reused every frame so culling doesn't allocate once the scene has settled. The renderers, model
+        // matrices and world spheres line up with the frame's entity list, and LOD selection and
+        // submission reuse them.
+        std::vector<MeshRenderer*> cullRenderers;
+        std::vector<Matrix4> cullModels;
+        std::vector<BoundingSphere> cullSpheres;
+        Vector3Array cullCenters;
+        std::vector<float> cullRadii;
+        std::vector<unsigned char> cullVisible;
+
+        RenderQueue renderQueue;
+        GLStateStats glStateStats;
     };
 }
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "GLObject.h"
+#include "VertexFormat.h"
+
+namespace Starsurge {
+    class GeometryPool;
+
+    // Where an allocation currently lives. Compact() moves allocations around, so look it up again
+    // rather than keeping it across frames.
+    struct GeometryRange {
+        VertexFormat Format;
+        unsigned int VAO;
+        unsigned int VBO;
+        unsigned int EBO;
+        // Index of the first vertex in the arena's vertex buffer, for glDrawElementsBaseVertex.
+        unsigned int BaseVertex;
+        unsigned int VertexCount;
+        // Byte offsets and sizes in the arena's buffers.
+        size_t VertexOffset;
+        size_t IndexOffset;
+        size_t IndexBytes;
+    };
+
+    // A vertex and index range handed out by a GeometryPool. Move-only; destroying or resetting it frees
+    // the range. The pool has to outlive it.
+    class GeometryAllocation {
+    public:
+        GeometryAllocation() {}
+        ~GeometryAllocation();
+        GeometryAllocation(const GeometryAllocation&) = delete;
+        GeometryAllocation& operator=(const GeometryAllocation&) = delete;
+        GeometryAllocation(GeometryAllocation&& other) noexcept;
+        GeometryAllocation& operator=(GeometryAllocation&& other) noexcept;
+
+        bool IsValid() const { return this->pool != NULL; }
+        GeometryPool * GetPool() const { return this->pool; }
+        GeometryRange GetRange() const;
+        void Reset();
+    private:
+        friend class GeometryPool;
+        GeometryPool * pool = NULL;
+        unsigned int id = 0;
+    };
+
+    // Suballocates the vertex and index buffers of many small meshes out of a few large ones. Each arena
+    // is a VAO with one vertex buffer and one index buffer for a single VertexFormat, so meshes sharing
+    // an arena draw without rebinding anything, using glDrawElementsBaseVertex with their range's
+    // offsets. Freed ranges go back on a first fit free list and merge with their neighbours; Compact()
+    // packs what's left to the front of each arena and releases arenas with nothing left in them.
+    // Allocating and compacting need the GL context current, freeing can happen anywhere.
+    class GeometryPool {
+    public:
+        static constexpr size_t DEFAULT_VERTEX_ARENA_SIZE = 16 << 20;
+        static constexpr size_t DEFAULT_INDEX_ARENA_SIZE = 8 << 20;
+
+        // Arena sizes in bytes. Anything bigger than an arena gets an arena of its own.
+        GeometryPool(size_t t_vertexArenaSize = DEFAULT_VERTEX_ARENA_SIZE, size_t t_indexArenaSize = DEFAULT_INDEX_ARENA_SIZE);
+        GeometryPool(const GeometryPool&) = delete;
+        GeometryPool& operator=(const GeometryPool&) = delete;
+
+        // Room for vertexCount vertices in format and indexBytes bytes of indices. The index range starts
+        // 4 byte aligned, so 16 and 32 bit indices can share an arena.
+        GeometryAllocation Allocate(VertexFormat format, size_t vertexCount, size_t indexBytes);
+        // Copies every live range to the front of fresh buffers, GPU side, and frees the old ones through
+        // GLDeletionQueue. Only fragmented arenas are rebuilt.
+        void Compact();
+
+        size_t NumberOfArenas() const;
+        size_t NumberOfAllocations() const;
+        // Bytes sitting in free list blocks other than the last one of each arena, i.e. what Compact()
+        // would win back for large allocations.
+        size_t GetFragmentedBytes() const;
+    private:
+        friend class GeometryAllocation;
+
+        struct Arena {
+            VertexFormat Format;
+            size_t VertexCapacity; // In vertices.
+            size_t IndexCapacity; // In bytes.
+            GLObject VAO;
+            GLObject VBO;
+            GLObject EBO;
+            // Offset -> size of every free block, in the same units as the capacities.
+            std::map<size_t, size_t> FreeVertices;
+            std::map<size_t, size_t> FreeIndices;
+            size_t Allocations = 0;
+        };
+        struct Block {
+            size_t ArenaIndex;
+            size_t FirstVertex;
+            size_t VertexCount;
+            size_t IndexOffset;
+            size_t IndexBytes;
+            bool Live = false;
+        };
+
+        Arena * CreateArena(VertexFormat format, size_t vertexCapacity, size_t indexCapacity);
+        void CompactArena(Arena & arena, size_t arenaIndex);
+        GeometryRange GetRange(unsigned int id) const;
+        void Free(unsigned int id);
+
+        size_t vertexArenaSize;
+        size_t indexArenaSize;
+        std::vector<std::unique_ptr<Arena>> arenas;
+        // Allocation ids are indices into blocks plus one. Freed slots are reused.
+        std::vector<Block> blocks;
+        std::vector<unsigned int> freeIds;
+        mutable std::mutex lock;
+    };
+}
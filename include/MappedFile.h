@@ -0,0 +1,29 @@
+#pragma once
+#include <string>
+
+namespace Starsurge {
+    // A whole file mapped read-only into memory. Pages are loaded by the OS on first touch, so opening is
+    // cheap no matter how big the file is. Not copyable, the mapping is released on Close or destruction.
+    class MappedFile {
+    public:
+        MappedFile() {}
+        ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool Open(const std::string & path);
+        void Close();
+        bool IsOpen() const { return this->data != NULL; }
+
+        // Page aligned.
+        const unsigned char * GetData() const { return this->data; }
+        size_t GetSize() const { return this->size; }
+    private:
+        const unsigned char * data = NULL;
+        size_t size = 0;
+#ifdef _WIN32
+        void * file = NULL;
+        void * mapping = NULL;
+#endif
+    };
+}
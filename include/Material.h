@@ -5,6 +5,9 @@
 #include "Color.h"
 
 namespace Starsurge {
+    // The uniform types Material can upload, parsed from the type name once.
+    enum class UniformType { Bool, Int, UInt, Float, Vec2, Vec3, Vec4, Unsupported };
+
     class MaterialData {
     public:
         MaterialData() {};
@@ -28,9 +31,18 @@ namespace Starsurge {
         void SetData(Vector4 val);
         void SetData(Color val);
     private:
+        friend class Material;
+        // The value as glUniform* takes it. False for types that can't be uploaded.
+        bool Pack(UniformValue & value);
+
         std::string name;
         std::string type;
         std::variant<bool, int, unsigned int, float, double, Vector2, Vector3, Vector4> data;
+        UniformType uniformType = UniformType::Unsupported;
+        // Resolved by the shader when it links, -1 until then.
+        int location = -1;
+        // Set whenever the value changes, cleared once Apply() has checked it against the program.
+        bool dirty = true;
     };
 
     class Material {
@@ -43,10 +55,22 @@ namespace Starsurge {
 
         MaterialData * GetUniform(std::string name);
         void Apply();
+
+        // Transparent materials are drawn after everything opaque, back to front with alpha blending.
+        void SetTransparent(bool t_transparent);
+        bool IsTransparent();
     protected:
         Shader * shader;
+        bool transparent = false;
     private:
         void SetupData();
+        void UpdateLocations();
         std::map<std::string, MaterialData*> data;
+        // data in the shader's uniform slot order.
+        std::vector<MaterialData*> slots;
+        // Tells the shader whose values it holds. New whenever the data is recreated.
+        unsigned int id = 0;
+        // The shader generation the locations in slots are from.
+        unsigned int generation = 0;
     };
 }
@@ -0,0 +1,239 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <initializer_list>
+#include "Logging.h"
+#include "SIMD.h"
+#include "Vector.h"
+
+namespace Starsurge {
+    class Quaternion;
+
+    // An R by C matrix stored column-major, the layout glUniformMatrix*fv expects.
+    template<size_t R, size_t C>
+    class Matrix {
+    public:
+        Matrix(float t_val = 0) {
+            for (size_t i = 0; i < R*C; ++i) {
+                this->data[i] = t_val;
+            }
+        }
+        Matrix(const Matrix<R,C>& other) {
+            for (size_t i = 0; i < R*C; ++i) {
+                this->data[i] = other.data[i];
+            }
+        }
+        // Entries are listed row by row, the way the matrix is written on paper.
+        Matrix(std::initializer_list<float> list) {
+            if (list.size() != R*C) {
+                Error("Not correct amount of data.");
+                for (size_t i = 0; i < R*C; ++i) {
+                    this->data[i] = 0;
+                }
+                return;
+            }
+            size_t i = 0;
+            for (auto it = std::begin(list); it != std::end(list); ++it) {
+                (*this)(i / C, i % C) = *it;
+                i++;
+            }
+        }
+
+        size_t GetRows() const { return R; }
+        size_t GetColumns() const { return C; }
+        const float * GetData() const { return this->data; }
+        float * GetData() { return this->data; }
+
+        Vector<R> GetColumn(size_t col) const {
+            Vector<R> ret;
+            for (size_t i = 0; i < R; ++i) {
+                ret[i] = (*this)(i, col);
+            }
+            return ret;
+        }
+        Vector<C> GetRow(size_t row) const {
+            Vector<C> ret;
+            for (size_t i = 0; i < C; ++i) {
+                ret[i] = (*this)(row, i);
+            }
+            return ret;
+        }
+        void SetColumn(size_t col, const Vector<R>& v) {
+            for (size_t i = 0; i < R; ++i) {
+                (*this)(i, col) = v[i];
+            }
+        }
+        void SetRow(size_t row, const Vector<C>& v) {
+            for (size_t i = 0; i < C; ++i) {
+                (*this)(row, i) = v[i];
+            }
+        }
+
+        Matrix<C,R> Transpose() const {
+            Matrix<C,R> ret;
+            for (size_t i = 0; i < R; ++i) {
+                for (size_t j = 0; j < C; ++j) {
+                    ret(j, i) = (*this)(i, j);
+                }
+            }
+            return ret;
+        }
+        std::string ToString() const {
+            std::string ret = "[";
+            for (size_t i = 0; i < R; ++i) {
+                if (i > 0)
+                    ret += ",";
+                ret += GetRow(i).ToString();
+            }
+            ret += "]";
+            return ret;
+        }
+
+        static Matrix<R,C> Identity() {
+            static_assert(R == C, "Only square matrices have an identity.");
+            Matrix<R,C> ret;
+            for (size_t i = 0; i < R; ++i) {
+                ret(i, i) = 1;
+            }
+            return ret;
+        }
+
+        // Operators:
+        Matrix<R,C>& operator=(const Matrix<R,C>& other) {
+            if (this != &other) {
+                for (size_t i = 0; i < R*C; ++i) {
+                    this->data[i] = other.data[i];
+                }
+            }
+            return *this;
+        }
+        float operator()(size_t row, size_t col) const { return this->data[col*R + row]; }
+        float & operator()(size_t row, size_t col) { return this->data[col*R + row]; }
+        Matrix<R,C>& operator+=(const Matrix<R,C>& rhs) {
+            for (size_t i = 0; i < R*C; ++i) {
+                this->data[i] += rhs.data[i];
+            }
+            return *this;
+        }
+        friend Matrix<R,C> operator+(Matrix<R,C> lhs, const Matrix<R,C>& rhs) { return lhs += rhs; }
+        Matrix<R,C>& operator-=(const Matrix<R,C>& rhs) {
+            for (size_t i = 0; i < R*C; ++i) {
+                this->data[i] -= rhs.data[i];
+            }
+            return *this;
+        }
+        friend Matrix<R,C> operator-(Matrix<R,C> lhs, const Matrix<R,C>& rhs) { return lhs -= rhs; }
+        friend bool operator==(const Matrix<R,C>& lhs, const Matrix<R,C>& rhs) {
+            for (size_t i = 0; i < R*C; ++i) {
+                if (lhs.data[i] != rhs.data[i]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        friend bool operator!=(const Matrix<R,C>& lhs, const Matrix<R,C>& rhs) { return !(lhs == rhs); }
+
+        friend Vector<R> operator*(const Matrix<R,C>& lhs, const Vector<C>& rhs) {
+            Vector<R> ret;
+            if constexpr (R == 4 && C == 4) {
+                // Each output is a sum of the columns, weighted by the vector's components.
+                SIMD::Float4 sum = SIMD::Mul(SIMD::Load4(lhs.data), SIMD::Splat(rhs[0]));
+                sum = SIMD::Add(sum, SIMD::Mul(SIMD::Load4(lhs.data+4), SIMD::Splat(rhs[1])));
+                sum = SIMD::Add(sum, SIMD::Mul(SIMD::Load4(lhs.data+8), SIMD::Splat(rhs[2])));
+                sum = SIMD::Add(sum, SIMD::Mul(SIMD::Load4(lhs.data+12), SIMD::Splat(rhs[3])));
+                SIMD::Store4(ret.GetData(), sum);
+                return ret;
+            }
+            for (size_t i = 0; i < R; ++i) {
+                float sum = 0;
+                for (size_t j = 0; j < C; ++j) {
+                    sum += lhs(i, j)*rhs[j];
+                }
+                ret[i] = sum;
+            }
+            return ret;
+        }
+    protected:
+        alignas((R*C) % 4 == 0 ? 16 : alignof(float)) float data[R*C];
+
+        template<size_t R2, size_t C2>
+        friend class Matrix;
+    };
+
+    template<size_t R, size_t C, size_t K>
+    Matrix<R,K> operator*(const Matrix<R,C>& lhs, const Matrix<C,K>& rhs) {
+        Matrix<R,K> ret;
+        if constexpr (R == 4 && C == 4 && K == 4) {
+            const float * a = lhs.GetData();
+            const float * b = rhs.GetData();
+            SIMD::Float4 col0 = SIMD::Load4(a);
+            SIMD::Float4 col1 = SIMD::Load4(a+4);
+            SIMD::Float4 col2 = SIMD::Load4(a+8);
+            SIMD::Float4 col3 = SIMD::Load4(a+12);
+            for (size_t j = 0; j < 4; ++j) {
+                const float * bcol = b + j*4;
+                SIMD::Float4 sum = SIMD::Mul(col0, SIMD::Splat(bcol[0]));
+                sum = SIMD::Add(sum, SIMD::Mul(col1, SIMD::Splat(bcol[1])));
+                sum = SIMD::Add(sum, SIMD::Mul(col2, SIMD::Splat(bcol[2])));
+                sum = SIMD::Add(sum, SIMD::Mul(col3, SIMD::Splat(bcol[3])));
+                SIMD::Store4(ret.GetData() + j*4, sum);
+            }
+            return ret;
+        }
+        for (size_t i = 0; i < R; ++i) {
+            for (size_t j = 0; j < K; ++j) {
+                float sum = 0;
+                for (size_t k = 0; k < C; ++k) {
+                    sum += lhs(i, k)*rhs(k, j);
+                }
+                ret(i, j) = sum;
+            }
+        }
+        return ret;
+    }
+
+    class Matrix2 : public Matrix<2,2> {
+    public:
+        Matrix2(float t_val = 0) : Matrix<2,2>(t_val) {}
+        Matrix2(const Matrix<2,2>& other) : Matrix<2,2>(other) {}
+        Matrix2(std::initializer_list<float> list) : Matrix<2,2>(list) {}
+    };
+
+    class Matrix3 : public Matrix<3,3> {
+    public:
+        Matrix3(float t_val = 0) : Matrix<3,3>(t_val) {}
+        Matrix3(const Matrix<3,3>& other) : Matrix<3,3>(other) {}
+        Matrix3(std::initializer_list<float> list) : Matrix<3,3>(list) {}
+    };
+
+    class Matrix4 : public Matrix<4,4> {
+    public:
+        Matrix4(float t_val = 0) : Matrix<4,4>(t_val) {}
+        Matrix4(const Matrix<4,4>& other) : Matrix<4,4>(other) {}
+        Matrix4(std::initializer_list<float> list) : Matrix<4,4>(list) {}
+
+        // Transform a point (w = 1) or a direction (w = 0).
+        Vector3 TransformPoint(const Vector3& point) const;
+        Vector3 TransformDirection(const Vector3& direction) const;
+        // Transforms every point in place, or from `in` into `out`. Four points are done per iteration.
+        void TransformPoints(Vector3 * points, size_t count) const;
+        void TransformPoints(const Vector3 * in, Vector3 * out, size_t count) const;
+        void TransformPoints(std::vector<Vector3>& points) const;
+
+        // Inverse of a matrix whose bottom row is (0,0,0,1).
+        Matrix4 AffineInverse() const;
+        // Splits a TRS matrix back into its translation, euler angles (radians) and scale.
+        void Decompose(Vector3 & translation, Vector3 & rotation, Vector3 & scale) const;
+
+        static Matrix4 Translate(const Vector3& translation);
+        static Matrix4 Scale(const Vector3& scale);
+        static Matrix4 RotateX(float angle);
+        static Matrix4 RotateY(float angle);
+        static Matrix4 RotateZ(float angle);
+        // Rotates around X, then Y, then Z. Angles are in radians.
+        static Matrix4 Rotate(const Vector3& euler);
+        // Translation * Rotation * Scale, i.e. scale first and translate last.
+        static Matrix4 TRS(const Vector3& translation, const Vector3& rotation, const Vector3& scale);
+        static Matrix4 TRS(const Vector3& translation, const Quaternion& rotation, const Vector3& scale);
+    };
+}
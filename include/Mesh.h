@@ -1,9 +1,18 @@
 #pragma once
 #include <vector>
+#include <algorithm>
+#include <memory>
+#include <string>
 #include "Vector.h"
 #include "Color.h"
+#include "Bounds.h"
+#include "GLObject.h"
+#include "GeometryPool.h"
+#include "Vector3Array.h"
+#include "VertexFormat.h"
 
 namespace Starsurge {
+    // Uploaded to the GPU byte for byte by VertexFormat::Full(), so keep it four packed float vectors.
     struct Vertex {
         Vector3 Position;
         Vector3 Normal;
@@ -11,26 +20,177 @@ namespace Starsurge {
         Color Color;
     };
 
+    class MeshFile;
+
+    // A range of a mesh's indices drawn with one material. Submeshes share the mesh's buffers.
+    struct Submesh {
+        unsigned int FirstIndex;
+        unsigned int IndexCount;
+        unsigned int MaterialSlot;
+    };
+
+    // Owns its vertices, indices and GL objects, or a range of a GeometryPool's buffers. Meshes are move-only: moving hands over the GL objects,
+    // and destroying a mesh queues them on GLDeletionQueue. Vertex and index vectors are taken by value,
+    // so std::move them in to avoid a copy.
     class Mesh {
     public:
         Mesh() {};
-        Mesh(std::vector<Vertex> t_vertices, std::vector<unsigned int> t_indices);
+        Mesh(std::vector<Vertex> t_vertices, std::vector<unsigned int> t_indices, VertexFormat t_format = VertexFormat::Full());
+        Mesh(const Mesh&) = delete;
+        Mesh& operator=(const Mesh&) = delete;
+        Mesh(Mesh&&) = default;
+        Mesh& operator=(Mesh&&) = default;
+        // Re-uploads everything, reusing the GL objects once they exist.
         void RebuildMesh();
+        // Uploads only what changed since the last update. MeshRenderer calls this before drawing.
+        void UpdateMesh();
+        bool IsDirty() const;
+
+        // Dynamic meshes keep their encoded vertices around so edits only re-encode and upload the dirty
+        // range. Static meshes free it and re-encode everything on change. The GL usage hint follows how
+        // the buffers actually get updated: static until the first change, then dynamic for partial
+        // updates and stream once most of the buffer is rewritten at a time.
+        void SetDynamic(bool t_dynamic);
+        bool IsDynamic() const;
+
+        const std::vector<Vertex>& GetVertices() const;
+        const std::vector<unsigned int>& GetIndices() const;
+        Vertex GetVertex(size_t i) const;
+        void SetVertices(std::vector<Vertex> t_vertices);
+        void SetVertices(size_t first, const Vertex * t_vertices, size_t count);
+        void SetVertex(size_t i, const Vertex& vertex);
+        void SetIndices(std::vector<unsigned int> t_indices);
+        void SetIndices(size_t first, const unsigned int * t_indices, size_t count);
+
+        void SetVertexFormat(VertexFormat t_format);
+        VertexFormat GetVertexFormat() const;
+        size_t GetVertexBufferSize() const;
+        // Bytes of vertex buffer saved compared to VertexFormat::Full().
+        size_t GetBytesSaved() const;
+
+        // Suballocates the mesh's buffers out of pool instead of giving it buffers of its own, or NULL to go
+        // back to its own. The pool has to outlive the mesh.
+        void SetGeometryPool(GeometryPool * t_pool);
+        GeometryPool * GetGeometryPool() const;
 
+        // Everything a draw needs to know about where the mesh lives: its own buffers at offset 0, or its
+        // pool range. Pooled meshes look their range up under the pool's lock, so draws should call this
+        // once rather than the getters below.
+        GeometryRange GetBuffers() const;
+        // For pooled meshes these are the pool arena's, shared with every other mesh in it.
         unsigned int GetVAO();
         unsigned int GetVBO();
         unsigned int GetEBO();
+        // Where the mesh starts in the buffers above: the base vertex for glDrawElementsBaseVertex and the
+        // byte offset of the first index. Both 0 for meshes with their own buffers.
+        unsigned int GetBaseVertex() const;
+        size_t GetIndexOffset() const;
         unsigned int NumberOfVertices();
         unsigned int NumberOfIndices();
+        // GL_UNSIGNED_SHORT whenever every vertex fits in 16 bits, GL_UNSIGNED_INT otherwise. The indices
+        // are always 32 bit on the CPU.
+        unsigned int GetIndexType() const;
+        size_t GetIndexSize() const;
+
+        // Without any submeshes the whole mesh is one submesh using material slot 0.
+        void AddSubmesh(unsigned int firstIndex, unsigned int indexCount, unsigned int materialSlot);
+        void ClearSubmeshes();
+        // Valid until the submeshes or indices change. Called per renderer per frame, so it never allocates
+        // once the mesh has been drawn.
+        const std::vector<Submesh>& GetSubmeshes() const;
+        unsigned int NumberOfSubmeshes() const;
+        // Object space bounds, recomputed on the first call after the vertices change. Culling needs them
+        // before anything is drawn, so they don't wait for an upload.
+        AABB GetAABB() const;
+        BoundingSphere GetBoundingSphere() const;
+
+        // Writes the mesh as a .ssm file (see MeshFile.h), with the vertices encoded in the mesh's format.
+        // Fails if an index points past the last vertex.
+        bool Save(const std::string & path) const;
+        // Maps a .ssm file and uploads its blocks to GL straight from the mapping. Nothing is converted:
+        // the vertices and indices stay in the mapping, and are only decoded into the CPU copy the first
+        // time something reads or edits them. The one pass over the data is a scan of the index block
+        // for indices past the last vertex, which neither GL nor the CPU side can survive; pipelines that
+        // only load what Save wrote can turn it off with checkIndices. Logs and returns an empty mesh on
+        // failure.
+        static Mesh Load(const std::string & path, bool checkIndices = true);
 
         static Mesh Triangle(Vector3 pt1, Vector3 pt2, Vector3 pt3);
         static Mesh Quad(Vector3 pt1, Vector3 pt2, Vector3 pt3, Vector3 pt4);
     private:
-        std::vector<Vertex> vertices;
-        std::vector<unsigned int> indices;
+        // Half open range of elements [Begin, End) that changed since the last upload.
+        struct DirtyRange {
+            size_t Begin = 0;
+            size_t End = 0;
+
+            bool IsEmpty() const { return this->Begin >= this->End; }
+            void Add(size_t first, size_t count) {
+                if (count == 0) {
+                    return;
+                }
+                if (IsEmpty()) {
+                    this->Begin = first;
+                    this->End = first + count;
+                    return;
+                }
+                this->Begin = std::min(this->Begin, first);
+                this->End = std::max(this->End, first + count);
+            }
+            void Clear() { this->Begin = this->End = 0; }
+        };
+
+        void ComputeBounds() const;
+        // Decodes a loaded mesh's vertices and indices out of its file, once anything needs the CPU copy.
+        void Materialize() const;
+        size_t VertexCount() const;
+        size_t IndexCount() const;
+        // Forgets what the buffers held, after switching to fresh ones.
+        void ResetBuffers();
+        // Makes sure the pool allocation fits the current vertices, indices and format.
+        void UpdateAllocation();
+        // UploadBuffer, or a write into the pool allocation's range for pooled meshes.
+        void WriteBuffer(unsigned int target, const void * data, size_t size, size_t begin, size_t end, size_t & capacity, unsigned int & usage);
+        void SetupAttributes();
+        void UploadVertices();
+        void UploadIndices();
+        unsigned int GetRequiredIndexType() const;
+
+        // Filled in lazily for loaded meshes, see Materialize().
+        mutable std::vector<Vertex> vertices;
+        mutable std::vector<unsigned int> indices;
+        std::vector<Submesh> submeshes;
+        // What GetSubmeshes() returns for meshes without any: one submesh over every index.
+        mutable std::vector<Submesh> wholeMesh;
+        VertexFormat format = VertexFormat::Full();
+        bool dynamic = false;
+
+        GLObject VAO;
+        GLObject VBO;
+        GLObject EBO;
+        GeometryPool * pool = NULL;
+        GeometryAllocation allocation;
+
+        // GPU copy of the vertices in format, kept between updates for dynamic meshes.
+        std::vector<unsigned char> encodedVertices;
+        // 16 bit copy of the indices, kept between updates for dynamic meshes.
+        std::vector<unsigned short> shortIndices;
+        DirtyRange dirtyVertices;
+        DirtyRange dirtyIndices;
+        bool formatDirty = true;
+        // Sizes in bytes and usage hints the buffers were last allocated with.
+        size_t vertexCapacity = 0;
+        size_t indexCapacity = 0;
+        unsigned int vertexUsage = 0;
+        unsigned int indexUsage = 0;
+        unsigned int indexType = 0;
 
-        unsigned int VAO;
-        unsigned int VBO;
-        unsigned int EBO;
+        mutable AABB aabb;
+        mutable BoundingSphere boundingSphere;
+        mutable bool boundsDirty = true;
+        // The positions ComputeBounds() works on, kept so meshes deformed every frame don't allocate.
+        mutable Vector3Array boundsPositions;
+        // The file a loaded mesh came from. While it's held, it is the only copy of the vertices and
+        // indices on the CPU and the vectors above are empty.
+        mutable std::shared_ptr<MeshFile> source;
     };
 }
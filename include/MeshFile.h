@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "Mesh.h"
+
+namespace Starsurge {
+    // The .ssm binary mesh container, little endian:
+    //   MeshFileHeader
+    //   vertex block: VertexCount vertices in the header's VertexFormat, exactly what the VBO holds
+    //   index block:  IndexCount indices, 16 bit when IndexSize is 2 and 32 bit when it's 4
+    //   submesh block: SubmeshCount Submesh records
+    // Every block starts on a MESH_FILE_ALIGNMENT boundary so it can be used straight out of a mapping.
+    const char MESH_FILE_MAGIC[4] = { 'S', 'S', 'M', 'H' };
+    const uint32_t MESH_FILE_VERSION = 1;
+    const size_t MESH_FILE_ALIGNMENT = 64;
+
+    struct MeshFileHeader {
+        char Magic[4];
+        uint32_t Version;
+        // sizeof(MeshFileHeader) when written. Later versions only ever append fields.
+        uint32_t HeaderSize;
+        uint8_t PositionEncoding;
+        uint8_t NormalEncoding;
+        uint8_t UVEncoding;
+        uint8_t ColorEncoding;
+        uint32_t VertexCount;
+        uint32_t VertexStride;
+        uint32_t IndexCount;
+        uint32_t IndexSize;
+        uint32_t SubmeshCount;
+        uint32_t Flags;
+        uint64_t VertexOffset;
+        uint64_t VertexBytes;
+        uint64_t IndexOffset;
+        uint64_t IndexBytes;
+        uint64_t SubmeshOffset;
+        // Object space bounds, so loading doesn't need a pass over the positions.
+        float BoundsMin[3];
+        float BoundsMax[3];
+        float SphereCenter[3];
+        float SphereRadius;
+        uint32_t Reserved[2];
+    };
+    static_assert(sizeof(MeshFileHeader) == 128, "MeshFileHeader is part of the file format.");
+
+    // A mapped .ssm file. Open only checks the header and that every block lies inside the file, the
+    // blocks themselves are never parsed or converted.
+    class MeshFile {
+    public:
+        bool Open(const std::string & path);
+        void Close();
+        bool IsOpen() const { return this->file.IsOpen(); }
+
+        const MeshFileHeader & GetHeader() const { return *this->header; }
+        VertexFormat GetVertexFormat() const;
+        const unsigned char * GetVertexData() const { return this->file.GetData() + this->header->VertexOffset; }
+        const unsigned char * GetIndexData() const { return this->file.GetData() + this->header->IndexOffset; }
+        std::vector<Submesh> GetSubmeshes() const;
+        AABB GetAABB() const;
+        BoundingSphere GetBoundingSphere() const;
+
+        // Writes a file from vertices already encoded in format, see Mesh::Save. Refuses indices past the
+        // last vertex, so files it wrote are safe to load without checking them.
+        static bool Write(const std::string & path, VertexFormat format, const unsigned char * vertexData, size_t vertexCount,
+            const std::vector<unsigned int> & indices, const std::vector<Submesh> & submeshes, const AABB & aabb, const BoundingSphere & sphere);
+    private:
+        MappedFile file;
+        const MeshFileHeader * header = NULL;
+    };
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <vector>
+#include "Mesh.h"
+
+namespace Starsurge {
+    // How much each triangle counts towards the normal of the vertices it touches.
+    enum class NormalWeighting {
+        // By the triangle's area, so small sliver triangles barely matter.
+        Area,
+        // By the triangle's angle at the vertex, which doesn't change when a face is split into more
+        // triangles.
+        Angle
+    };
+
+    // Smooth normals and tangent frames from a triangle list. Both follow the index buffer's topology:
+    // vertices that are already split (hard edges, UV seams) stay split and get their own normal or
+    // tangent, so weld first to smooth across seams. Large meshes are processed across threads; each
+    // vertex sums its triangles in index order, so results are identical for any thread count.
+    class MeshNormals {
+    public:
+        static void GenerateNormals(std::vector<Vertex> & vertices, const std::vector<unsigned int> & indices, NormalWeighting weighting = NormalWeighting::Angle);
+        static void GenerateNormals(Mesh & mesh, NormalWeighting weighting = NormalWeighting::Angle);
+
+        // One tangent per vertex in MikkTSpace's convention: xyz is the unit tangent along +U, orthogonal
+        // to the vertex normal, and w is the handedness, so the bitangent is w * cross(normal, tangent).
+        // Each triangle's UV gradient is projected onto the vertex's tangent plane and weighted by the
+        // corner angle, the same as MikkTSpace for meshes whose vertices are split at tangent seams.
+        // Needs normals, generate them first if the mesh has none. Vertices without usable UVs get an
+        // arbitrary tangent perpendicular to the normal.
+        static std::vector<Vector4> GenerateTangents(const std::vector<Vertex> & vertices, const std::vector<unsigned int> & indices);
+        static std::vector<Vector4> GenerateTangents(const Mesh & mesh);
+    };
+}
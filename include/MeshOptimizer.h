@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+#include "Mesh.h"
+
+namespace Starsurge {
+    // How well an index order uses a FIFO post-transform vertex cache.
+    struct VertexCacheStats {
+        unsigned int VerticesTransformed;
+        // Average cache miss ratio, transformed vertices per triangle. 0.5 is ideal for big grids, 3 is the worst.
+        float ACMR;
+        // Average transform to vertex ratio, transformed vertices per unique vertex. 1 is ideal.
+        float ATVR;
+    };
+
+    struct WeldReport {
+        size_t VerticesBefore;
+        size_t VerticesAfter;
+    };
+
+    struct MeshOptimizerReport {
+        VertexCacheStats Before;
+        VertexCacheStats After;
+    };
+
+    // Reorders a triangle list so the GPU transforms fewer vertices and shades fewer hidden pixels. Run the
+    // stages in order: vertex cache, overdraw, then vertex fetch, since each later one keeps the earlier
+    // ones' work.
+    class MeshOptimizer {
+    public:
+        static const unsigned int DEFAULT_CACHE_SIZE = 16;
+
+        // Runs every stage on the mesh and logs ACMR/ATVR before and after.
+        static MeshOptimizerReport Optimize(Mesh & mesh);
+
+        // Forsyth's linear-speed vertex cache optimization, greedily emits the triangle whose vertices are
+        // most recently used and have the fewest triangles left.
+        static void OptimizeVertexCache(std::vector<unsigned int> & indices, size_t vertexCount);
+        // Splits the cache-optimized order into clusters, Tipsify style, and sorts them so outward facing
+        // clusters draw first. threshold is how much ACMR can worsen, 1.05 allows 5%.
+        static void OptimizeOverdraw(std::vector<unsigned int> & indices, const std::vector<Vertex> & vertices, float threshold = 1.05f);
+        // Puts vertices in the order they're first used and remaps the indices. Unused vertices are
+        // dropped, returns the new vertex count.
+        static size_t OptimizeVertexFetch(std::vector<Vertex> & vertices, std::vector<unsigned int> & indices);
+
+        // Merges duplicate vertices and rewrites the indices to match, keeping the first of each group in
+        // its original order. With epsilon 0 vertices must match exactly (0 and -0 are equal); otherwise
+        // every component, colors in their 0-255 units included, is snapped to an epsilon grid before
+        // comparing. Near duplicates that straddle a grid line stay separate. Large meshes are hashed
+        // across threads, the result doesn't depend on the thread count.
+        static WeldReport WeldVertices(Mesh & mesh, float epsilon = 0);
+        static WeldReport WeldVertices(std::vector<Vertex> & vertices, std::vector<unsigned int> & indices, float epsilon = 0);
+
+        // Only whole triangles with every index below vertexCount are counted; all zeros without any.
+        static VertexCacheStats AnalyzeVertexCache(const std::vector<unsigned int> & indices, size_t vertexCount, unsigned int cacheSize = DEFAULT_CACHE_SIZE);
+    };
+}
@@ -2,15 +2,60 @@
 #include "Component.h"
 #include "Mesh.h"
 #include "Material.h"
+#include "Matrix.h"
+#include "RenderQueue.h"
+#include <vector>
 
 namespace Starsurge {
+    // A simplified stand-in for the renderer's mesh, used once the object covers less than ScreenSize of
+    // the viewport's height.
+    struct MeshLOD {
+        Mesh * LODMesh;
+        float ScreenSize;
+    };
+
     class MeshRenderer : public Component {
     public:
         MeshRenderer(Mesh * t_mesh, Material * t_mat);
+        // One material per slot, indexed by Submesh::MaterialSlot.
+        MeshRenderer(Mesh * t_mesh, std::vector<Material*> t_materials);
 
-        void Render();
+        // Draws the current mesh once, with model and the renderer's color as its instance data.
+        void Render(const Matrix4 & model = Matrix4::Identity());
+        // Draws count instances whose InstanceData starts offset bytes into instanceBuffer, with one draw
+        // call per submesh.
+        void RenderInstanced(unsigned int instanceBuffer, size_t offset, unsigned int count);
+        // Queues each submesh of the current mesh that has a material, to be drawn at model.
+        void Submit(RenderQueue & queue, const Matrix4 & model);
+        Mesh * GetMesh();
+        Material * GetMaterial(unsigned int slot = 0);
+        void SetMaterial(unsigned int slot, Material * t_mat);
+        unsigned int NumberOfMaterials();
+        const std::vector<Material*> & GetMaterials() const;
+        // Tints every vertex color, white by default.
+        void SetColor(Color t_color);
+        Color GetColor();
+
+        // LODs are kept sorted from the largest screen size down, the mesh itself is LOD 0.
+        void AddLOD(Mesh * t_mesh, float t_screenSize);
+        void ClearLODs();
+        unsigned int NumberOfLODs();
+        // Picks the LOD for an object covering screenSize of the viewport's height. A switch only happens
+        // once the size is past a threshold by the hysteresis fraction, so objects near one don't flicker.
+        void SelectLOD(float screenSize);
+        void SetLODHysteresis(float t_hysteresis);
+        unsigned int GetCurrentLOD();
+        // The mesh Render() will draw.
+        Mesh * GetCurrentMesh();
     private:
+        // Draws each submesh of the bound mesh with its material. instances is 0 for a plain draw.
+        void DrawSubmeshes(Mesh * mesh, const GeometryRange & buffers, unsigned int instances);
+
         Mesh * mesh;
-        Material * material;
+        std::vector<Material*> materials;
+        Color color;
+        std::vector<MeshLOD> lods;
+        unsigned int currentLOD;
+        float lodHysteresis;
     };
 }
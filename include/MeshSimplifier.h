@@ -0,0 +1,22 @@
+#pragma once
+#include <vector>
+#include "Mesh.h"
+
+namespace Starsurge {
+    // Quadric error metric simplification by half-edge collapses. Vertices only ever move onto existing
+    // vertices, so the simplified indices still point into the original vertex array and every attribute
+    // stays exact. Vertices on open borders and on UV/color/normal seams (several vertices sharing one
+    // position) are never collapsed, which keeps seams and silhouettes intact.
+    class MeshSimplifier {
+    public:
+        // Collapses edges cheapest first until at most targetIndexCount indices remain, or until the next
+        // collapse would cost more than targetError. Errors are relative to the mesh's largest extent.
+        // resultError, if given, gets the largest error actually introduced.
+        static std::vector<unsigned int> Simplify(const std::vector<Vertex> & vertices, const std::vector<unsigned int> & indices, size_t targetIndexCount, float targetError, float * resultError = NULL);
+
+        // A chain of up to levels LOD meshes, each with about ratio times the triangles of the one before.
+        // Each submesh is simplified on its own so material boundaries survive. The chain ends early once
+        // maxError stops any further reduction.
+        static std::vector<Mesh> GenerateLODs(Mesh & mesh, unsigned int levels, float ratio = 0.5f, float maxError = 0.05f);
+    };
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Mesh.h"
+
+namespace Starsurge {
+    // Geometry read from a model file, before it becomes a Mesh. Submesh::MaterialSlot indexes
+    // MaterialNames, so materials can be looked up by name when building the MeshRenderer.
+    struct ModelData {
+        std::vector<Vertex> Vertices;
+        std::vector<unsigned int> Indices;
+        std::vector<Submesh> Submeshes;
+        std::vector<std::string> MaterialNames;
+    };
+
+    // Imports Wavefront OBJ and glTF 2.0 (.gltf and .glb) files. Everything ends up in one Mesh with a
+    // submesh per material, and identical vertices are shared.
+    class ModelImporter {
+    public:
+        // Picks the format by extension. Needs a GL context, like every Mesh constructor.
+        static Mesh Import(const std::string & path, VertexFormat format = VertexFormat::Full());
+        static bool Load(const std::string & path, ModelData & model);
+
+        // The file is streamed in blocks, each parsed by several threads at once, so memory stays bounded
+        // by the geometry rather than the text. Polygons are triangulated as fans, negative indices and
+        // the common "v x y z r g b" vertex color extension are supported.
+        static bool LoadOBJ(const std::string & path, ModelData & model);
+        // Flattens the default scene: every mesh instance is transformed into model space. Buffers are
+        // mapped rather than read. Only triangle lists are imported, and sparse accessors aren't supported.
+        static bool LoadGLTF(const std::string & path, ModelData & model);
+    };
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "Vector.h"
+
+namespace Starsurge {
+    // IEEE 754 binary16, rounded to nearest even. Values past 65504 become infinity.
+    unsigned short FloatToHalf(float value);
+    float HalfToFloat(unsigned short half);
+
+    // Maps a unit vector onto the octahedron unfolded into [-1,1]^2. Zero vectors encode as (0,0),
+    // which decodes to +Z.
+    Vector2 OctahedralEncode(const Vector3& normal);
+    Vector3 OctahedralDecode(const Vector2& encoded);
+
+    // Fixed point, clamped to the representable range. These match GL's normalized integer conversions.
+    short PackSNorm16(float value);
+    unsigned short PackUNorm16(float value);
+    unsigned char PackUNorm8(float value);
+    float UnpackSNorm16(short value);
+    float UnpackUNorm16(unsigned short value);
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "Vector.h"
+#include "Matrix.h"
+
+namespace Starsurge {
+    // A rotation stored as (x, y, z, w), where w is the real part.
+    class Quaternion : public Vector4 {
+    public:
+        constexpr Quaternion() : Vector4(0,0,0,1) {}
+        constexpr Quaternion(float x, float y, float z, float w) : Vector4(x,y,z,w) {}
+        constexpr Quaternion(const Vector<4>& other) : Vector4(other) {}
+
+        static constexpr Quaternion Identity() { return Quaternion(0,0,0,1); }
+        // Angle is in radians, axis doesn't need to be normalized.
+        static Quaternion AxisAngle(const Vector3& axis, float angle);
+        // Same convention as Matrix4::Rotate, rotates around X, then Y, then Z.
+        static Quaternion FromEuler(const Vector3& euler);
+
+        constexpr Quaternion Conjugate() const { return Quaternion(-this->data[0], -this->data[1], -this->data[2], this->data[3]); }
+        Quaternion Inverse() const {
+            float lengthSq = Vector<4>::Dot(*this, *this);
+            if (lengthSq == 0) {
+                Error("Can't invert zero quaternion.");
+                return Identity();
+            }
+            Quaternion ret;
+            ret.Store(SIMD::Mul(Conjugate().Load(), SIMD::Splat(1.0f/lengthSq)));
+            return ret;
+        }
+        Vector3 Rotate(const Vector3& v) const {
+            // v + w*t + q.xyz x t, where t = 2*(q.xyz x v)
+            SIMD::Float4 q = Load();
+            SIMD::Float4 vec = SIMD::Load3(v.GetData());
+            SIMD::Float4 t = SIMD::Cross(q, vec);
+            t = SIMD::Add(t, t);
+            SIMD::Float4 r = SIMD::Add(SIMD::Add(vec, SIMD::Mul(SIMD::Splat(this->data[3]), t)), SIMD::Cross(q, t));
+            Vector3 ret;
+            SIMD::Store3(ret.GetData(), r);
+            return ret;
+        }
+        Matrix4 ToMatrix() const;
+
+        // Normalized linear interpolation along the shortest arc. Cheap, but not constant speed.
+        static Quaternion Nlerp(const Quaternion& a, const Quaternion& b, float t);
+        // Spherical interpolation along the shortest arc, constant angular speed.
+        static Quaternion Slerp(const Quaternion& a, const Quaternion& b, float t);
+
+        // Batch versions over arrays of quaternions, four at a time. out may alias the inputs.
+        static void BatchNormalize(Quaternion * quats, size_t count);
+        static void BatchMultiply(const Quaternion * lhs, const Quaternion * rhs, Quaternion * out, size_t count);
+        static void BatchRotate(const Quaternion * quats, const Vector3 * in, Vector3 * out, size_t count);
+        static void BatchNlerp(const Quaternion * a, const Quaternion * b, float t, Quaternion * out, size_t count);
+        static void BatchSlerp(const Quaternion * a, const Quaternion * b, float t, Quaternion * out, size_t count);
+
+        friend Quaternion operator*(const Quaternion& lhs, const Quaternion& rhs) {
+            Quaternion ret;
+            ret.Store(SIMD::QuaternionMultiply(lhs.Load(), rhs.Load()));
+            return ret;
+        }
+        Quaternion& operator*=(const Quaternion& rhs) {
+            Store(SIMD::QuaternionMultiply(Load(), rhs.Load()));
+            return *this;
+        }
+        friend Vector3 operator*(const Quaternion& lhs, const Vector3& rhs) { return lhs.Rotate(rhs); }
+    };
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "GLObject.h"
+#include "Material.h"
+#include "Matrix.h"
+#include "Mesh.h"
+
+namespace Starsurge {
+    // One instance's attributes as the shader prelude reads them: the model matrix's columns at
+    // locations 4-7 and an RGBA tint, 0-1, at location 8.
+    struct InstanceData {
+        float Model[16];
+        float Color[4];
+    };
+
+    enum class RenderPass { Opaque = 0, Transparent = 1 };
+
+    // Counts from the last Execute(). A change is counted whenever a draw needs different state than the
+    // one before it.
+    struct RenderQueueStats {
+        unsigned int Commands;
+        unsigned int DrawCalls;
+        unsigned int ProgramChanges;
+        unsigned int MaterialChanges;
+        unsigned int VertexArrayChanges;
+    };
+
+    // Collects a frame's draws and issues them in an order that keeps state changes down. Every submesh
+    // submitted gets a 64 bit key; opaque keys pack the shader, material, mesh, submesh and depth from
+    // most to least significant, so draws group by state and go front to back within a group.
+    // Transparent keys come after all opaque ones and put the depth first, back to front. The keys are
+    // radix sorted, and runs of commands drawing the same submesh with the same material are merged into
+    // one instanced draw.
+    class RenderQueue {
+    public:
+        RenderQueue();
+
+        // Drops last frame's commands. Depths are measured with viewProjection.
+        void Begin(const Matrix4 & viewProjection);
+        // Queues submesh (the submeshIndex-th of mesh) drawn with material at model, tinted by tint.
+        void Submit(Mesh * mesh, const Submesh & submesh, unsigned int submeshIndex, Material * material, const Matrix4 & model, Color tint);
+        // Sorts and draws everything submitted since Begin(). Needs the GL context current.
+        void Execute();
+
+        // With sorting off, commands are drawn in submission order, which is handy to compare the stats.
+        void SetSorting(bool t_enabled);
+        // With instancing off, every command is its own draw call.
+        void SetInstancing(bool t_enabled);
+        RenderQueueStats GetStats() const;
+
+        // Turns the instance attributes of the bound VAO on, advancing once per instance.
+        static void EnableInstanceAttributes();
+        // Points them at InstanceData starting offset bytes into the bound GL_ARRAY_BUFFER.
+        static void PointInstanceAttributes(size_t offset);
+        // Back to the generic attribute values, which is what plain draws use.
+        static void DisableInstanceAttributes();
+    private:
+        struct Command {
+            Mesh * DrawMesh;
+            Material * DrawMaterial;
+            Submesh Range;
+            InstanceData Instance;
+        };
+        struct SortItem {
+            uint64_t Key;
+            uint32_t Index;
+        };
+        // Small ids handed out in first seen order each frame, for packing pointers into keys.
+        struct DenseIds {
+            std::unordered_map<const void*, uint32_t> Ids;
+            const void * Last = NULL;
+            uint32_t LastId = 0;
+
+            uint32_t Get(const void * key);
+            void Clear();
+        };
+
+        Matrix4 viewProjection;
+        std::vector<Command> commands;
+        std::vector<SortItem> sortItems;
+        std::vector<SortItem> sortScratch;
+        std::vector<InstanceData> instances;
+        DenseIds shaderIds;
+        DenseIds materialIds;
+        DenseIds meshIds;
+        GLObject instanceBuffer;
+        size_t instanceCapacity;
+        bool sorting;
+        bool instancing;
+        RenderQueueStats stats;
+    };
+}
@@ -0,0 +1,171 @@
+#pragma once
+#include <cstddef>
+#include <cmath>
+
+// Pick the widest instruction set we were compiled for. Define STARSURGE_NO_SIMD to force the scalar fallback.
+#if !defined(STARSURGE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define STARSURGE_SSE 1
+    #include <emmintrin.h>
+    #if defined(__SSE4_1__) || defined(__AVX__)
+        #define STARSURGE_SSE41 1
+        #include <smmintrin.h>
+    #endif
+#endif
+
+namespace Starsurge {
+    namespace SIMD {
+#ifdef STARSURGE_SSE
+        typedef __m128 Float4;
+
+        inline Float4 Load3(const float * p) {
+            // Only touch the three floats we own, w is zeroed. __m64 may alias floats, a double* load would
+            // let the compiler move it ahead of stores to p.
+            __m128 xy = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)p);
+            __m128 z = _mm_load_ss(p+2);
+            return _mm_movelh_ps(xy, z);
+        }
+        inline Float4 Load4(const float * p) { return _mm_loadu_ps(p); }
+        inline void Store3(float * p, Float4 v) {
+            _mm_storel_pi((__m64*)p, v);
+            _mm_store_ss(p+2, _mm_movehl_ps(v, v));
+        }
+        inline void Store4(float * p, Float4 v) { _mm_storeu_ps(p, v); }
+
+        inline Float4 Splat(float s) { return _mm_set1_ps(s); }
+        inline Float4 Add(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+        inline Float4 Sub(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+        inline Float4 Mul(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+        inline Float4 Div(Float4 a, Float4 b) { return _mm_div_ps(a, b); }
+        inline Float4 Abs(Float4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+        inline Float4 Min(Float4 a, Float4 b) { return _mm_min_ps(a, b); }
+        inline Float4 Max(Float4 a, Float4 b) { return _mm_max_ps(a, b); }
+        // 1/sqrt(x), or 0 where x <= 0.
+        inline Float4 SafeInverseSqrt(Float4 x) {
+            __m128 mask = _mm_cmpgt_ps(x, _mm_setzero_ps());
+            return _mm_and_ps(mask, _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(x)));
+        }
+        inline void Extract(Float4 v, float * out) { _mm_storeu_ps(out, v); }
+
+        inline float Dot(Float4 a, Float4 b) {
+    #ifdef STARSURGE_SSE41
+            return _mm_cvtss_f32(_mm_dp_ps(a, b, 0xF1));
+    #else
+            __m128 m = _mm_mul_ps(a, b);
+            __m128 s = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2,3,0,1)));
+            s = _mm_add_ps(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1,0,3,2)));
+            return _mm_cvtss_f32(s);
+    #endif
+        }
+        inline Float4 Cross(Float4 a, Float4 b) {
+            __m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3,0,2,1));
+            __m128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3,0,2,1));
+            __m128 c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+            return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3,0,2,1));
+        }
+        // Hamilton product of two (x,y,z,w) quaternions.
+        inline Float4 QuaternionMultiply(Float4 a, Float4 b) {
+            const __m128 flipW = _mm_set_ps(-0.0f, 0.0f, 0.0f, 0.0f);
+            __m128 r = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3,3,3,3)), b);
+            __m128 t1 = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0,2,1,0)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(0,3,3,3)));
+            __m128 t2 = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1,0,2,1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1,1,0,2)));
+            __m128 t3 = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2,1,0,2)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(2,0,2,1)));
+            r = _mm_add_ps(r, _mm_xor_ps(_mm_add_ps(t1, t2), flipW));
+            return _mm_sub_ps(r, t3);
+        }
+        // Negates the lanes of v where s is negative.
+        inline Float4 FlipSign(Float4 v, Float4 s) {
+            return _mm_xor_ps(v, _mm_and_ps(s, _mm_set1_ps(-0.0f)));
+        }
+
+        // Turns four (x,y,z,w) rows into x, y, z and w columns, and back.
+        inline void Transpose4(Float4 & a, Float4 & b, Float4 & c, Float4 & d) {
+            _MM_TRANSPOSE4_PS(a, b, c, d);
+        }
+        // Loads four packed Vector3s (12 floats) as x, y and z columns.
+        inline void Deinterleave3(const float * p, Float4 & x, Float4 & y, Float4 & z) {
+            // a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+            __m128 a = _mm_loadu_ps(p);
+            __m128 b = _mm_loadu_ps(p + 4);
+            __m128 c = _mm_loadu_ps(p + 8);
+            x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1,1,2,2)), _MM_SHUFFLE(2,0,3,0));
+            y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0,0,1,1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2,2,3,3)), _MM_SHUFFLE(2,0,2,0));
+            z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1,1,2,2)), c, _MM_SHUFFLE(3,0,2,0));
+        }
+        inline void Interleave3(float * p, Float4 x, Float4 y, Float4 z) {
+            __m128 xy_lo = _mm_unpacklo_ps(x, y);
+            __m128 xy_hi = _mm_unpackhi_ps(x, y);
+            _mm_storeu_ps(p, _mm_shuffle_ps(xy_lo, _mm_shuffle_ps(z, x, _MM_SHUFFLE(1,1,0,0)), _MM_SHUFFLE(2,0,1,0)));
+            _mm_storeu_ps(p + 4, _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1,1,1,1)), xy_hi, _MM_SHUFFLE(1,0,2,0)));
+            _mm_storeu_ps(p + 8, _mm_shuffle_ps(_mm_shuffle_ps(z, xy_hi, _MM_SHUFFLE(2,2,2,2)), _mm_shuffle_ps(xy_hi, z, _MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(2,0,2,0)));
+        }
+#else
+        struct Float4 { float v[4]; };
+
+        inline Float4 Load3(const float * p) { return Float4{{ p[0], p[1], p[2], 0 }}; }
+        inline Float4 Load4(const float * p) { return Float4{{ p[0], p[1], p[2], p[3] }}; }
+        inline void Store3(float * p, Float4 v) { p[0] = v.v[0]; p[1] = v.v[1]; p[2] = v.v[2]; }
+        inline void Store4(float * p, Float4 v) { p[0] = v.v[0]; p[1] = v.v[1]; p[2] = v.v[2]; p[3] = v.v[3]; }
+
+        inline Float4 Splat(float s) { return Float4{{ s, s, s, s }}; }
+        inline Float4 Add(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) { a.v[i] += b.v[i]; } return a; }
+        inline Float4 Sub(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) { a.v[i] -= b.v[i]; } return a; }
+        inline Float4 Mul(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) { a.v[i] *= b.v[i]; } return a; }
+        inline Float4 Div(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) { a.v[i] /= b.v[i]; } return a; }
+        inline Float4 Abs(Float4 a) { for (int i = 0; i < 4; ++i) { a.v[i] = std::fabs(a.v[i]); } return a; }
+        inline Float4 Min(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) { a.v[i] = std::fmin(a.v[i], b.v[i]); } return a; }
+        inline Float4 Max(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) { a.v[i] = std::fmax(a.v[i], b.v[i]); } return a; }
+        inline Float4 SafeInverseSqrt(Float4 x) {
+            for (int i = 0; i < 4; ++i) { x.v[i] = (x.v[i] > 0) ? 1.0f / std::sqrt(x.v[i]) : 0; }
+            return x;
+        }
+        inline void Extract(Float4 v, float * out) { Store4(out, v); }
+
+        inline float Dot(Float4 a, Float4 b) { return a.v[0]*b.v[0] + a.v[1]*b.v[1] + a.v[2]*b.v[2] + a.v[3]*b.v[3]; }
+        inline Float4 Cross(Float4 a, Float4 b) {
+            return Float4{{ a.v[1]*b.v[2] - a.v[2]*b.v[1], a.v[2]*b.v[0] - a.v[0]*b.v[2], a.v[0]*b.v[1] - a.v[1]*b.v[0], 0 }};
+        }
+        inline Float4 QuaternionMultiply(Float4 a, Float4 b) {
+            return Float4{{
+                a.v[3]*b.v[0] + a.v[0]*b.v[3] + a.v[1]*b.v[2] - a.v[2]*b.v[1],
+                a.v[3]*b.v[1] - a.v[0]*b.v[2] + a.v[1]*b.v[3] + a.v[2]*b.v[0],
+                a.v[3]*b.v[2] + a.v[0]*b.v[1] - a.v[1]*b.v[0] + a.v[2]*b.v[3],
+                a.v[3]*b.v[3] - a.v[0]*b.v[0] - a.v[1]*b.v[1] - a.v[2]*b.v[2]
+            }};
+        }
+        inline Float4 FlipSign(Float4 v, Float4 s) {
+            for (int i = 0; i < 4; ++i) { v.v[i] = std::signbit(s.v[i]) ? -v.v[i] : v.v[i]; }
+            return v;
+        }
+
+        inline void Transpose4(Float4 & a, Float4 & b, Float4 & c, Float4 & d) {
+            Float4 rows[4] = { a, b, c, d };
+            for (int i = 0; i < 4; ++i) {
+                a.v[i] = rows[i].v[0];
+                b.v[i] = rows[i].v[1];
+                c.v[i] = rows[i].v[2];
+                d.v[i] = rows[i].v[3];
+            }
+        }
+        inline void Deinterleave3(const float * p, Float4 & x, Float4 & y, Float4 & z) {
+            for (int i = 0; i < 4; ++i) { x.v[i] = p[i*3]; y.v[i] = p[i*3+1]; z.v[i] = p[i*3+2]; }
+        }
+        inline void Interleave3(float * p, Float4 x, Float4 y, Float4 z) {
+            for (int i = 0; i < 4; ++i) { p[i*3] = x.v[i]; p[i*3+1] = y.v[i]; p[i*3+2] = z.v[i]; }
+        }
+#endif
+
+        // Loads/stores an N float array, where N is 3 or 4.
+        template<size_t N>
+        inline Float4 Load(const float * p) {
+            static_assert(N == 3 || N == 4, "SIMD loads only support 3 or 4 floats.");
+            if constexpr (N == 3) { return Load3(p); }
+            else { return Load4(p); }
+        }
+        template<size_t N>
+        inline void Store(float * p, Float4 v) {
+            static_assert(N == 3 || N == 4, "SIMD stores only support 3 or 4 floats.");
+            if constexpr (N == 3) { Store3(p, v); }
+            else { Store4(p, v); }
+        }
+    }
+}
@@ -2,6 +2,7 @@
 #include <vector>
 #include "Color.h"
 #include "Entity.h"
+#include "Matrix.h"
 
 namespace Starsurge {
     class Scene {
@@ -11,6 +12,9 @@ namespace Starsurge {
 
         void SetBgColor(Color t_bgcolor);
         Color GetBgColor();
+        // The camera's projection*view matrix, used for culling. Identity keeps the clip space cube.
+        void SetViewProjection(Matrix4 t_viewProjection);
+        Matrix4 GetViewProjection();
         void AddEntity(Entity * entity);
         Entity * FindEntity(std::string name);
 
@@ -28,6 +32,7 @@ namespace Starsurge {
 
     private:
         Color bgcolor;
+        Matrix4 viewProjection;
         std::vector<Entity*> entities;
     };
 }
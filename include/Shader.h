@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <map>
 #include <vector>
@@ -10,6 +11,12 @@ namespace Starsurge {
     };
     static unsigned int VALID_UNIFORM_TYPES_COUNT = 32;
 
+    // A uniform's value as the words its glUniform* call takes, so values of any type compare with memcmp.
+    // Unused words are zero.
+    struct UniformValue {
+        uint32_t Words[4];
+    };
+
     class Shader {
     public:
         Shader(std::string source_code);
@@ -20,8 +27,25 @@ namespace Starsurge {
         void Use();
 
         unsigned int GetProgram();
+
+        // Locations of the uniforms in GetUniforms() order, resolved once the program links. -1 for
+        // uniforms the compiler optimized out.
+        const std::vector<int> & GetUniformLocations();
+        // Bumped every time the program links, which makes older locations and uploads stale.
+        unsigned int GetGeneration();
+
+        // The program keeps the last value uploaded to each uniform, so materials sharing it only upload
+        // what differs. Returns true, and records value, when slot (an index into GetUniformLocations())
+        // doesn't have it yet.
+        bool ExchangeUniform(unsigned int slot, const UniformValue & value);
+        // Id of the material whose values were checked against the program last, 0 for none.
+        unsigned int GetLastApplied();
+        void SetLastApplied(unsigned int materialId);
+        // Sets _internal_OctahedralNormals when it changes. The program has to be in use.
+        void SetOctahedralNormals(bool enabled);
     private:
         void ParseUniforms();
+        void ResolveUniforms();
 
         std::string code;
         unsigned int shaderProgram;
@@ -29,6 +53,14 @@ namespace Starsurge {
         unsigned int fragmentShader;
         bool needs_recompiling;
         std::map<std::string, std::string> uniforms;
+
+        unsigned int generation = 0;
+        std::vector<int> locations;
+        std::vector<UniformValue> uploaded;
+        std::vector<bool> uploadedValid;
+        unsigned int lastApplied = 0;
+        int octahedralLocation = -1;
+        int octahedralNormals = -1;
     };
 
     namespace Shaders {
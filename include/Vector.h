@@ -1,28 +1,40 @@
 #pragma once
+#include <cmath>
 #include <string>
 #include <initializer_list>
 #include "Logging.h"
+#include "SIMD.h"
 
 namespace Starsurge {
+    template<typename E, size_t N>
+    class VectorExpression;
+
     template<size_t N>
     class Vector {
     public:
-        Vector(float t_val = 0) {
+        constexpr Vector(float t_val = 0) : data{} {
             for (size_t i = 0; i < N; ++i) {
                 this->data[i] = t_val;
             }
         }
-        Vector(const Vector<N>& other) {
+        constexpr Vector(const Vector<N>& other) : data{} {
             for (size_t i = 0; i < N; ++i) {
                 this->data[i] = other.data[i];
             }
         }
-        Vector(float t_data[N]) {
+        constexpr Vector(const float t_data[N]) : data{} {
             for (size_t i = 0; i < N; ++i) {
                 this->data[i] = t_data[i];
             }
         }
-        Vector(std::initializer_list<float> list) {
+        // Evaluates an expression from VectorExpression.h in a single pass.
+        template<typename E>
+        Vector(const VectorExpression<E, N>& expr) {
+            for (size_t i = 0; i < N; ++i) {
+                this->data[i] = expr[i];
+            }
+        }
+        constexpr Vector(std::initializer_list<float> list) : data{} {
             if (list.size() != N) {
                 Error("Not correct amount of data.");
                 for (size_t i = 0; i < N; ++i) {
@@ -37,10 +49,12 @@ namespace Starsurge {
             }
         }
 
-        size_t GetSize() const { return N; }
+        constexpr size_t GetSize() const { return N; }
+        const float * GetData() const { return this->data; }
+        float * GetData() { return this->data; }
 
         template <size_t M>
-        Vector<M> Resize() {
+        constexpr Vector<M> Resize() const {
             Vector<M> ret;
             for (size_t i = 0; i < M && i < N; ++i) {
                 ret[i] = this->data[i];
@@ -68,8 +82,13 @@ namespace Starsurge {
                 Error("Can't normalize zero vector.");
                 return;
             }
-            for (size_t i = 0; i < N; ++i) {
-                this->data[i] *= (1.0/mag);
+            if constexpr (IsSIMD) {
+                Store(SIMD::Mul(Load(), SIMD::Splat(1.0f/mag)));
+            }
+            else {
+                for (size_t i = 0; i < N; ++i) {
+                    this->data[i] *= (1.0/mag);
+                }
             }
         }
         Vector Unit() const {
@@ -79,20 +98,58 @@ namespace Starsurge {
         }
 
         static float Dot(const Vector<N>& lhs, const Vector<N>& rhs) {
+            if constexpr (IsSIMD) {
+                return SIMD::Dot(lhs.Load(), rhs.Load());
+            }
             float ret = 0;
             for (size_t i = 0; i < N; ++i) {
                 ret += lhs[i]*rhs[i];
             }
             return ret;
         }
-        static Vector<N> Basis(size_t i) {
+        static Vector<N> Min(const Vector<N>& lhs, const Vector<N>& rhs) {
+            Vector<N> ret;
+            if constexpr (IsSIMD) {
+                ret.Store(SIMD::Min(lhs.Load(), rhs.Load()));
+                return ret;
+            }
+            for (size_t i = 0; i < N; ++i) {
+                ret[i] = (lhs[i] < rhs[i]) ? lhs[i] : rhs[i];
+            }
+            return ret;
+        }
+        static Vector<N> Max(const Vector<N>& lhs, const Vector<N>& rhs) {
+            Vector<N> ret;
+            if constexpr (IsSIMD) {
+                ret.Store(SIMD::Max(lhs.Load(), rhs.Load()));
+                return ret;
+            }
+            for (size_t i = 0; i < N; ++i) {
+                ret[i] = (lhs[i] > rhs[i]) ? lhs[i] : rhs[i];
+            }
+            return ret;
+        }
+        // Linear interpolation, t = 0 gives a and t = 1 gives b.
+        static Vector<N> Lerp(const Vector<N>& a, const Vector<N>& b, float t) {
+            Vector<N> ret;
+            if constexpr (IsSIMD) {
+                SIMD::Float4 va = a.Load();
+                ret.Store(SIMD::Add(va, SIMD::Mul(SIMD::Sub(b.Load(), va), SIMD::Splat(t))));
+                return ret;
+            }
+            for (size_t i = 0; i < N; ++i) {
+                ret[i] = a[i] + (b[i] - a[i])*t;
+            }
+            return ret;
+        }
+        static constexpr Vector<N> Basis(size_t i) {
             Vector<N> ret;
             ret[i] = 1;
             return ret;
         }
 
         // Operators:
-        Vector<N>& operator=(const Vector<N>& other) {
+        constexpr Vector<N>& operator=(const Vector<N>& other) {
             if (this != &other) {
                 for (size_t i = 0; i < N; ++i) {
                     this->data[i] = other.data[i];
@@ -100,9 +157,20 @@ namespace Starsurge {
             }
             return *this;
         }
-        float operator [](int i) const { return this->data[i]; }
-        float & operator [](int i) { return this->data[i]; }
+        template<typename E>
+        Vector<N>& operator=(const VectorExpression<E, N>& expr) {
+            for (size_t i = 0; i < N; ++i) {
+                this->data[i] = expr[i];
+            }
+            return *this;
+        }
+        constexpr float operator [](int i) const { return this->data[i]; }
+        constexpr float & operator [](int i) { return this->data[i]; }
         Vector<N>& operator+=(const Vector<N>& rhs) {
+            if constexpr (IsSIMD) {
+                Store(SIMD::Add(Load(), rhs.Load()));
+                return *this;
+            }
             for (size_t i=0; i < N; ++i) {
                 this->data[i] += rhs[i];
             }
@@ -110,6 +178,10 @@ namespace Starsurge {
         }
         friend Vector<N> operator+(Vector<N> lhs, const Vector<N>& rhs) { return lhs += rhs; }
         Vector<N>& operator-=(const Vector<N>& rhs) {
+            if constexpr (IsSIMD) {
+                Store(SIMD::Sub(Load(), rhs.Load()));
+                return *this;
+            }
             for (size_t i=0; i < N; ++i) {
                 this->data[i] -= rhs[i];
             }
@@ -119,51 +191,70 @@ namespace Starsurge {
         friend bool operator==(const Vector<N>& lhs, const Vector<N>& rhs) { return lhs.data == rhs.data; }
         friend bool operator!=(const Vector<N>& lhs, const Vector<N>& rhs) { return !(lhs == rhs); }
     protected:
-        float data[N];
+        // Vector3 and Vector4 run through SIMD registers. Vector4 is 16 byte aligned, Vector3 stays tightly
+        // packed (12 bytes) so it can sit inside GPU vertex layouts.
+        static constexpr bool IsSIMD = (N == 3 || N == 4);
+        SIMD::Float4 Load() const { return SIMD::Load<N>(this->data); }
+        void Store(SIMD::Float4 v) { SIMD::Store<N>(this->data, v); }
+
+        alignas(N == 4 ? 16 : alignof(float)) float data[N];
     };
 
     class Vector2 : public Vector<2> {
     public:
-        Vector2(float t_val = 0) : Vector<2>(t_val) {}
-        Vector2(const Vector<2>& other) : Vector<2>(other) {}
-        Vector2(float t_data[2]) : Vector<2>(t_data) {}
-        Vector2(std::initializer_list<float> list) : Vector<2>(list) {}
-        Vector2(float x, float y) {
+        constexpr Vector2(float t_val = 0) : Vector<2>(t_val) {}
+        constexpr Vector2(const Vector<2>& other) : Vector<2>(other) {}
+        constexpr Vector2(const float t_data[2]) : Vector<2>(t_data) {}
+        constexpr Vector2(std::initializer_list<float> list) : Vector<2>(list) {}
+        constexpr Vector2(float x, float y) : Vector<2>() {
             this->data[0] = x;
             this->data[1] = y;
         }
+        template<typename E>
+        Vector2(const VectorExpression<E, 2>& expr) : Vector<2>(expr) {}
+        using Vector<2>::operator=;
 
         static float Dot(Vector2 a, Vector2 b) { return Vector<2>::Dot(a, b); }
     };
 
     class Vector3 : public Vector<3> {
     public:
-        Vector3(float t_val = 0) : Vector<3>(t_val) {}
-        Vector3(const Vector<3>& other) : Vector<3>(other) {}
-        Vector3(float t_data[3]) : Vector<3>(t_data) {}
-        Vector3(std::initializer_list<float> list) : Vector<3>(list) {}
-        Vector3(float x, float y, float z) {
+        constexpr Vector3(float t_val = 0) : Vector<3>(t_val) {}
+        constexpr Vector3(const Vector<3>& other) : Vector<3>(other) {}
+        constexpr Vector3(const float t_data[3]) : Vector<3>(t_data) {}
+        constexpr Vector3(std::initializer_list<float> list) : Vector<3>(list) {}
+        constexpr Vector3(float x, float y, float z) : Vector<3>() {
             this->data[0] = x;
             this->data[1] = y;
             this->data[2] = z;
         }
+        template<typename E>
+        Vector3(const VectorExpression<E, 3>& expr) : Vector<3>(expr) {}
+        using Vector<3>::operator=;
 
         static float Dot(Vector3 a, Vector3 b) { return Vector<3>::Dot(a, b); }
-        static Vector3 CrossProduct(Vector3 a, Vector3 b);
+        static Vector3 CrossProduct(const Vector3& a, const Vector3& b) {
+            Vector3 ret;
+            ret.Store(SIMD::Cross(a.Load(), b.Load()));
+            return ret;
+        }
     };
 
     class Vector4 : public Vector<4> {
     public:
-        Vector4(float t_val = 0) : Vector<4>(t_val) {}
-        Vector4(const Vector<4>& other) : Vector<4>(other) {}
-        Vector4(float t_data[4]) : Vector<4>(t_data) {}
-        Vector4(std::initializer_list<float> list) : Vector<4>(list) {}
-        Vector4(float x, float y, float z, float w) {
+        constexpr Vector4(float t_val = 0) : Vector<4>(t_val) {}
+        constexpr Vector4(const Vector<4>& other) : Vector<4>(other) {}
+        constexpr Vector4(const float t_data[4]) : Vector<4>(t_data) {}
+        constexpr Vector4(std::initializer_list<float> list) : Vector<4>(list) {}
+        constexpr Vector4(float x, float y, float z, float w) : Vector<4>() {
             this->data[0] = x;
             this->data[1] = y;
             this->data[2] = z;
             this->data[3] = w;
         }
+        template<typename E>
+        Vector4(const VectorExpression<E, 4>& expr) : Vector<4>(expr) {}
+        using Vector<4>::operator=;
 
         static float Dot(Vector4 a, Vector4 b) { return Vector<4>::Dot(a, b); }
     };
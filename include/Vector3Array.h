@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+#include "AlignedAllocator.h"
+#include "CPUDispatch.h"
+#include "Vector.h"
+#include "Matrix.h"
+
+namespace Starsurge {
+    struct Vertex;
+
+    // Structure-of-arrays storage for a batch of Vector3s: all x's, then all y's, then all z's. Each
+    // component array is 64 byte aligned and zero padded to a multiple of LANES so the bulk kernels
+    // never need a scalar tail.
+    class Vector3Array {
+    public:
+        static constexpr size_t LANES = BATCH_KERNEL_PADDING;
+        typedef std::vector<float, AlignedAllocator<float, 64>> ComponentArray;
+
+        Vector3Array() : count(0) {}
+        Vector3Array(size_t t_count);
+        Vector3Array(const std::vector<Vector3>& vectors);
+
+        size_t GetSize() const { return this->count; }
+        void Resize(size_t t_count);
+        void Clear();
+        void PushBack(const Vector3& v);
+        Vector3 Get(size_t i) const { return Vector3(this->x[i], this->y[i], this->z[i]); }
+        void Set(size_t i, const Vector3& v) {
+            this->x[i] = v[0];
+            this->y[i] = v[1];
+            this->z[i] = v[2];
+        }
+
+        float * X() { return this->x.data(); }
+        float * Y() { return this->y.data(); }
+        float * Z() { return this->z.data(); }
+        const float * X() const { return this->x.data(); }
+        const float * Y() const { return this->y.data(); }
+        const float * Z() const { return this->z.data(); }
+
+        // Gathers/scatters Vertex::Position in one pass, without an intermediate AoS copy.
+        void LoadPositions(const std::vector<Vertex>& vertices);
+        void StorePositions(std::vector<Vertex>& vertices) const;
+        std::vector<Vector3> ToVector() const;
+
+        // Bulk kernels, all element-wise. These run on whichever instruction set GetBatchKernels() picked.
+        void Add(const Vector3Array& other);
+        void Add(const Vector3& offset);
+        void Scale(float s);
+        void Scale(const Vector3& s);
+        // Zero length vectors are left as zero.
+        void Normalize();
+        // Treats every element as a point (w = 1).
+        void Transform(const Matrix4& m);
+        void MinMax(Vector3 & min, Vector3 & max) const;
+
+        static void Dot(const Vector3Array& a, const Vector3Array& b, std::vector<float>& out);
+        static void Cross(const Vector3Array& a, const Vector3Array& b, Vector3Array& out);
+    private:
+        size_t PaddedSize() const { return this->x.size(); }
+
+        size_t count;
+        ComponentArray x;
+        ComponentArray y;
+        ComponentArray z;
+    };
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include "Vector.h"
+
+// Opt-in expression templates for Vector<N>. Wrapping an operand in Lazy() makes the arithmetic build a
+// tree of expression nodes instead of temporaries; the whole tree is evaluated in one loop when it is
+// assigned to a Vector:
+//
+//     Vector3 velocity = Lazy(a) + b - Lazy(c)*dt;
+//
+// Nodes hold references to the vectors they were built from, so don't store them past the statement.
+namespace Starsurge {
+    template<typename E, size_t N>
+    class VectorExpression {
+    public:
+        float operator[](size_t i) const { return static_cast<const E&>(*this)[i]; }
+        size_t GetSize() const { return N; }
+
+        Vector<N> Evaluate() const { return Vector<N>(*this); }
+    };
+
+    template<size_t N>
+    class VectorTerminal : public VectorExpression<VectorTerminal<N>, N> {
+    public:
+        VectorTerminal(const Vector<N>& t_vec) : vec(t_vec) {}
+        float operator[](size_t i) const { return this->vec[i]; }
+    private:
+        const Vector<N>& vec;
+    };
+
+    template<typename L, typename R, size_t N, typename Op>
+    class VectorBinaryExpression : public VectorExpression<VectorBinaryExpression<L, R, N, Op>, N> {
+    public:
+        VectorBinaryExpression(const L& t_lhs, const R& t_rhs) : lhs(t_lhs), rhs(t_rhs) {}
+        float operator[](size_t i) const { return Op::Apply(this->lhs[i], this->rhs[i]); }
+    private:
+        const L lhs;
+        const R rhs;
+    };
+
+    template<typename E, size_t N>
+    class VectorScaleExpression : public VectorExpression<VectorScaleExpression<E, N>, N> {
+    public:
+        VectorScaleExpression(const E& t_expr, float t_scale) : expr(t_expr), scale(t_scale) {}
+        float operator[](size_t i) const { return this->expr[i]*this->scale; }
+    private:
+        const E expr;
+        const float scale;
+    };
+
+    namespace ExpressionOps {
+        struct Add { static float Apply(float a, float b) { return a + b; } };
+        struct Sub { static float Apply(float a, float b) { return a - b; } };
+        struct Mul { static float Apply(float a, float b) { return a * b; } };
+    }
+
+    template<size_t N>
+    VectorTerminal<N> Lazy(const Vector<N>& vec) { return VectorTerminal<N>(vec); }
+
+    // Expression (op) expression
+    template<typename L, typename R, size_t N>
+    VectorBinaryExpression<L, R, N, ExpressionOps::Add> operator+(const VectorExpression<L, N>& lhs, const VectorExpression<R, N>& rhs) {
+        return VectorBinaryExpression<L, R, N, ExpressionOps::Add>(static_cast<const L&>(lhs), static_cast<const R&>(rhs));
+    }
+    template<typename L, typename R, size_t N>
+    VectorBinaryExpression<L, R, N, ExpressionOps::Sub> operator-(const VectorExpression<L, N>& lhs, const VectorExpression<R, N>& rhs) {
+        return VectorBinaryExpression<L, R, N, ExpressionOps::Sub>(static_cast<const L&>(lhs), static_cast<const R&>(rhs));
+    }
+    // Component-wise product.
+    template<typename L, typename R, size_t N>
+    VectorBinaryExpression<L, R, N, ExpressionOps::Mul> operator*(const VectorExpression<L, N>& lhs, const VectorExpression<R, N>& rhs) {
+        return VectorBinaryExpression<L, R, N, ExpressionOps::Mul>(static_cast<const L&>(lhs), static_cast<const R&>(rhs));
+    }
+
+    // Expression (op) vector and vector (op) expression
+    template<typename L, size_t N>
+    auto operator+(const VectorExpression<L, N>& lhs, const Vector<N>& rhs) { return lhs + Lazy(rhs); }
+    template<typename R, size_t N>
+    auto operator+(const Vector<N>& lhs, const VectorExpression<R, N>& rhs) { return Lazy(lhs) + rhs; }
+    template<typename L, size_t N>
+    auto operator-(const VectorExpression<L, N>& lhs, const Vector<N>& rhs) { return lhs - Lazy(rhs); }
+    template<typename R, size_t N>
+    auto operator-(const Vector<N>& lhs, const VectorExpression<R, N>& rhs) { return Lazy(lhs) - rhs; }
+    template<typename L, size_t N>
+    auto operator*(const VectorExpression<L, N>& lhs, const Vector<N>& rhs) { return lhs * Lazy(rhs); }
+    template<typename R, size_t N>
+    auto operator*(const Vector<N>& lhs, const VectorExpression<R, N>& rhs) { return Lazy(lhs) * rhs; }
+
+    // Scaling
+    template<typename E, size_t N>
+    VectorScaleExpression<E, N> operator*(const VectorExpression<E, N>& expr, float scale) {
+        return VectorScaleExpression<E, N>(static_cast<const E&>(expr), scale);
+    }
+    template<typename E, size_t N>
+    VectorScaleExpression<E, N> operator*(float scale, const VectorExpression<E, N>& expr) {
+        return VectorScaleExpression<E, N>(static_cast<const E&>(expr), scale);
+    }
+    template<typename E, size_t N>
+    VectorScaleExpression<E, N> operator/(const VectorExpression<E, N>& expr, float scale) {
+        return VectorScaleExpression<E, N>(static_cast<const E&>(expr), 1.0f/scale);
+    }
+    template<typename E, size_t N>
+    VectorScaleExpression<E, N> operator-(const VectorExpression<E, N>& expr) {
+        return VectorScaleExpression<E, N>(static_cast<const E&>(expr), -1.0f);
+    }
+
+    template<typename E, size_t N>
+    float Dot(const VectorExpression<E, N>& lhs, const Vector<N>& rhs) {
+        float ret = 0;
+        for (size_t i = 0; i < N; ++i) {
+            ret += lhs[i]*rhs[i];
+        }
+        return ret;
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+
+namespace Starsurge {
+    enum class PositionEncoding { Float, Half };
+    enum class NormalEncoding { Float, Octahedral };
+    // UNorm16 clamps to [0,1], use Half for tiling UVs.
+    enum class UVEncoding { Float, Half, UNorm16 };
+    // Colors are 0-255 in every encoding, the shader prelude scales them to 0-1.
+    enum class ColorEncoding { Float, UNorm8 };
+
+    // How a Mesh lays its vertices out on the GPU. The Vertex array on the CPU is always full floats.
+    struct VertexFormat {
+        PositionEncoding Position;
+        NormalEncoding Normal;
+        UVEncoding UV;
+        ColorEncoding Color;
+
+        // 48 bytes, 12 floats.
+        static constexpr VertexFormat Full() {
+            return { PositionEncoding::Float, NormalEncoding::Float, UVEncoding::Float, ColorEncoding::Float };
+        }
+        // 20 bytes: half positions, octahedral SNORM16 normals, UNORM16 UVs and RGBA8 color.
+        static constexpr VertexFormat Compact() {
+            return { PositionEncoding::Half, NormalEncoding::Octahedral, UVEncoding::UNorm16, ColorEncoding::UNorm8 };
+        }
+
+        // False when the GPU layout is the Vertex struct itself and vertices upload without a copy.
+        bool NeedsConversion() const;
+        size_t GetStride() const;
+        // Points attributes 0-3 at the bound GL_ARRAY_BUFFER and enables them, on the bound VAO.
+        void SetupAttributes() const;
+
+        bool operator==(const VertexFormat & other) const {
+            return this->Position == other.Position && this->Normal == other.Normal &&
+                this->UV == other.UV && this->Color == other.Color;
+        }
+        bool operator!=(const VertexFormat & other) const { return !(*this == other); }
+    };
+}
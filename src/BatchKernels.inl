@@ -0,0 +1,173 @@
+// Batch kernels written once against a "lanes" type and included by each BatchKernels*.cpp, which
+// provides `struct Lanes` for its instruction set before including this file. A Lanes type has:
+//
+//     V, Width, Load, Store, Splat, Add, Sub, Mul, MulAdd (a*b+c), Min, Max, SafeInverseSqrt,
+//     ReduceMin, ReduceMax
+//
+// These translation units are compiled with ISA specific flags, so they must not call inline functions
+// from engine or standard headers (the linker could keep the AVX copy for everyone). Stick to the
+// lanes type and plain arithmetic.
+
+namespace {
+    typedef Lanes L;
+
+    void KernelAdd(float * x, float * y, float * z, const float * ox, const float * oy, const float * oz, size_t count) {
+        for (size_t i = 0; i < count; i += L::Width) {
+            L::Store(x+i, L::Add(L::Load(x+i), L::Load(ox+i)));
+            L::Store(y+i, L::Add(L::Load(y+i), L::Load(oy+i)));
+            L::Store(z+i, L::Add(L::Load(z+i), L::Load(oz+i)));
+        }
+    }
+
+    void KernelOffset(float * x, float * y, float * z, float ox, float oy, float oz, size_t count) {
+        L::V vx = L::Splat(ox), vy = L::Splat(oy), vz = L::Splat(oz);
+        for (size_t i = 0; i < count; i += L::Width) {
+            L::Store(x+i, L::Add(L::Load(x+i), vx));
+            L::Store(y+i, L::Add(L::Load(y+i), vy));
+            L::Store(z+i, L::Add(L::Load(z+i), vz));
+        }
+    }
+
+    void KernelScale(float * x, float * y, float * z, float sx, float sy, float sz, size_t count) {
+        L::V vx = L::Splat(sx), vy = L::Splat(sy), vz = L::Splat(sz);
+        for (size_t i = 0; i < count; i += L::Width) {
+            L::Store(x+i, L::Mul(L::Load(x+i), vx));
+            L::Store(y+i, L::Mul(L::Load(y+i), vy));
+            L::Store(z+i, L::Mul(L::Load(z+i), vz));
+        }
+    }
+
+    void KernelNormalize(float * x, float * y, float * z, size_t count) {
+        for (size_t i = 0; i < count; i += L::Width) {
+            L::V vx = L::Load(x+i), vy = L::Load(y+i), vz = L::Load(z+i);
+            L::V inv = L::SafeInverseSqrt(L::MulAdd(vz, vz, L::MulAdd(vy, vy, L::Mul(vx, vx))));
+            L::Store(x+i, L::Mul(vx, inv));
+            L::Store(y+i, L::Mul(vy, inv));
+            L::Store(z+i, L::Mul(vz, inv));
+        }
+    }
+
+    void KernelTransform(float * x, float * y, float * z, const float * m, size_t count) {
+        // Column-major, m[col*4 + row].
+        L::V m00 = L::Splat(m[0]), m01 = L::Splat(m[4]), m02 = L::Splat(m[8]), m03 = L::Splat(m[12]);
+        L::V m10 = L::Splat(m[1]), m11 = L::Splat(m[5]), m12 = L::Splat(m[9]), m13 = L::Splat(m[13]);
+        L::V m20 = L::Splat(m[2]), m21 = L::Splat(m[6]), m22 = L::Splat(m[10]), m23 = L::Splat(m[14]);
+        for (size_t i = 0; i < count; i += L::Width) {
+            L::V vx = L::Load(x+i), vy = L::Load(y+i), vz = L::Load(z+i);
+            L::Store(x+i, L::MulAdd(m02, vz, L::MulAdd(m01, vy, L::MulAdd(m00, vx, m03))));
+            L::Store(y+i, L::MulAdd(m12, vz, L::MulAdd(m11, vy, L::MulAdd(m10, vx, m13))));
+            L::Store(z+i, L::MulAdd(m22, vz, L::MulAdd(m21, vy, L::MulAdd(m20, vx, m23))));
+        }
+    }
+
+    void KernelDot(const float * ax, const float * ay, const float * az, const float * bx, const float * by, const float * bz, float * out, size_t count) {
+        for (size_t i = 0; i < count; i += L::Width) {
+            L::V d = L::Mul(L::Load(ax+i), L::Load(bx+i));
+            d = L::MulAdd(L::Load(ay+i), L::Load(by+i), d);
+            d = L::MulAdd(L::Load(az+i), L::Load(bz+i), d);
+            L::Store(out+i, d);
+        }
+    }
+
+    void KernelCross(const float * ax, const float * ay, const float * az, const float * bx, const float * by, const float * bz, float * ox, float * oy, float * oz, size_t count) {
+        for (size_t i = 0; i < count; i += L::Width) {
+            L::V vax = L::Load(ax+i), vay = L::Load(ay+i), vaz = L::Load(az+i);
+            L::V vbx = L::Load(bx+i), vby = L::Load(by+i), vbz = L::Load(bz+i);
+            L::Store(ox+i, L::Sub(L::Mul(vay, vbz), L::Mul(vaz, vby)));
+            L::Store(oy+i, L::Sub(L::Mul(vaz, vbx), L::Mul(vax, vbz)));
+            L::Store(oz+i, L::Sub(L::Mul(vax, vby), L::Mul(vay, vbx)));
+        }
+    }
+
+    void KernelMinMax(const float * x, const float * y, const float * z, size_t count, float * min, float * max) {
+        // Seed every lane with the first element so partial vectors never need masking.
+        L::V minX = L::Splat(x[0]), minY = L::Splat(y[0]), minZ = L::Splat(z[0]);
+        L::V maxX = minX, maxY = minY, maxZ = minZ;
+        size_t i = 0;
+        for (; i + L::Width <= count; i += L::Width) {
+            L::V vx = L::Load(x+i), vy = L::Load(y+i), vz = L::Load(z+i);
+            minX = L::Min(minX, vx); maxX = L::Max(maxX, vx);
+            minY = L::Min(minY, vy); maxY = L::Max(maxY, vy);
+            minZ = L::Min(minZ, vz); maxZ = L::Max(maxZ, vz);
+        }
+        min[0] = L::ReduceMin(minX); min[1] = L::ReduceMin(minY); min[2] = L::ReduceMin(minZ);
+        max[0] = L::ReduceMax(maxX); max[1] = L::ReduceMax(maxY); max[2] = L::ReduceMax(maxZ);
+        for (; i < count; ++i) {
+            if (x[i] < min[0]) { min[0] = x[i]; }
+            if (y[i] < min[1]) { min[1] = y[i]; }
+            if (z[i] < min[2]) { min[2] = z[i]; }
+            if (x[i] > max[0]) { max[0] = x[i]; }
+            if (y[i] > max[1]) { max[1] = y[i]; }
+            if (z[i] > max[2]) { max[2] = z[i]; }
+        }
+    }
+
+    void KernelCullSpheres(const float * planes, size_t planeCount, const float * x, const float * y, const float * z, const float * radius, size_t count, unsigned char * visible) {
+        // A sphere survives a plane when dot(n, c) + d + r >= 0. Track the worst plane per sphere.
+        float worst[L::Width];
+        size_t i = 0;
+        for (; i + L::Width <= count; i += L::Width) {
+            L::V vx = L::Load(x+i), vy = L::Load(y+i), vz = L::Load(z+i), vr = L::Load(radius+i);
+            L::V minDist = L::Splat(0);
+            for (size_t p = 0; p < planeCount; ++p) {
+                const float * plane = planes + p*4;
+                L::V dist = L::MulAdd(L::Splat(plane[2]), vz, L::MulAdd(L::Splat(plane[1]), vy, L::MulAdd(L::Splat(plane[0]), vx, L::Add(L::Splat(plane[3]), vr))));
+                minDist = L::Min(minDist, dist);
+            }
+            L::Store(worst, minDist);
+            for (size_t lane = 0; lane < L::Width; ++lane) {
+                visible[i+lane] = (worst[lane] >= 0) ? 1 : 0;
+            }
+        }
+        for (; i < count; ++i) {
+            unsigned char inside = 1;
+            for (size_t p = 0; p < planeCount; ++p) {
+                const float * plane = planes + p*4;
+                if (plane[0]*x[i] + plane[1]*y[i] + plane[2]*z[i] + plane[3] + radius[i] < 0) {
+                    inside = 0;
+                    break;
+                }
+            }
+            visible[i] = inside;
+        }
+    }
+
+    void KernelPackVertices(const float * in, float * out, size_t count) {
+        // Vertices are 12 floats and the last 4 (color) get scaled. A run of lcm(12, Width) floats
+        // always lines up with whole vertices, so one pattern of multipliers covers every run.
+        const size_t GROUP_FLOATS = (L::Width == 1) ? 12 : 3*L::Width;
+        const size_t GROUP_VERTICES = GROUP_FLOATS / 12;
+        float pattern[(L::Width == 1) ? 12 : 3*L::Width];
+        for (size_t j = 0; j < GROUP_FLOATS; ++j) {
+            pattern[j] = (j % 12 >= 8) ? (1.0f / 255.0f) : 1.0f;
+        }
+
+        size_t v = 0;
+        for (; v + GROUP_VERTICES <= count; v += GROUP_VERTICES) {
+            const float * src = in + v*12;
+            float * dst = out + v*12;
+            for (size_t j = 0; j < GROUP_FLOATS; j += L::Width) {
+                L::Store(dst+j, L::Mul(L::Load(src+j), L::Load(pattern+j)));
+            }
+        }
+        for (; v < count; ++v) {
+            for (size_t j = 0; j < 12; ++j) {
+                out[v*12+j] = in[v*12+j] * pattern[j];
+            }
+        }
+    }
+
+    const Starsurge::BatchKernels KERNELS = {
+        LEVEL,
+        KernelAdd,
+        KernelOffset,
+        KernelScale,
+        KernelNormalize,
+        KernelTransform,
+        KernelDot,
+        KernelCross,
+        KernelMinMax,
+        KernelCullSpheres,
+        KernelPackVertices
+    };
+}
@@ -0,0 +1,55 @@
+#include "../include/CPUDispatch.h"
+
+// Built with -mavx2 -mfma (or /arch:AVX2), see src/CMakeLists.txt.
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace {
+    const Starsurge::SIMDLevel LEVEL = Starsurge::SIMDLevel::AVX2;
+
+    struct Lanes {
+        typedef __m256 V;
+        static const size_t Width = 8;
+
+        static V Load(const float * p) { return _mm256_loadu_ps(p); }
+        static void Store(float * p, V v) { _mm256_storeu_ps(p, v); }
+        static V Splat(float s) { return _mm256_set1_ps(s); }
+        static V Add(V a, V b) { return _mm256_add_ps(a, b); }
+        static V Sub(V a, V b) { return _mm256_sub_ps(a, b); }
+        static V Mul(V a, V b) { return _mm256_mul_ps(a, b); }
+#if defined(__FMA__)
+        static V MulAdd(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+#else
+        static V MulAdd(V a, V b, V c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+#endif
+        static V Min(V a, V b) { return _mm256_min_ps(a, b); }
+        static V Max(V a, V b) { return _mm256_max_ps(a, b); }
+        static V SafeInverseSqrt(V x) {
+            __m256 mask = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_GT_OQ);
+            return _mm256_and_ps(mask, _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(x)));
+        }
+        static float ReduceMin(V v) {
+            __m128 m = _mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2,3,0,1)));
+            m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1,0,3,2)));
+            return _mm_cvtss_f32(m);
+        }
+        static float ReduceMax(V v) {
+            __m128 m = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            m = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2,3,0,1)));
+            m = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1,0,3,2)));
+            return _mm_cvtss_f32(m);
+        }
+    };
+}
+
+#include "BatchKernels.inl"
+
+const Starsurge::BatchKernels * Starsurge::GetAVX2Kernels() {
+    return &KERNELS;
+}
+#else
+const Starsurge::BatchKernels * Starsurge::GetAVX2Kernels() {
+    return NULL;
+}
+#endif
@@ -0,0 +1,41 @@
+#include "../include/CPUDispatch.h"
+
+// Built with -mavx512f (or /arch:AVX512), see src/CMakeLists.txt.
+#if defined(__AVX512F__)
+#include <immintrin.h>
+
+namespace {
+    const Starsurge::SIMDLevel LEVEL = Starsurge::SIMDLevel::AVX512;
+
+    struct Lanes {
+        typedef __m512 V;
+        static const size_t Width = 16;
+
+        static V Load(const float * p) { return _mm512_loadu_ps(p); }
+        static void Store(float * p, V v) { _mm512_storeu_ps(p, v); }
+        static V Splat(float s) { return _mm512_set1_ps(s); }
+        static V Add(V a, V b) { return _mm512_add_ps(a, b); }
+        static V Sub(V a, V b) { return _mm512_sub_ps(a, b); }
+        static V Mul(V a, V b) { return _mm512_mul_ps(a, b); }
+        static V MulAdd(V a, V b, V c) { return _mm512_fmadd_ps(a, b, c); }
+        static V Min(V a, V b) { return _mm512_min_ps(a, b); }
+        static V Max(V a, V b) { return _mm512_max_ps(a, b); }
+        static V SafeInverseSqrt(V x) {
+            __mmask16 mask = _mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_GT_OQ);
+            return _mm512_maskz_div_ps(mask, _mm512_set1_ps(1.0f), _mm512_sqrt_ps(x));
+        }
+        static float ReduceMin(V v) { return _mm512_reduce_min_ps(v); }
+        static float ReduceMax(V v) { return _mm512_reduce_max_ps(v); }
+    };
+}
+
+#include "BatchKernels.inl"
+
+const Starsurge::BatchKernels * Starsurge::GetAVX512Kernels() {
+    return &KERNELS;
+}
+#else
+const Starsurge::BatchKernels * Starsurge::GetAVX512Kernels() {
+    return NULL;
+}
+#endif
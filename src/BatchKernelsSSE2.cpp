@@ -0,0 +1,48 @@
+#include "../include/CPUDispatch.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+
+namespace {
+    const Starsurge::SIMDLevel LEVEL = Starsurge::SIMDLevel::SSE2;
+
+    struct Lanes {
+        typedef __m128 V;
+        static const size_t Width = 4;
+
+        static V Load(const float * p) { return _mm_loadu_ps(p); }
+        static void Store(float * p, V v) { _mm_storeu_ps(p, v); }
+        static V Splat(float s) { return _mm_set1_ps(s); }
+        static V Add(V a, V b) { return _mm_add_ps(a, b); }
+        static V Sub(V a, V b) { return _mm_sub_ps(a, b); }
+        static V Mul(V a, V b) { return _mm_mul_ps(a, b); }
+        static V MulAdd(V a, V b, V c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+        static V Min(V a, V b) { return _mm_min_ps(a, b); }
+        static V Max(V a, V b) { return _mm_max_ps(a, b); }
+        static V SafeInverseSqrt(V x) {
+            __m128 mask = _mm_cmpgt_ps(x, _mm_setzero_ps());
+            return _mm_and_ps(mask, _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(x)));
+        }
+        static float ReduceMin(V v) {
+            v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2,3,0,1)));
+            v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1,0,3,2)));
+            return _mm_cvtss_f32(v);
+        }
+        static float ReduceMax(V v) {
+            v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2,3,0,1)));
+            v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1,0,3,2)));
+            return _mm_cvtss_f32(v);
+        }
+    };
+}
+
+#include "BatchKernels.inl"
+
+const Starsurge::BatchKernels * Starsurge::GetSSE2Kernels() {
+    return &KERNELS;
+}
+#else
+const Starsurge::BatchKernels * Starsurge::GetSSE2Kernels() {
+    return NULL;
+}
+#endif
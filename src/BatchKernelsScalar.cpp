@@ -0,0 +1,30 @@
+#include <cmath>
+#include "../include/CPUDispatch.h"
+
+namespace {
+    const Starsurge::SIMDLevel LEVEL = Starsurge::SIMDLevel::Scalar;
+
+    struct Lanes {
+        typedef float V;
+        static const size_t Width = 1;
+
+        static V Load(const float * p) { return *p; }
+        static void Store(float * p, V v) { *p = v; }
+        static V Splat(float s) { return s; }
+        static V Add(V a, V b) { return a + b; }
+        static V Sub(V a, V b) { return a - b; }
+        static V Mul(V a, V b) { return a * b; }
+        static V MulAdd(V a, V b, V c) { return a * b + c; }
+        static V Min(V a, V b) { return (a < b) ? a : b; }
+        static V Max(V a, V b) { return (a > b) ? a : b; }
+        static V SafeInverseSqrt(V x) { return (x > 0) ? 1.0f / std::sqrt(x) : 0; }
+        static float ReduceMin(V v) { return v; }
+        static float ReduceMax(V v) { return v; }
+    };
+}
+
+#include "BatchKernels.inl"
+
+const Starsurge::BatchKernels * Starsurge::GetScalarKernels() {
+    return &KERNELS;
+}
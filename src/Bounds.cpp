@@ -0,0 +1,60 @@
+#include "../include/Bounds.h"
+
+Starsurge::Vector3 Starsurge::AABB::GetCenter() const {
+    return Vector3::Lerp(this->Min, this->Max, 0.5f);
+}
+
+Starsurge::Vector3 Starsurge::AABB::GetExtents() const {
+    Vector3 ret = this->Max - this->Min;
+    return Vector3(ret[0]*0.5f, ret[1]*0.5f, ret[2]*0.5f);
+}
+
+bool Starsurge::AABB::Contains(const Vector3& point) const {
+    return point[0] >= this->Min[0] && point[0] <= this->Max[0] &&
+        point[1] >= this->Min[1] && point[1] <= this->Max[1] &&
+        point[2] >= this->Min[2] && point[2] <= this->Max[2];
+}
+
+bool Starsurge::AABB::Intersects(const AABB& other) const {
+    return this->Min[0] <= other.Max[0] && this->Max[0] >= other.Min[0] &&
+        this->Min[1] <= other.Max[1] && this->Max[1] >= other.Min[1] &&
+        this->Min[2] <= other.Max[2] && this->Max[2] >= other.Min[2];
+}
+
+Starsurge::AABB Starsurge::AABB::Transform(const Matrix4& m) const {
+    // Arvo: transform the center, and take the extents through the absolute value of the 3x3 part.
+    Vector3 center = m.TransformPoint(GetCenter());
+    Vector3 extents = GetExtents();
+    const float * cols = m.GetData();
+    SIMD::Float4 e = SIMD::Mul(SIMD::Abs(SIMD::Load3(cols)), SIMD::Splat(extents[0]));
+    e = SIMD::Add(e, SIMD::Mul(SIMD::Abs(SIMD::Load3(cols+4)), SIMD::Splat(extents[1])));
+    e = SIMD::Add(e, SIMD::Mul(SIMD::Abs(SIMD::Load3(cols+8)), SIMD::Splat(extents[2])));
+    SIMD::Float4 c = SIMD::Load3(center.GetData());
+    AABB ret;
+    SIMD::Store3(ret.Min.GetData(), SIMD::Sub(c, e));
+    SIMD::Store3(ret.Max.GetData(), SIMD::Add(c, e));
+    return ret;
+}
+
+Starsurge::AABB Starsurge::AABB::Merge(const AABB& a, const AABB& b) {
+    return AABB(Vector3::Min(a.Min, b.Min), Vector3::Max(a.Max, b.Max));
+}
+
+bool Starsurge::BoundingSphere::Contains(const Vector3& point) const {
+    Vector3 d = point - this->Center;
+    return Vector3::Dot(d, d) <= this->Radius*this->Radius;
+}
+
+bool Starsurge::BoundingSphere::Intersects(const BoundingSphere& other) const {
+    Vector3 d = other.Center - this->Center;
+    float r = this->Radius + other.Radius;
+    return Vector3::Dot(d, d) <= r*r;
+}
+
+Starsurge::BoundingSphere Starsurge::BoundingSphere::Transform(const Matrix4& m) const {
+    float sx = Vector3::Dot(Vector3(m(0,0), m(1,0), m(2,0)), Vector3(m(0,0), m(1,0), m(2,0)));
+    float sy = Vector3::Dot(Vector3(m(0,1), m(1,1), m(2,1)), Vector3(m(0,1), m(1,1), m(2,1)));
+    float sz = Vector3::Dot(Vector3(m(0,2), m(1,2), m(2,2)), Vector3(m(0,2), m(1,2), m(2,2)));
+    float maxScale = std::sqrt(std::fmax(sx, std::fmax(sy, sz)));
+    return BoundingSphere(m.TransformPoint(this->Center), this->Radius*maxScale);
+}
@@ -0,0 +1,119 @@
+#include <cstdlib>
+#include "../include/CPUDispatch.h"
+#include "../include/Logging.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <intrin.h>
+    #include <immintrin.h>
+#endif
+
+namespace {
+    const Starsurge::BatchKernels * KernelsFor(Starsurge::SIMDLevel level) {
+        switch (level) {
+            case Starsurge::SIMDLevel::AVX512: return Starsurge::GetAVX512Kernels();
+            case Starsurge::SIMDLevel::AVX2: return Starsurge::GetAVX2Kernels();
+            case Starsurge::SIMDLevel::SSE2: return Starsurge::GetSSE2Kernels();
+            default: return Starsurge::GetScalarKernels();
+        }
+    }
+
+    const Starsurge::BatchKernels * ChooseKernels() {
+        Starsurge::SIMDLevel level = Starsurge::DetectSIMDLevel();
+
+        const char * env = std::getenv("STARSURGE_SIMD");
+        if (env != NULL) {
+            std::string forced(env);
+            for (int i = (int)level; i >= 0; --i) {
+                if (Starsurge::GetSIMDLevelName((Starsurge::SIMDLevel)i) == forced) {
+                    level = (Starsurge::SIMDLevel)i;
+                    break;
+                }
+            }
+        }
+
+        // Fall back until we find a table that was compiled in.
+        for (int i = (int)level; i > 0; --i) {
+            const Starsurge::BatchKernels * kernels = KernelsFor((Starsurge::SIMDLevel)i);
+            if (kernels != NULL) {
+                return kernels;
+            }
+        }
+        return Starsurge::GetScalarKernels();
+    }
+
+    const Starsurge::BatchKernels *& ActiveKernels() {
+        static const Starsurge::BatchKernels * active = ChooseKernels();
+        return active;
+    }
+}
+
+Starsurge::SIMDLevel Starsurge::DetectSIMDLevel() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return SIMDLevel::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return SIMDLevel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return SIMDLevel::SSE2;
+    }
+    return SIMDLevel::Scalar;
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4];
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool fma = (info[2] & (1 << 12)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    // The OS has to save the wider registers too.
+    unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+    bool ymm = (xcr0 & 0x6) == 0x6;
+    bool zmm = (xcr0 & 0xE6) == 0xE6;
+
+    __cpuidex(info, 7, 0);
+    bool avx2 = (info[1] & (1 << 5)) != 0;
+    bool avx512f = (info[1] & (1 << 16)) != 0;
+
+    if (avx512f && zmm) {
+        return SIMDLevel::AVX512;
+    }
+    if (avx2 && fma && ymm) {
+        return SIMDLevel::AVX2;
+    }
+    return sse2 ? SIMDLevel::SSE2 : SIMDLevel::Scalar;
+#else
+    return SIMDLevel::Scalar;
+#endif
+}
+
+Starsurge::SIMDLevel Starsurge::GetSIMDLevel() {
+    return ActiveKernels()->level;
+}
+
+bool Starsurge::ForceSIMDLevel(SIMDLevel level) {
+    if ((int)level > (int)DetectSIMDLevel()) {
+        Error("This CPU doesn't support "+GetSIMDLevelName(level)+".");
+        return false;
+    }
+    const BatchKernels * kernels = KernelsFor(level);
+    if (kernels == NULL) {
+        Error(GetSIMDLevelName(level)+" kernels weren't compiled into this build.");
+        return false;
+    }
+    ActiveKernels() = kernels;
+    return true;
+}
+
+std::string Starsurge::GetSIMDLevelName(SIMDLevel level) {
+    switch (level) {
+        case SIMDLevel::AVX512: return "avx512";
+        case SIMDLevel::AVX2: return "avx2";
+        case SIMDLevel::SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+const Starsurge::BatchKernels & Starsurge::GetBatchKernels() {
+    return *ActiveKernels();
+}
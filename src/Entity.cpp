@@ -1,7 +1,8 @@
 #include "../include/Entity.h"
 #include "../include/Logging.h"
+#include "../include/MeshRenderer.h"
 
-Starsurge::Entity::Entity(std::string t_name) : name(t_name), enabled(true) {
+Starsurge::Entity::Entity(std::string t_name) : name(t_name), enabled(true), scaling(1, 1, 1) {
 
 }
 
@@ -20,3 +21,51 @@ bool Starsurge::Entity::IsEnabled() {
 std::string Starsurge::Entity::GetName() {
     return this->name;
 }
+
+void Starsurge::Entity::SetPosition(Vector3 t_position) {
+    this->position = t_position;
+}
+
+void Starsurge::Entity::SetRotation(Quaternion t_rotation) {
+    this->rotation = t_rotation;
+}
+
+void Starsurge::Entity::SetRotation(Vector3 euler) {
+    this->rotation = Quaternion::FromEuler(euler);
+}
+
+void Starsurge::Entity::SetScale(Vector3 t_scale) {
+    this->scaling = t_scale;
+}
+
+Starsurge::Vector3 Starsurge::Entity::GetPosition() {
+    return this->position;
+}
+
+Starsurge::Quaternion Starsurge::Entity::GetRotation() {
+    return this->rotation;
+}
+
+Starsurge::Vector3 Starsurge::Entity::GetScale() {
+    return this->scaling;
+}
+
+Starsurge::Matrix4 Starsurge::Entity::GetModelMatrix() {
+    return Matrix4::TRS(this->position, this->rotation, this->scaling);
+}
+
+Starsurge::AABB Starsurge::Entity::GetWorldAABB() {
+    MeshRenderer * renderer = FindComponent<MeshRenderer>();
+    if (renderer == NULL || renderer->GetMesh() == NULL) {
+        return AABB(this->position, this->position);
+    }
+    return renderer->GetMesh()->GetAABB().Transform(GetModelMatrix());
+}
+
+Starsurge::BoundingSphere Starsurge::Entity::GetWorldBoundingSphere() {
+    MeshRenderer * renderer = FindComponent<MeshRenderer>();
+    if (renderer == NULL || renderer->GetMesh() == NULL) {
+        return BoundingSphere(this->position, 0);
+    }
+    return renderer->GetMesh()->GetBoundingSphere().Transform(GetModelMatrix());
+}
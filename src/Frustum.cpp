@@ -0,0 +1,112 @@
+#include <thread>
+#include "../include/Frustum.h"
+#include "../include/CPUDispatch.h"
+
+namespace {
+    // Below this many spheres per worker, starting a thread costs more than the test itself.
+    const size_t MIN_SPHERES_PER_THREAD = 4096;
+}
+
+Starsurge::Frustum::Frustum() {
+    // Everything passes until planes are extracted.
+    for (size_t i = 0; i < PLANE_COUNT*4; ++i) {
+        this->planes[i] = (i % 4 == 3) ? 1.0f : 0.0f;
+    }
+}
+
+Starsurge::Frustum Starsurge::Frustum::FromMatrix(const Matrix4& viewProjection) {
+    // Gribb/Hartmann: each plane is the last row plus or minus one of the other rows.
+    Vector4 row0 = viewProjection.GetRow(0);
+    Vector4 row1 = viewProjection.GetRow(1);
+    Vector4 row2 = viewProjection.GetRow(2);
+    Vector4 row3 = viewProjection.GetRow(3);
+    Vector4 extracted[PLANE_COUNT] = {
+        row3 + row0, row3 - row0,
+        row3 + row1, row3 - row1,
+        row3 + row2, row3 - row2
+    };
+
+    Frustum ret;
+    for (size_t i = 0; i < PLANE_COUNT; ++i) {
+        Vector4 plane = extracted[i];
+        float length = Vector3(plane[0], plane[1], plane[2]).Magnitude();
+        float inv = (length > 0) ? 1.0f / length : 0.0f;
+        for (size_t j = 0; j < 4; ++j) {
+            ret.planes[i*4 + j] = plane[j] * inv;
+        }
+    }
+    return ret;
+}
+
+Starsurge::Vector4 Starsurge::Frustum::GetPlane(Plane plane) const {
+    const float * p = this->planes + plane*4;
+    return Vector4(p[0], p[1], p[2], p[3]);
+}
+
+bool Starsurge::Frustum::Intersects(const Vector3& point) const {
+    return Intersects(BoundingSphere(point, 0));
+}
+
+bool Starsurge::Frustum::Intersects(const BoundingSphere& sphere) const {
+    SIMD::Float4 center = SIMD::Load4(Vector4(sphere.Center[0], sphere.Center[1], sphere.Center[2], 1).GetData());
+    for (size_t i = 0; i < PLANE_COUNT; ++i) {
+        if (SIMD::Dot(SIMD::Load4(this->planes + i*4), center) + sphere.Radius < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Starsurge::Frustum::Intersects(const AABB& box) const {
+    // Only the corner furthest along each plane's normal needs testing, its distance is
+    // dot(n, center) + d + dot(|n|, extents).
+    Vector3 c = box.GetCenter();
+    Vector3 e = box.GetExtents();
+    SIMD::Float4 center = SIMD::Load4(Vector4(c[0], c[1], c[2], 1).GetData());
+    SIMD::Float4 extents = SIMD::Load4(Vector4(e[0], e[1], e[2], 0).GetData());
+    for (size_t i = 0; i < PLANE_COUNT; ++i) {
+        SIMD::Float4 plane = SIMD::Load4(this->planes + i*4);
+        if (SIMD::Dot(plane, center) + SIMD::Dot(SIMD::Abs(plane), extents) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t Starsurge::Frustum::CullSpheres(const Vector3Array& centers, const float * radii, unsigned char * visible, unsigned int threads) const {
+    const size_t count = centers.GetSize();
+    if (count == 0) {
+        return 0;
+    }
+    const BatchKernels& kernels = GetBatchKernels();
+
+    size_t workers = count / MIN_SPHERES_PER_THREAD;
+    if (workers > threads) {
+        workers = threads;
+    }
+    if (workers <= 1) {
+        kernels.CullSpheres(this->planes, PLANE_COUNT, centers.X(), centers.Y(), centers.Z(), radii, count, visible);
+    }
+    else {
+        // Chunks are rounded to the kernel padding so only the last one has a scalar tail.
+        size_t chunk = (count + workers - 1) / workers;
+        chunk = (chunk + BATCH_KERNEL_PADDING - 1) / BATCH_KERNEL_PADDING * BATCH_KERNEL_PADDING;
+        std::vector<std::thread> pool;
+        for (size_t begin = chunk; begin < count; begin += chunk) {
+            size_t n = (begin + chunk <= count) ? chunk : count - begin;
+            pool.emplace_back([&kernels, this, &centers, radii, visible, begin, n]() {
+                kernels.CullSpheres(this->planes, PLANE_COUNT, centers.X()+begin, centers.Y()+begin, centers.Z()+begin, radii+begin, n, visible+begin);
+            });
+        }
+        kernels.CullSpheres(this->planes, PLANE_COUNT, centers.X(), centers.Y(), centers.Z(), radii, chunk, visible);
+        for (size_t i = 0; i < pool.size(); ++i) {
+            pool[i].join();
+        }
+    }
+
+    size_t visibleCount = 0;
+    for (size_t i = 0; i < count; ++i) {
+        visibleCount += visible[i];
+    }
+    return visibleCount;
+}
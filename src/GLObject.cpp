@@ -0,0 +1,90 @@
+#include <glad/glad.h>
+#include <mutex>
+#include <vector>
+#include "../include/GLObject.h"
+#include "../include/GLStateCache.h"
+
+namespace {
+    using Starsurge::GLObjectType;
+
+    struct PendingDeletions {
+        std::mutex Lock;
+        std::vector<unsigned int> Buffers;
+        std::vector<unsigned int> VertexArrays;
+    };
+
+    // Never destroyed, so meshes destroyed during static destruction can still queue safely.
+    PendingDeletions & GetPending() {
+        static PendingDeletions * pending = new PendingDeletions();
+        return *pending;
+    }
+}
+
+void Starsurge::GLDeletionQueue::Queue(GLObjectType type, unsigned int name) {
+    if (name == 0) {
+        return;
+    }
+    PendingDeletions & pending = GetPending();
+    std::lock_guard<std::mutex> lock(pending.Lock);
+    (type == GLObjectType::VertexArray ? pending.VertexArrays : pending.Buffers).push_back(name);
+}
+
+void Starsurge::GLDeletionQueue::Flush() {
+    std::vector<unsigned int> buffers, vertexArrays;
+    {
+        PendingDeletions & pending = GetPending();
+        std::lock_guard<std::mutex> lock(pending.Lock);
+        buffers.swap(pending.Buffers);
+        vertexArrays.swap(pending.VertexArrays);
+    }
+    // One call per type for the whole frame's worth.
+    if (!vertexArrays.empty()) {
+        glDeleteVertexArrays((GLsizei)vertexArrays.size(), vertexArrays.data());
+        GLStateCache::ForgetVertexArrays(vertexArrays.data(), vertexArrays.size());
+    }
+    if (!buffers.empty()) {
+        glDeleteBuffers((GLsizei)buffers.size(), buffers.data());
+        GLStateCache::ForgetBuffers(buffers.data(), buffers.size());
+    }
+}
+
+size_t Starsurge::GLDeletionQueue::NumberOfPending() {
+    PendingDeletions & pending = GetPending();
+    std::lock_guard<std::mutex> lock(pending.Lock);
+    return pending.Buffers.size() + pending.VertexArrays.size();
+}
+
+Starsurge::GLObject::~GLObject() {
+    Reset();
+}
+
+Starsurge::GLObject::GLObject(GLObject&& other) noexcept : type(other.type), name(other.name) {
+    other.name = 0;
+}
+
+Starsurge::GLObject& Starsurge::GLObject::operator=(GLObject&& other) noexcept {
+    if (this != &other) {
+        Reset();
+        this->type = other.type;
+        this->name = other.name;
+        other.name = 0;
+    }
+    return *this;
+}
+
+Starsurge::GLObject Starsurge::GLObject::Create(GLObjectType type) {
+    GLObject ret;
+    ret.type = type;
+    if (type == GLObjectType::VertexArray) {
+        glGenVertexArrays(1, &ret.name);
+    }
+    else {
+        glGenBuffers(1, &ret.name);
+    }
+    return ret;
+}
+
+void Starsurge::GLObject::Reset() {
+    GLDeletionQueue::Queue(this->type, this->name);
+    this->name = 0;
+}
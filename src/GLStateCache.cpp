@@ -0,0 +1,205 @@
+#include <glad/glad.h>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+#include "../include/GLStateCache.h"
+
+namespace {
+    using Starsurge::GLStateCache;
+    using Starsurge::GLStateStats;
+
+    // Never a real name or value, so the next call always goes through.
+    const unsigned int UNKNOWN = 0xFFFFFFFF;
+
+    const GLenum BUFFER_TARGETS[] = { GL_ARRAY_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GL_UNIFORM_BUFFER };
+    const unsigned int BUFFER_TARGET_COUNT = sizeof(BUFFER_TARGETS) / sizeof(BUFFER_TARGETS[0]);
+    const GLenum TEXTURE_TARGETS[] = { GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_3D };
+    const unsigned int TEXTURE_TARGET_COUNT = sizeof(TEXTURE_TARGETS) / sizeof(TEXTURE_TARGETS[0]);
+
+    struct CachedState {
+        unsigned int Program;
+        unsigned int VertexArray;
+        unsigned int Buffers[BUFFER_TARGET_COUNT];
+        // Element buffer bindings are part of each VAO's state.
+        std::unordered_map<unsigned int, unsigned int> ElementBuffers;
+        unsigned int ActiveTexture;
+        unsigned int Textures[GLStateCache::MAX_TEXTURE_UNITS][TEXTURE_TARGET_COUNT];
+        unsigned int Blending;
+        unsigned int BlendSource;
+        unsigned int BlendDestination;
+        unsigned int DepthTest;
+        unsigned int DepthWrite;
+        GLStateStats Stats;
+
+        CachedState() : Stats() {
+            Forget();
+        }
+        void Forget() {
+            this->Program = this->VertexArray = this->ActiveTexture = UNKNOWN;
+            for (unsigned int i = 0; i < BUFFER_TARGET_COUNT; ++i) {
+                this->Buffers[i] = UNKNOWN;
+            }
+            this->ElementBuffers.clear();
+            for (unsigned int unit = 0; unit < GLStateCache::MAX_TEXTURE_UNITS; ++unit) {
+                for (unsigned int i = 0; i < TEXTURE_TARGET_COUNT; ++i) {
+                    this->Textures[unit][i] = UNKNOWN;
+                }
+            }
+            this->Blending = this->BlendSource = this->BlendDestination = UNKNOWN;
+            this->DepthTest = this->DepthWrite = UNKNOWN;
+        }
+    };
+
+    CachedState & GetState() {
+        static CachedState state;
+        return state;
+    }
+
+    // Stores value and counts the call. False when it was already there and the call can be dropped.
+    bool Update(unsigned int & cached, unsigned int value) {
+        CachedState & state = GetState();
+        if (cached == value) {
+            state.Stats.Elided++;
+            return false;
+        }
+        cached = value;
+        state.Stats.Issued++;
+        return true;
+    }
+
+    template<size_t N>
+    int FindTarget(const GLenum (&targets)[N], unsigned int target) {
+        for (size_t i = 0; i < N; ++i) {
+            if (targets[i] == target) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    void SetCapability(GLenum capability, unsigned int & cached, bool enabled) {
+        if (!Update(cached, enabled)) {
+            return;
+        }
+        if (enabled) {
+            glEnable(capability);
+        }
+        else {
+            glDisable(capability);
+        }
+    }
+}
+
+void Starsurge::GLStateCache::UseProgram(unsigned int program) {
+    if (Update(GetState().Program, program)) {
+        glUseProgram(program);
+    }
+}
+
+void Starsurge::GLStateCache::BindVertexArray(unsigned int vao) {
+    if (Update(GetState().VertexArray, vao)) {
+        glBindVertexArray(vao);
+    }
+}
+
+void Starsurge::GLStateCache::BindBuffer(unsigned int target, unsigned int buffer) {
+    CachedState & state = GetState();
+    if (target == GL_ELEMENT_ARRAY_BUFFER && state.VertexArray != UNKNOWN) {
+        auto it = state.ElementBuffers.emplace(state.VertexArray, UNKNOWN).first;
+        if (Update(it->second, buffer)) {
+            glBindBuffer(target, buffer);
+        }
+        return;
+    }
+    int slot = FindTarget(BUFFER_TARGETS, target);
+    if (slot < 0) {
+        state.Stats.Issued++;
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if (Update(state.Buffers[slot], buffer)) {
+        glBindBuffer(target, buffer);
+    }
+}
+
+void Starsurge::GLStateCache::BindTexture(unsigned int unit, unsigned int target, unsigned int texture) {
+    CachedState & state = GetState();
+    int slot = FindTarget(TEXTURE_TARGETS, target);
+    if (slot >= 0 && unit < MAX_TEXTURE_UNITS && state.Textures[unit][slot] == texture) {
+        state.Stats.Elided++;
+        return;
+    }
+    if (Update(state.ActiveTexture, unit)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+    if (slot >= 0 && unit < MAX_TEXTURE_UNITS) {
+        state.Textures[unit][slot] = texture;
+    }
+    state.Stats.Issued++;
+    glBindTexture(target, texture);
+}
+
+void Starsurge::GLStateCache::SetBlending(bool enabled) {
+    SetCapability(GL_BLEND, GetState().Blending, enabled);
+}
+
+void Starsurge::GLStateCache::SetBlendFunc(unsigned int source, unsigned int destination) {
+    CachedState & state = GetState();
+    if (state.BlendSource == source && state.BlendDestination == destination) {
+        state.Stats.Elided++;
+        return;
+    }
+    state.BlendSource = source;
+    state.BlendDestination = destination;
+    state.Stats.Issued++;
+    glBlendFunc(source, destination);
+}
+
+void Starsurge::GLStateCache::SetDepthTest(bool enabled) {
+    SetCapability(GL_DEPTH_TEST, GetState().DepthTest, enabled);
+}
+
+void Starsurge::GLStateCache::SetDepthWrite(bool enabled) {
+    if (Update(GetState().DepthWrite, enabled)) {
+        glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+    }
+}
+
+void Starsurge::GLStateCache::Invalidate() {
+    GetState().Forget();
+}
+
+void Starsurge::GLStateCache::ForgetBuffers(const unsigned int * buffers, unsigned int count) {
+    // A whole frame's deletions at once, so sort them rather than scan every VAO per name.
+    std::vector<unsigned int> deleted(buffers, buffers + count);
+    std::sort(deleted.begin(), deleted.end());
+    CachedState & state = GetState();
+    for (unsigned int slot = 0; slot < BUFFER_TARGET_COUNT; ++slot) {
+        if (std::binary_search(deleted.begin(), deleted.end(), state.Buffers[slot])) {
+            state.Buffers[slot] = UNKNOWN;
+        }
+    }
+    for (auto it = state.ElementBuffers.begin(); it != state.ElementBuffers.end(); ++it) {
+        if (std::binary_search(deleted.begin(), deleted.end(), it->second)) {
+            it->second = UNKNOWN;
+        }
+    }
+}
+
+void Starsurge::GLStateCache::ForgetVertexArrays(const unsigned int * vaos, unsigned int count) {
+    CachedState & state = GetState();
+    for (unsigned int i = 0; i < count; ++i) {
+        if (state.VertexArray == vaos[i]) {
+            state.VertexArray = UNKNOWN;
+        }
+        state.ElementBuffers.erase(vaos[i]);
+    }
+}
+
+Starsurge::GLStateStats Starsurge::GLStateCache::GetStats() {
+    return GetState().Stats;
+}
+
+void Starsurge::GLStateCache::ResetStats() {
+    GetState().Stats = GLStateStats();
+}
@@ -1,5 +1,6 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <limits>
 #include "../include/Engine.h"
 
 void framebuffer_size_callback(GLFWwindow * window, int width, int height)
@@ -7,7 +8,25 @@ void framebuffer_size_callback(GLFWwindow * window, int width, int height)
     glViewport(0, 0, width, height);
 }
 
-Starsurge::Game::Game(std::string t_gamename) : gamename (t_gamename) {
+namespace {
+    using namespace Starsurge;
+
+    // How much of the viewport's height a sphere covers: its projected diameter over the NDC height of 2.
+    float ProjectedSize(const Matrix4 & viewProjection, const BoundingSphere & sphere) {
+        const Vector3 & c = sphere.Center;
+        float w = viewProjection(3,0)*c[0] + viewProjection(3,1)*c[1] + viewProjection(3,2)*c[2] + viewProjection(3,3);
+        float scaleY = Vector3(viewProjection(1,0), viewProjection(1,1), viewProjection(1,2)).Magnitude();
+        if (w <= 1e-6f) { // Center at or behind the camera, treat it as filling the screen.
+            return std::numeric_limits<float>::max();
+        }
+        return sphere.Radius * scaleY / w;
+    }
+}
+
+Starsurge::Game::Game(std::string t_gamename) : gamename (t_gamename), activeScene(NULL), frustumCulling(true), cullingThreads(1) {
+    this->cullingStats.Visible = 0;
+    this->cullingStats.Culled = 0;
+    this->glStateStats = GLStateStats();
 }
 
 Starsurge::Game::~Game() {
@@ -19,8 +38,90 @@ void Starsurge::Game::SetScene(Scene * t_scene) {
     this->activeScene = t_scene;
 }
 
+void Starsurge::Game::SetFrustumCulling(bool t_enabled) {
+    this->frustumCulling = t_enabled;
+}
+
+void Starsurge::Game::SetCullingThreads(unsigned int t_threads) {
+    this->cullingThreads = (t_threads == 0) ? 1 : t_threads;
+}
+
+Starsurge::CullingStats Starsurge::Game::GetCullingStats() {
+    return this->cullingStats;
+}
+
+void Starsurge::Game::SetInstancing(bool t_enabled) {
+    this->renderQueue.SetInstancing(t_enabled);
+}
+
+void Starsurge::Game::SetDrawSorting(bool t_enabled) {
+    this->renderQueue.SetSorting(t_enabled);
+}
+
+Starsurge::RenderQueueStats Starsurge::Game::GetRenderStats() {
+    return this->renderQueue.GetStats();
+}
+
+Starsurge::GLStateStats Starsurge::Game::GetGLStateStats() {
+    return this->glStateStats;
+}
+
+void Starsurge::Game::PrepareEntities(const std::vector<Entity*> & entities) {
+    // Same results as Entity::GetModelMatrix() and GetWorldBoundingSphere(), but with one component
+    // lookup and one TRS per entity.
+    this->cullRenderers.clear();
+    this->cullModels.clear();
+    this->cullSpheres.clear();
+    for (size_t i = 0; i < entities.size(); ++i) {
+        MeshRenderer * renderer = entities[i]->FindComponent<MeshRenderer>();
+        Matrix4 model = entities[i]->GetModelMatrix();
+        if (renderer != NULL && renderer->GetMesh() != NULL) {
+            this->cullSpheres.push_back(renderer->GetMesh()->GetBoundingSphere().Transform(model));
+        }
+        else {
+            this->cullSpheres.push_back(BoundingSphere(entities[i]->GetPosition(), 0));
+        }
+        this->cullRenderers.push_back(renderer);
+        this->cullModels.push_back(model);
+    }
+}
+
+void Starsurge::Game::CullEntities(std::vector<Entity*> & entities) {
+    // Pack the world space spheres so the kernels can test a whole register of them per plane.
+    const size_t count = entities.size();
+    this->cullCenters.Resize(count);
+    this->cullRadii.resize(count);
+    this->cullVisible.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        this->cullCenters.Set(i, this->cullSpheres[i].Center);
+        this->cullRadii[i] = this->cullSpheres[i].Radius;
+    }
+
+    Frustum frustum = Frustum::FromMatrix(this->activeScene->GetViewProjection());
+    frustum.CullSpheres(this->cullCenters, this->cullRadii.data(), this->cullVisible.data(), this->cullingThreads);
+
+    // Compact the survivors in place, keeping their order.
+    size_t visible = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (this->cullVisible[i]) {
+            entities[visible] = entities[i];
+            this->cullRenderers[visible] = this->cullRenderers[i];
+            this->cullModels[visible] = this->cullModels[i];
+            this->cullSpheres[visible] = this->cullSpheres[i];
+            visible++;
+        }
+    }
+    entities.resize(visible);
+    this->cullRenderers.resize(visible);
+    this->cullModels.resize(visible);
+    this->cullSpheres.resize(visible);
+    this->cullingStats.Visible = visible;
+    this->cullingStats.Culled = count - visible;
+}
+
 void Starsurge::Game::Run() {
     Starsurge::Log("Launching GLFW Window...");
+    Starsurge::Log("Using "+Starsurge::GetSIMDLevelName(Starsurge::GetSIMDLevel())+" batch kernels.");
 
     // Initialize OpenGL version 3.3
     glfwInit();
@@ -44,6 +145,7 @@ void Starsurge::Game::Run() {
         Starsurge::FatalError("Failed to initialize GLAD.");
         return;
     }
+    GLStateCache::Invalidate();
 
     OnInitialize();
     GameLoop();
@@ -64,18 +166,37 @@ void Starsurge::Game::GameLoop() {
 
         // Iterate through each entity with a MeshRenderer
         std::vector<Entity*> meshEntities = this->activeScene->FindEntitiesWithComponent<MeshRenderer>();
+        PrepareEntities(meshEntities);
+        if (this->frustumCulling) {
+            CullEntities(meshEntities);
+        }
+        else {
+            this->cullingStats.Visible = meshEntities.size();
+            this->cullingStats.Culled = 0;
+        }
+        const Matrix4 viewProjection = this->activeScene->GetViewProjection();
+        this->renderQueue.Begin(viewProjection);
         for (unsigned int i = 0; i < meshEntities.size(); ++i) {
-            MeshRenderer * component = meshEntities[i]->FindComponent<MeshRenderer>();
+            MeshRenderer * component = this->cullRenderers[i];
             if (component != NULL) {
-                component->Render();
+                if (component->NumberOfLODs() > 0) {
+                    component->SelectLOD(ProjectedSize(viewProjection, this->cullSpheres[i]));
+                }
+                component->Submit(this->renderQueue, this->cullModels[i]);
             }
         }
+        this->renderQueue.Execute();
+        this->glStateStats = GLStateCache::GetStats();
+        GLStateCache::ResetStats();
 
         //  Swap buffers and poll IO
         glfwSwapBuffers(this->gameWindow);
         glfwPollEvents();
+        // Anything destroyed this frame is done with, free it while the context is current.
+        GLDeletionQueue::Flush();
     }
 
+    GLDeletionQueue::Flush();
     glfwTerminate();
     return;
 }
@@ -0,0 +1,343 @@
+#include <glad/glad.h>
+#include <algorithm>
+#include "../include/GeometryPool.h"
+#include "../include/GLStateCache.h"
+
+namespace {
+    // Index ranges start on a multiple of this, so both 16 and 32 bit indices are aligned.
+    const size_t INDEX_ALIGNMENT = 4;
+
+    size_t AlignIndexBytes(size_t bytes) {
+        return (bytes + INDEX_ALIGNMENT - 1) / INDEX_ALIGNMENT * INDEX_ALIGNMENT;
+    }
+
+    // Takes size units from the first free block big enough for them. Empty ranges always fit at 0.
+    bool TakeRange(std::map<size_t, size_t> & freeList, size_t size, size_t & offset) {
+        if (size == 0) {
+            offset = 0;
+            return true;
+        }
+        for (auto it = freeList.begin(); it != freeList.end(); ++it) {
+            if (it->second < size) {
+                continue;
+            }
+            offset = it->first;
+            size_t left = it->second - size;
+            freeList.erase(it);
+            if (left > 0) {
+                freeList[offset + size] = left;
+            }
+            return true;
+        }
+        return false;
+    }
+
+    // Puts a range back, merging it with the free blocks right before and after it.
+    void ReturnRange(std::map<size_t, size_t> & freeList, size_t offset, size_t size) {
+        if (size == 0) {
+            return;
+        }
+        auto next = freeList.lower_bound(offset);
+        if (next != freeList.end() && offset + size == next->first) {
+            size += next->second;
+            next = freeList.erase(next);
+        }
+        if (next != freeList.begin()) {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset) {
+                prev->second += size;
+                return;
+            }
+        }
+        freeList[offset] = size;
+    }
+
+    // Free space is only fragmented when it's not all in one block at the end.
+    bool IsFragmented(const std::map<size_t, size_t> & freeList, size_t capacity) {
+        if (freeList.empty()) {
+            return false;
+        }
+        if (freeList.size() > 1) {
+            return true;
+        }
+        return freeList.begin()->first + freeList.begin()->second != capacity;
+    }
+
+    // Copies each (source, destination, size) range from the bound GL_COPY_READ_BUFFER to the bound
+    // GL_COPY_WRITE_BUFFER, merging runs that are contiguous on both sides into one copy. Ranges are
+    // sorted by source offset and packed, so neighbours in the source stay neighbours.
+    struct CopyRange {
+        size_t Source;
+        size_t Destination;
+        size_t Size;
+    };
+
+    void CopyRanges(const std::vector<CopyRange> & ranges) {
+        size_t i = 0;
+        while (i < ranges.size()) {
+            CopyRange run = ranges[i++];
+            while (i < ranges.size() && ranges[i].Source == run.Source + run.Size && ranges[i].Destination == run.Destination + run.Size) {
+                run.Size += ranges[i++].Size;
+            }
+            if (run.Size > 0) {
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, run.Source, run.Destination, run.Size);
+            }
+        }
+    }
+}
+
+Starsurge::GeometryAllocation::~GeometryAllocation() {
+    Reset();
+}
+
+Starsurge::GeometryAllocation::GeometryAllocation(GeometryAllocation&& other) noexcept : pool(other.pool), id(other.id) {
+    other.pool = NULL;
+    other.id = 0;
+}
+
+Starsurge::GeometryAllocation& Starsurge::GeometryAllocation::operator=(GeometryAllocation&& other) noexcept {
+    if (this != &other) {
+        Reset();
+        this->pool = other.pool;
+        this->id = other.id;
+        other.pool = NULL;
+        other.id = 0;
+    }
+    return *this;
+}
+
+Starsurge::GeometryRange Starsurge::GeometryAllocation::GetRange() const {
+    if (this->pool == NULL) {
+        GeometryRange empty = {};
+        empty.Format = VertexFormat::Full();
+        return empty;
+    }
+    return this->pool->GetRange(this->id);
+}
+
+void Starsurge::GeometryAllocation::Reset() {
+    if (this->pool != NULL) {
+        this->pool->Free(this->id);
+    }
+    this->pool = NULL;
+    this->id = 0;
+}
+
+Starsurge::GeometryPool::GeometryPool(size_t t_vertexArenaSize, size_t t_indexArenaSize) : vertexArenaSize(t_vertexArenaSize), indexArenaSize(t_indexArenaSize) {
+}
+
+Starsurge::GeometryAllocation Starsurge::GeometryPool::Allocate(VertexFormat format, size_t vertexCount, size_t indexBytes) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    const size_t alignedIndexBytes = AlignIndexBytes(indexBytes);
+    Block block;
+    block.VertexCount = vertexCount;
+    block.IndexBytes = indexBytes;
+    block.Live = true;
+
+    bool found = false;
+    for (size_t i = 0; i < this->arenas.size() && !found; ++i) {
+        Arena & arena = *this->arenas[i];
+        if (arena.Format != format || !TakeRange(arena.FreeVertices, vertexCount, block.FirstVertex)) {
+            continue;
+        }
+        if (!TakeRange(arena.FreeIndices, alignedIndexBytes, block.IndexOffset)) {
+            ReturnRange(arena.FreeVertices, block.FirstVertex, vertexCount);
+            continue;
+        }
+        block.ArenaIndex = i;
+        found = true;
+    }
+    if (!found) {
+        const size_t stride = format.GetStride();
+        Arena * arena = CreateArena(format, std::max(this->vertexArenaSize / stride, vertexCount), std::max(AlignIndexBytes(this->indexArenaSize), alignedIndexBytes));
+        TakeRange(arena->FreeVertices, vertexCount, block.FirstVertex);
+        TakeRange(arena->FreeIndices, alignedIndexBytes, block.IndexOffset);
+        block.ArenaIndex = this->arenas.size() - 1;
+    }
+    this->arenas[block.ArenaIndex]->Allocations++;
+
+    GeometryAllocation ret;
+    ret.pool = this;
+    if (!this->freeIds.empty()) {
+        ret.id = this->freeIds.back();
+        this->freeIds.pop_back();
+        this->blocks[ret.id - 1] = block;
+    }
+    else {
+        this->blocks.push_back(block);
+        ret.id = this->blocks.size();
+    }
+    return ret;
+}
+
+Starsurge::GeometryPool::Arena * Starsurge::GeometryPool::CreateArena(VertexFormat format, size_t vertexCapacity, size_t indexCapacity) {
+    std::unique_ptr<Arena> arena(new Arena());
+    arena->Format = format;
+    arena->VertexCapacity = vertexCapacity;
+    arena->IndexCapacity = indexCapacity;
+    arena->VAO = GLObject::Create(GLObjectType::VertexArray);
+    arena->VBO = GLObject::Create(GLObjectType::Buffer);
+    arena->EBO = GLObject::Create(GLObjectType::Buffer);
+    if (vertexCapacity > 0) {
+        arena->FreeVertices[0] = vertexCapacity;
+    }
+    if (indexCapacity > 0) {
+        arena->FreeIndices[0] = indexCapacity;
+    }
+
+    // The element buffer binding is part of the VAO's state, so bind the VAO first.
+    GLStateCache::BindVertexArray(arena->VAO.Get());
+    GLStateCache::BindBuffer(GL_ARRAY_BUFFER, arena->VBO.Get());
+    glBufferData(GL_ARRAY_BUFFER, vertexCapacity * format.GetStride(), NULL, GL_DYNAMIC_DRAW);
+    format.SetupAttributes();
+    GLStateCache::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, arena->EBO.Get());
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCapacity, NULL, GL_DYNAMIC_DRAW);
+
+    this->arenas.push_back(std::move(arena));
+    return this->arenas.back().get();
+}
+
+void Starsurge::GeometryPool::Free(unsigned int id) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    if (id == 0 || id > this->blocks.size() || !this->blocks[id - 1].Live) {
+        return;
+    }
+    Block & block = this->blocks[id - 1];
+    Arena & arena = *this->arenas[block.ArenaIndex];
+    ReturnRange(arena.FreeVertices, block.FirstVertex, block.VertexCount);
+    ReturnRange(arena.FreeIndices, block.IndexOffset, AlignIndexBytes(block.IndexBytes));
+    arena.Allocations--;
+    block.Live = false;
+    this->freeIds.push_back(id);
+}
+
+Starsurge::GeometryRange Starsurge::GeometryPool::GetRange(unsigned int id) const {
+    std::lock_guard<std::mutex> guard(this->lock);
+    const Block & block = this->blocks[id - 1];
+    const Arena & arena = *this->arenas[block.ArenaIndex];
+    GeometryRange range;
+    range.Format = arena.Format;
+    range.VAO = arena.VAO.Get();
+    range.VBO = arena.VBO.Get();
+    range.EBO = arena.EBO.Get();
+    range.BaseVertex = block.FirstVertex;
+    range.VertexCount = block.VertexCount;
+    range.VertexOffset = block.FirstVertex * arena.Format.GetStride();
+    range.IndexOffset = block.IndexOffset;
+    range.IndexBytes = block.IndexBytes;
+    return range;
+}
+
+void Starsurge::GeometryPool::Compact() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    // Drop the empty arenas and renumber the rest.
+    std::vector<size_t> remap(this->arenas.size());
+    size_t kept = 0;
+    for (size_t i = 0; i < this->arenas.size(); ++i) {
+        remap[i] = kept;
+        if (this->arenas[i]->Allocations > 0) {
+            this->arenas[kept++] = std::move(this->arenas[i]);
+        }
+    }
+    this->arenas.resize(kept);
+    for (size_t i = 0; i < this->blocks.size(); ++i) {
+        if (this->blocks[i].Live) {
+            this->blocks[i].ArenaIndex = remap[this->blocks[i].ArenaIndex];
+        }
+    }
+
+    for (size_t i = 0; i < this->arenas.size(); ++i) {
+        Arena & arena = *this->arenas[i];
+        if (IsFragmented(arena.FreeVertices, arena.VertexCapacity) || IsFragmented(arena.FreeIndices, arena.IndexCapacity)) {
+            CompactArena(arena, i);
+        }
+    }
+}
+
+void Starsurge::GeometryPool::CompactArena(Arena & arena, size_t arenaIndex) {
+    std::vector<Block*> live;
+    for (size_t i = 0; i < this->blocks.size(); ++i) {
+        if (this->blocks[i].Live && this->blocks[i].ArenaIndex == arenaIndex) {
+            live.push_back(&this->blocks[i]);
+        }
+    }
+    const size_t stride = arena.Format.GetStride();
+
+    // Pack in the order the ranges already have, so neighbours move together.
+    std::vector<CopyRange> vertexCopies, indexCopies;
+    std::sort(live.begin(), live.end(), [](const Block * a, const Block * b) { return a->FirstVertex < b->FirstVertex; });
+    size_t vertexEnd = 0;
+    for (size_t i = 0; i < live.size(); ++i) {
+        CopyRange copy = { live[i]->FirstVertex * stride, vertexEnd * stride, live[i]->VertexCount * stride };
+        vertexCopies.push_back(copy);
+        live[i]->FirstVertex = vertexEnd;
+        vertexEnd += live[i]->VertexCount;
+    }
+    std::sort(live.begin(), live.end(), [](const Block * a, const Block * b) { return a->IndexOffset < b->IndexOffset; });
+    size_t indexEnd = 0;
+    for (size_t i = 0; i < live.size(); ++i) {
+        CopyRange copy = { live[i]->IndexOffset, indexEnd, AlignIndexBytes(live[i]->IndexBytes) };
+        indexCopies.push_back(copy);
+        live[i]->IndexOffset = indexEnd;
+        indexEnd += AlignIndexBytes(live[i]->IndexBytes);
+    }
+
+    // Copying within one buffer can't overlap, so the ranges go into fresh buffers.
+    GLObject vbo = GLObject::Create(GLObjectType::Buffer);
+    GLObject ebo = GLObject::Create(GLObjectType::Buffer);
+    GLStateCache::BindBuffer(GL_COPY_READ_BUFFER, arena.VBO.Get());
+    GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, vbo.Get());
+    glBufferData(GL_COPY_WRITE_BUFFER, arena.VertexCapacity * stride, NULL, GL_DYNAMIC_DRAW);
+    CopyRanges(vertexCopies);
+    GLStateCache::BindBuffer(GL_COPY_READ_BUFFER, arena.EBO.Get());
+    GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, ebo.Get());
+    glBufferData(GL_COPY_WRITE_BUFFER, arena.IndexCapacity, NULL, GL_DYNAMIC_DRAW);
+    CopyRanges(indexCopies);
+
+    // The attribute pointers captured the old vertex buffer, so point them at the new one.
+    GLStateCache::BindVertexArray(arena.VAO.Get());
+    GLStateCache::BindBuffer(GL_ARRAY_BUFFER, vbo.Get());
+    arena.Format.SetupAttributes();
+    GLStateCache::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo.Get());
+    arena.VBO = std::move(vbo);
+    arena.EBO = std::move(ebo);
+
+    arena.FreeVertices.clear();
+    arena.FreeIndices.clear();
+    if (vertexEnd < arena.VertexCapacity) {
+        arena.FreeVertices[vertexEnd] = arena.VertexCapacity - vertexEnd;
+    }
+    if (indexEnd < arena.IndexCapacity) {
+        arena.FreeIndices[indexEnd] = arena.IndexCapacity - indexEnd;
+    }
+}
+
+size_t Starsurge::GeometryPool::NumberOfArenas() const {
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->arenas.size();
+}
+
+size_t Starsurge::GeometryPool::NumberOfAllocations() const {
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->blocks.size() - this->freeIds.size();
+}
+
+size_t Starsurge::GeometryPool::GetFragmentedBytes() const {
+    std::lock_guard<std::mutex> guard(this->lock);
+    size_t ret = 0;
+    for (size_t i = 0; i < this->arenas.size(); ++i) {
+        const Arena & arena = *this->arenas[i];
+        const size_t stride = arena.Format.GetStride();
+        for (auto it = arena.FreeVertices.begin(); it != arena.FreeVertices.end(); ++it) {
+            if (it->first + it->second != arena.VertexCapacity) {
+                ret += it->second * stride;
+            }
+        }
+        for (auto it = arena.FreeIndices.begin(); it != arena.FreeIndices.end(); ++it) {
+            if (it->first + it->second != arena.IndexCapacity) {
+                ret += it->second;
+            }
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,96 @@
+#include "../include/MappedFile.h"
+#include "../include/Logging.h"
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+Starsurge::MappedFile::~MappedFile() {
+    Close();
+}
+
+#ifdef _WIN32
+bool Starsurge::MappedFile::Open(const std::string & path) {
+    Close();
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        Error("Couldn't open "+path+".");
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(handle, &fileSize) || fileSize.QuadPart == 0) {
+        Error("Couldn't map "+path+", it's empty or unreadable.");
+        CloseHandle(handle);
+        return false;
+    }
+    HANDLE view = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    const void * ptr = (view == NULL) ? NULL : MapViewOfFile(view, FILE_MAP_READ, 0, 0, 0);
+    if (ptr == NULL) {
+        Error("Couldn't map "+path+".");
+        if (view != NULL) {
+            CloseHandle(view);
+        }
+        CloseHandle(handle);
+        return false;
+    }
+    this->file = handle;
+    this->mapping = view;
+    this->data = (const unsigned char*)ptr;
+    this->size = (size_t)fileSize.QuadPart;
+    return true;
+}
+
+void Starsurge::MappedFile::Close() {
+    if (this->data != NULL) {
+        UnmapViewOfFile(this->data);
+        CloseHandle((HANDLE)this->mapping);
+        CloseHandle((HANDLE)this->file);
+    }
+    this->data = NULL;
+    this->size = 0;
+    this->mapping = NULL;
+    this->file = NULL;
+}
+#else
+bool Starsurge::MappedFile::Open(const std::string & path) {
+    Close();
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        Error("Couldn't open "+path+".");
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        Error("Couldn't map "+path+", it's empty or unreadable.");
+        close(fd);
+        return false;
+    }
+    void * ptr = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps its own reference to the file.
+    if (ptr == MAP_FAILED) {
+        Error("Couldn't map "+path+".");
+        return false;
+    }
+    // Everything is read front to back exactly once, usually straight into glBufferData.
+    madvise(ptr, (size_t)info.st_size, MADV_SEQUENTIAL);
+    madvise(ptr, (size_t)info.st_size, MADV_WILLNEED);
+    this->data = (const unsigned char*)ptr;
+    this->size = (size_t)info.st_size;
+    return true;
+}
+
+void Starsurge::MappedFile::Close() {
+    if (this->data != NULL) {
+        munmap((void*)this->data, this->size);
+    }
+    this->data = NULL;
+    this->size = 0;
+}
+#endif
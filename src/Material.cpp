@@ -1,10 +1,49 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include "../include/Material.h"
+#include <cstring>
 #include <stdexcept>
 
-Starsurge::MaterialData::MaterialData(std::string t_name, std::string t_type) : name(t_name), type(t_type) {
+namespace {
+    using Starsurge::UniformType;
+    using Starsurge::UniformValue;
+
+    // 0 means no material, see Shader::GetLastApplied().
+    unsigned int nextMaterialId = 1;
+
+    UniformType ParseUniformType(const std::string & type) {
+        if (type == "bool") { return UniformType::Bool; }
+        if (type == "int") { return UniformType::Int; }
+        if (type == "uint") { return UniformType::UInt; }
+        if (type == "float") { return UniformType::Float; }
+        if (type == "vec2") { return UniformType::Vec2; }
+        if (type == "vec3") { return UniformType::Vec3; }
+        if (type == "vec4") { return UniformType::Vec4; }
+        return UniformType::Unsupported;
+    }
+
+    void PackFloats(UniformValue & value, const float * floats, unsigned int count) {
+        std::memcpy(value.Words, floats, count*sizeof(float));
+    }
+
+    void Upload(int location, UniformType type, const UniformValue & value) {
+        float f[4];
+        std::memcpy(f, value.Words, sizeof(f));
+        switch (type) {
+            case UniformType::Bool:
+            case UniformType::Int: glUniform1i(location, (int)value.Words[0]); break;
+            case UniformType::UInt: glUniform1ui(location, value.Words[0]); break;
+            case UniformType::Float: glUniform1f(location, f[0]); break;
+            case UniformType::Vec2: glUniform2f(location, f[0], f[1]); break;
+            case UniformType::Vec3: glUniform3f(location, f[0], f[1], f[2]); break;
+            case UniformType::Vec4: glUniform4f(location, f[0], f[1], f[2], f[3]); break;
+            default: break;
+        }
+    }
+}
 
+Starsurge::MaterialData::MaterialData(std::string t_name, std::string t_type) : name(t_name), type(t_type) {
+    this->uniformType = ParseUniformType(t_type);
 }
 
 std::string Starsurge::MaterialData::GetName() {
@@ -20,6 +59,7 @@ void Starsurge::MaterialData::SetData(bool val) {
         throw std::runtime_error("Tried to set uniform of type "+GetType()+" to type bool.");
     }
     this->data = val;
+    this->dirty = true;
 }
 
 void Starsurge::MaterialData::SetData(int val) {
@@ -27,6 +67,7 @@ void Starsurge::MaterialData::SetData(int val) {
         throw std::runtime_error("Tried to set uniform of type "+GetType()+" to type int.");
     }
     this->data = val;
+    this->dirty = true;
 }
 
 void Starsurge::MaterialData::SetData(unsigned int val) {
@@ -34,6 +75,7 @@ void Starsurge::MaterialData::SetData(unsigned int val) {
         throw std::runtime_error("Tried to set uniform of type "+GetType()+" to type uint.");
     }
     this->data = val;
+    this->dirty = true;
 }
 
 void Starsurge::MaterialData::SetData(float val) {
@@ -41,6 +83,7 @@ void Starsurge::MaterialData::SetData(float val) {
         throw std::runtime_error("Tried to set uniform of type "+GetType()+" to type float.");
     }
     this->data = val;
+    this->dirty = true;
 }
 
 void Starsurge::MaterialData::SetData(double val) {
@@ -48,6 +91,7 @@ void Starsurge::MaterialData::SetData(double val) {
         throw std::runtime_error("Tried to set uniform of type "+GetType()+" to type double.");
     }
     this->data = val;
+    this->dirty = true;
 }
 
 void Starsurge::MaterialData::SetData(Vector2 val) {
@@ -55,6 +99,7 @@ void Starsurge::MaterialData::SetData(Vector2 val) {
         throw std::runtime_error("Tried to set uniform of type "+GetType()+" to type vec2.");
     }
     this->data = val;
+    this->dirty = true;
 }
 
 void Starsurge::MaterialData::SetData(Vector3 val) {
@@ -62,6 +107,7 @@ void Starsurge::MaterialData::SetData(Vector3 val) {
         throw std::runtime_error("Tried to set uniform of type "+GetType()+" to type vec3.");
     }
     this->data = val;
+    this->dirty = true;
 }
 
 void Starsurge::MaterialData::SetData(Vector4 val) {
@@ -69,6 +115,7 @@ void Starsurge::MaterialData::SetData(Vector4 val) {
         throw std::runtime_error("Tried to set uniform of type "+GetType()+" to type vec4.");
     }
     this->data = val;
+    this->dirty = true;
 }
 
 void Starsurge::MaterialData::SetData(Color val) {
@@ -77,6 +124,41 @@ void Starsurge::MaterialData::SetData(Color val) {
     }
     Color clearColor = val.ToOpenGLFormat(); //Temporary
     this->data = Vector4(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+    this->dirty = true;
+}
+
+bool Starsurge::MaterialData::Pack(UniformValue & value) {
+    value = UniformValue();
+    switch (this->uniformType) {
+        case UniformType::Bool: value.Words[0] = GetData<bool>() ? 1 : 0; return true;
+        case UniformType::Int: value.Words[0] = (uint32_t)GetData<int>(); return true;
+        case UniformType::UInt: value.Words[0] = GetData<unsigned int>(); return true;
+        case UniformType::Float: {
+            const float f = GetData<float>();
+            PackFloats(value, &f, 1);
+            return true;
+        }
+        case UniformType::Vec2: {
+            const Vector2 vec2 = GetData<Vector2>();
+            const float f[2] = { vec2[0], vec2[1] };
+            PackFloats(value, f, 2);
+            return true;
+        }
+        case UniformType::Vec3: {
+            const Vector3 vec3 = GetData<Vector3>();
+            const float f[3] = { vec3[0], vec3[1], vec3[2] };
+            PackFloats(value, f, 3);
+            return true;
+        }
+        case UniformType::Vec4: {
+            const Vector4 vec4 = GetData<Vector4>();
+            const float f[4] = { vec4[0], vec4[1], vec4[2], vec4[3] };
+            PackFloats(value, f, 4);
+            return true;
+        }
+        default:
+            return false;
+    }
 }
 
 Starsurge::Material::Material() {
@@ -99,37 +181,59 @@ Starsurge::Shader * Starsurge::Material::GetShader() {
 }
 
 
+void Starsurge::Material::SetTransparent(bool t_transparent) {
+    this->transparent = t_transparent;
+}
+
+bool Starsurge::Material::IsTransparent() {
+    return this->transparent;
+}
+
 Starsurge::MaterialData * Starsurge::Material::GetUniform(std::string name) {
     return this->data[name];
 }
 
 void Starsurge::Material::Apply() {
     this->shader->Use();
+    if (this->generation != this->shader->GetGeneration()) {
+        UpdateLocations();
+    }
 
-    for (auto it = this->data.begin(); it != this->data.end(); ++it) {
-        std::string name = it->first;
-        MaterialData * mdata = it->second;
-        std::string type = mdata->GetType();
-
-        // Get uniform location and apply uniform.
-        int uniformLoc = glGetUniformLocation(this->shader->GetProgram(), name.c_str());
-        if (type == "vec2") {
-            const Vector2 vec2 = mdata->GetData<Vector2>();
-            glUniform2f(uniformLoc, vec2[0], vec2[1]);
+    // If this material was the last one applied, the program still has every value that isn't dirty.
+    // Otherwise each value is checked against what the program has, which another material sharing it
+    // may well have set already.
+    const bool current = this->shader->GetLastApplied() == this->id;
+    for (unsigned int slot = 0; slot < this->slots.size(); ++slot) {
+        MaterialData * mdata = this->slots[slot];
+        if (current && !mdata->dirty) {
+            continue;
         }
-        if (type == "vec3") {
-            const Vector3 vec3 = mdata->GetData<Vector3>();
-            glUniform3f(uniformLoc, vec3[0], vec3[1], vec3[2]);
+        mdata->dirty = false;
+
+        UniformValue value;
+        if (mdata->location < 0 || !mdata->Pack(value)) {
+            continue;
         }
-        if (type == "vec4") {
-            const Vector4 vec4 = mdata->GetData<Vector4>();
-            glUniform4f(uniformLoc, vec4[0], vec4[1], vec4[2], vec4[3]);
+        if (this->shader->ExchangeUniform(slot, value)) {
+            Upload(mdata->location, mdata->uniformType, value);
         }
     }
+    this->shader->SetLastApplied(this->id);
+}
+
+void Starsurge::Material::UpdateLocations() {
+    const std::vector<int> & locations = this->shader->GetUniformLocations();
+    for (unsigned int slot = 0; slot < this->slots.size(); ++slot) {
+        this->slots[slot]->location = slot < locations.size() ? locations[slot] : -1;
+        this->slots[slot]->dirty = true;
+    }
+    this->generation = this->shader->GetGeneration();
 }
 
 void Starsurge::Material::SetupData() {
     this->data.clear();
+    this->slots.clear();
+    this->id = nextMaterialId++;
     const std::map<std::string, std::string> uniforms = this->shader->GetUniforms();
 
     for (auto it = uniforms.begin(); it != uniforms.end(); ++it) {
@@ -149,5 +253,7 @@ void Starsurge::Material::SetupData() {
 
         // Add our data
         this->data[name] = matdata;
+        this->slots.push_back(matdata);
     }
+    UpdateLocations();
 }
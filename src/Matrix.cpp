@@ -0,0 +1,185 @@
+#include "../include/Matrix.h"
+#include "../include/Quaternion.h"
+
+static_assert(sizeof(Starsurge::Vector3) == 3*sizeof(float), "Vector3 arrays must be tightly packed floats.");
+
+Starsurge::Vector3 Starsurge::Matrix4::TransformPoint(const Vector3& point) const {
+    Vector4 ret = (*this) * Vector4(point[0], point[1], point[2], 1);
+    return Vector3(ret[0], ret[1], ret[2]);
+}
+
+Starsurge::Vector3 Starsurge::Matrix4::TransformDirection(const Vector3& direction) const {
+    Vector4 ret = (*this) * Vector4(direction[0], direction[1], direction[2], 0);
+    return Vector3(ret[0], ret[1], ret[2]);
+}
+
+void Starsurge::Matrix4::TransformPoints(Vector3 * points, size_t count) const {
+    TransformPoints(points, points, count);
+}
+
+void Starsurge::Matrix4::TransformPoints(std::vector<Vector3>& points) const {
+    TransformPoints(points.data(), points.data(), points.size());
+}
+
+void Starsurge::Matrix4::TransformPoints(const Vector3 * in, Vector3 * out, size_t count) const {
+    const float * src = in == NULL ? NULL : in[0].GetData();
+    float * dst = out == NULL ? NULL : out[0].GetData();
+    size_t i = 0;
+
+    const SIMD::Float4 m00 = SIMD::Splat((*this)(0,0)), m01 = SIMD::Splat((*this)(0,1)), m02 = SIMD::Splat((*this)(0,2)), m03 = SIMD::Splat((*this)(0,3));
+    const SIMD::Float4 m10 = SIMD::Splat((*this)(1,0)), m11 = SIMD::Splat((*this)(1,1)), m12 = SIMD::Splat((*this)(1,2)), m13 = SIMD::Splat((*this)(1,3));
+    const SIMD::Float4 m20 = SIMD::Splat((*this)(2,0)), m21 = SIMD::Splat((*this)(2,1)), m22 = SIMD::Splat((*this)(2,2)), m23 = SIMD::Splat((*this)(2,3));
+    for (; i + 4 <= count; i += 4) {
+        // Work on four points at once as x, y and z columns.
+        SIMD::Float4 x, y, z;
+        SIMD::Deinterleave3(src + i*3, x, y, z);
+        SIMD::Float4 rx = SIMD::Add(SIMD::Add(SIMD::Mul(m00, x), SIMD::Mul(m01, y)), SIMD::Add(SIMD::Mul(m02, z), m03));
+        SIMD::Float4 ry = SIMD::Add(SIMD::Add(SIMD::Mul(m10, x), SIMD::Mul(m11, y)), SIMD::Add(SIMD::Mul(m12, z), m13));
+        SIMD::Float4 rz = SIMD::Add(SIMD::Add(SIMD::Mul(m20, x), SIMD::Mul(m21, y)), SIMD::Add(SIMD::Mul(m22, z), m23));
+        SIMD::Interleave3(dst + i*3, rx, ry, rz);
+    }
+    for (; i < count; ++i) {
+        out[i] = TransformPoint(in[i]);
+    }
+}
+
+Starsurge::Matrix4 Starsurge::Matrix4::AffineInverse() const {
+    // The inverse of [A t; 0 1] is [A^-1 -A^-1*t; 0 1]. The rows of A^-1 are cross products of A's columns.
+    Vector3 c0(data[0], data[1], data[2]);
+    Vector3 c1(data[4], data[5], data[6]);
+    Vector3 c2(data[8], data[9], data[10]);
+    Vector3 t(data[12], data[13], data[14]);
+
+    Vector3 r0 = Vector3::CrossProduct(c1, c2);
+    Vector3 r1 = Vector3::CrossProduct(c2, c0);
+    Vector3 r2 = Vector3::CrossProduct(c0, c1);
+    float det = Vector3::Dot(c0, r0);
+    if (det == 0) {
+        Error("Can't invert singular matrix.");
+        return Matrix4::Identity();
+    }
+    float invDet = 1.0f / det;
+
+    Matrix4 ret;
+    for (size_t i = 0; i < 3; ++i) {
+        ret(0, i) = r0[i]*invDet;
+        ret(1, i) = r1[i]*invDet;
+        ret(2, i) = r2[i]*invDet;
+    }
+    ret(0, 3) = -(ret(0,0)*t[0] + ret(0,1)*t[1] + ret(0,2)*t[2]);
+    ret(1, 3) = -(ret(1,0)*t[0] + ret(1,1)*t[1] + ret(1,2)*t[2]);
+    ret(2, 3) = -(ret(2,0)*t[0] + ret(2,1)*t[1] + ret(2,2)*t[2]);
+    ret(3, 3) = 1;
+    return ret;
+}
+
+void Starsurge::Matrix4::Decompose(Vector3 & translation, Vector3 & rotation, Vector3 & scale) const {
+    translation = Vector3(data[12], data[13], data[14]);
+
+    Vector3 c0(data[0], data[1], data[2]);
+    Vector3 c1(data[4], data[5], data[6]);
+    Vector3 c2(data[8], data[9], data[10]);
+    scale = Vector3(c0.Magnitude(), c1.Magnitude(), c2.Magnitude());
+    if (Vector3::Dot(c0, Vector3::CrossProduct(c1, c2)) < 0) { // Mirrored, put the flip on x.
+        scale[0] = -scale[0];
+    }
+    if (scale[0] == 0 || scale[1] == 0 || scale[2] == 0) {
+        Error("Can't decompose a matrix with zero scale.");
+        rotation = Vector3(0, 0, 0);
+        return;
+    }
+
+    // Pure rotation, R = Rz*Ry*Rx.
+    float r00 = c0[0]/scale[0], r10 = c0[1]/scale[0], r20 = c0[2]/scale[0];
+    float r11 = c1[1]/scale[1], r21 = c1[2]/scale[1];
+    float r12 = c2[1]/scale[2], r22 = c2[2]/scale[2];
+
+    if (r20 < 0.9999f && r20 > -0.9999f) {
+        rotation[0] = std::atan2(r21, r22);
+        rotation[1] = std::asin(-r20);
+        rotation[2] = std::atan2(r10, r00);
+    }
+    else { // Gimbal lock, only x+z or x-z is known so put it all on x.
+        rotation[0] = std::atan2(-r12, r11);
+        rotation[1] = (r20 < 0) ? 1.57079632679f : -1.57079632679f;
+        rotation[2] = 0;
+    }
+}
+
+Starsurge::Matrix4 Starsurge::Matrix4::Translate(const Vector3& translation) {
+    Matrix4 ret = Matrix4::Identity();
+    ret(0, 3) = translation[0];
+    ret(1, 3) = translation[1];
+    ret(2, 3) = translation[2];
+    return ret;
+}
+
+Starsurge::Matrix4 Starsurge::Matrix4::Scale(const Vector3& scale) {
+    Matrix4 ret;
+    ret(0, 0) = scale[0];
+    ret(1, 1) = scale[1];
+    ret(2, 2) = scale[2];
+    ret(3, 3) = 1;
+    return ret;
+}
+
+Starsurge::Matrix4 Starsurge::Matrix4::RotateX(float angle) {
+    float c = std::cos(angle), s = std::sin(angle);
+    return Matrix4({
+        1, 0,  0, 0,
+        0, c, -s, 0,
+        0, s,  c, 0,
+        0, 0,  0, 1
+    });
+}
+
+Starsurge::Matrix4 Starsurge::Matrix4::RotateY(float angle) {
+    float c = std::cos(angle), s = std::sin(angle);
+    return Matrix4({
+         c, 0, s, 0,
+         0, 1, 0, 0,
+        -s, 0, c, 0,
+         0, 0, 0, 1
+    });
+}
+
+Starsurge::Matrix4 Starsurge::Matrix4::RotateZ(float angle) {
+    float c = std::cos(angle), s = std::sin(angle);
+    return Matrix4({
+        c, -s, 0, 0,
+        s,  c, 0, 0,
+        0,  0, 1, 0,
+        0,  0, 0, 1
+    });
+}
+
+Starsurge::Matrix4 Starsurge::Matrix4::Rotate(const Vector3& euler) {
+    // Expanded Rz*Ry*Rx so we only pay for one set of sin/cos.
+    float cx = std::cos(euler[0]), sx = std::sin(euler[0]);
+    float cy = std::cos(euler[1]), sy = std::sin(euler[1]);
+    float cz = std::cos(euler[2]), sz = std::sin(euler[2]);
+    return Matrix4({
+        cy*cz, sx*sy*cz - cx*sz, cx*sy*cz + sx*sz, 0,
+        cy*sz, sx*sy*sz + cx*cz, cx*sy*sz - sx*cz, 0,
+          -sy,            sx*cy,            cx*cy, 0,
+            0,                0,                0, 1
+    });
+}
+
+Starsurge::Matrix4 Starsurge::Matrix4::TRS(const Vector3& translation, const Vector3& rotation, const Vector3& scale) {
+    return TRS(translation, Quaternion::FromEuler(rotation), scale);
+}
+
+Starsurge::Matrix4 Starsurge::Matrix4::TRS(const Vector3& translation, const Quaternion& rotation, const Vector3& scale) {
+    // Scaling only touches the rotation's columns, so skip the full multiplies.
+    Matrix4 ret = rotation.ToMatrix();
+    for (size_t i = 0; i < 3; ++i) {
+        ret(i, 0) *= scale[0];
+        ret(i, 1) *= scale[1];
+        ret(i, 2) *= scale[2];
+    }
+    ret(0, 3) = translation[0];
+    ret(1, 3) = translation[1];
+    ret(2, 3) = translation[2];
+    return ret;
+}
@@ -1,116 +1,769 @@
+#include <cstring>
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <type_traits>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include "../include/Mesh.h"
+#include "../include/MeshFile.h"
+#include "../include/GLStateCache.h"
+#include "../include/MeshNormals.h"
+#include "../include/Vector3Array.h"
+#include "../include/Packing.h"
 
-Starsurge::Mesh::Mesh(std::vector<Vertex> t_vertices, std::vector<unsigned int> t_indices) : vertices(t_vertices), indices(t_indices) {
+// VertexFormat::Full() uploads the Vertex array as is, so its layout has to match the attribute pointers.
+static_assert(std::is_standard_layout<Starsurge::Vertex>::value, "Vertex must be standard layout.");
+static_assert(sizeof(Starsurge::Vertex) == 12*sizeof(float), "Vertex must be 12 tightly packed floats.");
+static_assert(offsetof(Starsurge::Vertex, Position) == 0, "Vertex::Position must come first.");
+static_assert(offsetof(Starsurge::Vertex, Normal) == 3*sizeof(float), "Vertex::Normal must follow Position.");
+static_assert(offsetof(Starsurge::Vertex, UV) == 6*sizeof(float), "Vertex::UV must follow Normal.");
+static_assert(offsetof(Starsurge::Vertex, Color) == 8*sizeof(float), "Vertex::Color must follow UV.");
+
+// Everything but the positions of the built-in primitives is known at compile time.
+namespace {
+    using Starsurge::Vertex;
+    using Starsurge::Vector2;
+    using Starsurge::Vector3;
+    namespace Colors = Starsurge::Colors;
+
+    constexpr Vertex TRIANGLE_VERTICES[] = {
+        { Vector3(0,0,0), Vector3(0,0,0), Vector2(0,0), Colors::WHITE },
+        { Vector3(0,0,0), Vector3(0,0,0), Vector2(0,0), Colors::WHITE },
+        { Vector3(0,0,0), Vector3(0,0,0), Vector2(0,0), Colors::WHITE }
+    };
+    constexpr unsigned int TRIANGLE_INDICES[] = { 0, 1, 2 };
+
+    constexpr Vertex QUAD_VERTICES[] = {
+        { Vector3(0,0,0), Vector3(0,0,0), Vector2(0,0), Colors::RED },
+        { Vector3(0,0,0), Vector3(0,0,0), Vector2(0,0), Colors::GREEN },
+        { Vector3(0,0,0), Vector3(0,0,0), Vector2(0,0), Colors::BLUE },
+        { Vector3(0,0,0), Vector3(0,0,0), Vector2(0,0), Colors::MAGENTA }
+    };
+    constexpr unsigned int QUAD_INDICES[] = { 0, 1, 3, 1, 2, 3 };
+
+    // One glVertexAttribPointer call. Every attribute is padded to 4 bytes so the next one stays aligned.
+    struct AttributeLayout {
+        GLint size;
+        GLenum type;
+        GLboolean normalized;
+        size_t bytes;
+    };
+
+    AttributeLayout GetPositionLayout(Starsurge::PositionEncoding encoding) {
+        if (encoding == Starsurge::PositionEncoding::Half) {
+            return { 3, GL_HALF_FLOAT, GL_FALSE, 4*sizeof(unsigned short) };
+        }
+        return { 3, GL_FLOAT, GL_FALSE, 3*sizeof(float) };
+    }
+
+    AttributeLayout GetNormalLayout(Starsurge::NormalEncoding encoding) {
+        if (encoding == Starsurge::NormalEncoding::Octahedral) {
+            return { 2, GL_SHORT, GL_TRUE, 2*sizeof(short) };
+        }
+        return { 3, GL_FLOAT, GL_FALSE, 3*sizeof(float) };
+    }
+
+    AttributeLayout GetUVLayout(Starsurge::UVEncoding encoding) {
+        if (encoding == Starsurge::UVEncoding::Half) {
+            return { 2, GL_HALF_FLOAT, GL_FALSE, 2*sizeof(unsigned short) };
+        }
+        if (encoding == Starsurge::UVEncoding::UNorm16) {
+            return { 2, GL_UNSIGNED_SHORT, GL_TRUE, 2*sizeof(unsigned short) };
+        }
+        return { 2, GL_FLOAT, GL_FALSE, 2*sizeof(float) };
+    }
+
+    AttributeLayout GetColorLayout(Starsurge::ColorEncoding encoding) {
+        // Not normalized: colors reach the shader as 0-255 either way and the prelude scales them.
+        if (encoding == Starsurge::ColorEncoding::UNorm8) {
+            return { 4, GL_UNSIGNED_BYTE, GL_FALSE, 4*sizeof(unsigned char) };
+        }
+        return { 4, GL_FLOAT, GL_FALSE, 4*sizeof(float) };
+    }
+
+    // Below this many vertices per worker, starting a thread costs more than the encoding.
+    const size_t MIN_VERTICES_PER_THREAD = 65536;
+
+    // Writes count vertices into out, stride bytes apart, in the given format.
+    void EncodeRange(const Vertex * vertices, size_t count, Starsurge::VertexFormat format, unsigned char * out) {
+        using namespace Starsurge;
+        const size_t stride = format.GetStride();
+        for (size_t i = 0; i < count; ++i) {
+            const Vertex& v = vertices[i];
+            unsigned char * dst = out + i*stride;
+
+            if (format.Position == PositionEncoding::Half) {
+                unsigned short p[4] = { FloatToHalf(v.Position[0]), FloatToHalf(v.Position[1]), FloatToHalf(v.Position[2]), 0 };
+                std::memcpy(dst, p, sizeof(p));
+            }
+            else {
+                std::memcpy(dst, v.Position.GetData(), 3*sizeof(float));
+            }
+            dst += GetPositionLayout(format.Position).bytes;
+
+            if (format.Normal == NormalEncoding::Octahedral) {
+                Vector2 e = OctahedralEncode(v.Normal);
+                short n[2] = { PackSNorm16(e[0]), PackSNorm16(e[1]) };
+                std::memcpy(dst, n, sizeof(n));
+            }
+            else {
+                std::memcpy(dst, v.Normal.GetData(), 3*sizeof(float));
+            }
+            dst += GetNormalLayout(format.Normal).bytes;
+
+            if (format.UV == UVEncoding::Half) {
+                unsigned short uv[2] = { FloatToHalf(v.UV[0]), FloatToHalf(v.UV[1]) };
+                std::memcpy(dst, uv, sizeof(uv));
+            }
+            else if (format.UV == UVEncoding::UNorm16) {
+                unsigned short uv[2] = { PackUNorm16(v.UV[0]), PackUNorm16(v.UV[1]) };
+                std::memcpy(dst, uv, sizeof(uv));
+            }
+            else {
+                std::memcpy(dst, v.UV.GetData(), 2*sizeof(float));
+            }
+            dst += GetUVLayout(format.UV).bytes;
+
+            if (format.Color == ColorEncoding::UNorm8) {
+                Starsurge::Color col = v.Color.ToOpenGLFormat();
+                unsigned char c[4] = { PackUNorm8(col[0]), PackUNorm8(col[1]), PackUNorm8(col[2]), PackUNorm8(col[3]) };
+                std::memcpy(dst, c, sizeof(c));
+            }
+            else {
+                std::memcpy(dst, v.Color.GetData(), 4*sizeof(float));
+            }
+        }
+    }
+
+    // Inverse of EncodeRange, used to fill in the CPU copy of a loaded mesh.
+    void DecodeRange(const unsigned char * in, size_t count, Starsurge::VertexFormat format, Vertex * vertices) {
+        using namespace Starsurge;
+        const size_t stride = format.GetStride();
+        for (size_t i = 0; i < count; ++i) {
+            Vertex& v = vertices[i];
+            const unsigned char * src = in + i*stride;
+
+            if (format.Position == PositionEncoding::Half) {
+                unsigned short p[3];
+                std::memcpy(p, src, sizeof(p));
+                v.Position = Vector3(HalfToFloat(p[0]), HalfToFloat(p[1]), HalfToFloat(p[2]));
+            }
+            else {
+                std::memcpy(v.Position.GetData(), src, 3*sizeof(float));
+            }
+            src += GetPositionLayout(format.Position).bytes;
+
+            if (format.Normal == NormalEncoding::Octahedral) {
+                short n[2];
+                std::memcpy(n, src, sizeof(n));
+                v.Normal = OctahedralDecode(Vector2(UnpackSNorm16(n[0]), UnpackSNorm16(n[1])));
+            }
+            else {
+                std::memcpy(v.Normal.GetData(), src, 3*sizeof(float));
+            }
+            src += GetNormalLayout(format.Normal).bytes;
+
+            if (format.UV == UVEncoding::Half || format.UV == UVEncoding::UNorm16) {
+                unsigned short uv[2];
+                std::memcpy(uv, src, sizeof(uv));
+                v.UV = (format.UV == UVEncoding::Half) ? Vector2(HalfToFloat(uv[0]), HalfToFloat(uv[1])) : Vector2(UnpackUNorm16(uv[0]), UnpackUNorm16(uv[1]));
+            }
+            else {
+                std::memcpy(v.UV.GetData(), src, 2*sizeof(float));
+            }
+            src += GetUVLayout(format.UV).bytes;
+
+            if (format.Color == ColorEncoding::UNorm8) {
+                v.Color = Starsurge::Color(src[0], src[1], src[2], src[3]);
+            }
+            else {
+                std::memcpy(v.Color.GetData(), src, 4*sizeof(float));
+            }
+        }
+    }
+
+    // Runs func(first, count) over [0, count), split across threads for big meshes. Every vertex is
+    // independent.
+    template<typename F>
+    void ForEachVertexRange(size_t count, F func) {
+        size_t workers = std::min<size_t>(count / MIN_VERTICES_PER_THREAD, std::thread::hardware_concurrency());
+        if (workers <= 1) {
+            func(0, count);
+            return;
+        }
+        const size_t chunk = (count + workers - 1) / workers;
+        std::vector<std::thread> pool;
+        for (size_t begin = chunk; begin < count; begin += chunk) {
+            pool.emplace_back(func, begin, std::min(chunk, count - begin));
+        }
+        func(0, chunk);
+        for (size_t i = 0; i < pool.size(); ++i) {
+            pool[i].join();
+        }
+    }
+
+    void EncodeVertices(const Vertex * vertices, size_t count, Starsurge::VertexFormat format, unsigned char * out) {
+        const size_t stride = format.GetStride();
+        ForEachVertexRange(count, [=](size_t first, size_t n) { EncodeRange(vertices + first, n, format, out + first*stride); });
+    }
+
+    void DecodeVertices(const unsigned char * in, size_t count, Starsurge::VertexFormat format, Vertex * vertices) {
+        const size_t stride = format.GetStride();
+        ForEachVertexRange(count, [=](size_t first, size_t n) { DecodeRange(in + first*stride, n, format, vertices + first); });
+    }
+
+    // The bounds Mesh keeps: the box, and a sphere around the box's center.
+    void ComputeVertexBounds(const std::vector<Vertex> & vertices, Starsurge::Vector3Array & positions, Starsurge::AABB & aabb, Starsurge::BoundingSphere & sphere) {
+        using namespace Starsurge;
+        if (vertices.empty()) {
+            aabb = AABB(Vector3(0, 0, 0), Vector3(0, 0, 0));
+            sphere = BoundingSphere(Vector3(0, 0, 0), 0);
+            return;
+        }
+
+        positions.LoadPositions(vertices);
+        positions.MinMax(aabb.Min, aabb.Max);
+
+        // Centered on the box rather than a minimal sphere, but it only takes one more pass.
+        Vector3 center = aabb.GetCenter();
+        const float * x = positions.X();
+        const float * y = positions.Y();
+        const float * z = positions.Z();
+        const size_t count = positions.GetSize();
+        SIMD::Float4 cx = SIMD::Splat(center[0]), cy = SIMD::Splat(center[1]), cz = SIMD::Splat(center[2]);
+        SIMD::Float4 maxDistSq = SIMD::Splat(0);
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            SIMD::Float4 dx = SIMD::Sub(SIMD::Load4(x+i), cx);
+            SIMD::Float4 dy = SIMD::Sub(SIMD::Load4(y+i), cy);
+            SIMD::Float4 dz = SIMD::Sub(SIMD::Load4(z+i), cz);
+            SIMD::Float4 distSq = SIMD::Add(SIMD::Add(SIMD::Mul(dx, dx), SIMD::Mul(dy, dy)), SIMD::Mul(dz, dz));
+            maxDistSq = SIMD::Max(maxDistSq, distSq);
+        }
+        float lanes[4];
+        SIMD::Extract(maxDistSq, lanes);
+        float radiusSq = std::fmax(std::fmax(lanes[0], lanes[1]), std::fmax(lanes[2], lanes[3]));
+        for (; i < count; ++i) {
+            float dx = x[i] - center[0], dy = y[i] - center[1], dz = z[i] - center[2];
+            radiusSq = std::fmax(radiusSq, dx*dx + dy*dy + dz*dz);
+        }
+        sphere = BoundingSphere(center, std::sqrt(radiusSq));
+    }
+
+    // Uploads [begin, end) bytes of a buffer whose full contents are data. Past the first upload a
+    // buffer turns dynamic; once an update rewrites at least half of it, it turns stream and gets orphaned
+    // on each such update instead of waiting for the GPU to finish with the old contents.
+    void UploadBuffer(GLenum target, const void * data, size_t size, size_t begin, size_t end, bool dynamic, size_t & capacity, unsigned int & usage) {
+        if (usage == 0) { // First upload.
+            usage = dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
+            glBufferData(target, size, data, usage);
+            capacity = size;
+            return;
+        }
+        bool mostly = (end - begin) * 2 >= size;
+        if (mostly) {
+            usage = GL_STREAM_DRAW;
+        }
+        else if (usage == GL_STATIC_DRAW) {
+            usage = GL_DYNAMIC_DRAW;
+            capacity = 0; // Respecify with the new hint.
+        }
+        if (mostly || size != capacity) {
+            glBufferData(target, size, data, usage);
+            capacity = size;
+        }
+        else {
+            glBufferSubData(target, begin, end - begin, (const unsigned char*)data + begin);
+        }
+    }
+}
+
+bool Starsurge::VertexFormat::NeedsConversion() const {
+    return this->Position != PositionEncoding::Float || this->Normal != NormalEncoding::Float ||
+        this->UV != UVEncoding::Float || this->Color != ColorEncoding::Float;
+}
+
+size_t Starsurge::VertexFormat::GetStride() const {
+    return GetPositionLayout(this->Position).bytes + GetNormalLayout(this->Normal).bytes +
+        GetUVLayout(this->UV).bytes + GetColorLayout(this->Color).bytes;
+}
+
+Starsurge::Mesh::Mesh(std::vector<Vertex> t_vertices, std::vector<unsigned int> t_indices, VertexFormat t_format) : vertices(std::move(t_vertices)), indices(std::move(t_indices)), format(t_format) {
     RebuildMesh();
 }
 
 void Starsurge::Mesh::RebuildMesh() {
-    float * gl_vertices = new float[NumberOfVertices()*12];
-
-    unsigned int index = 0;
-    for (unsigned int i = 0; i < NumberOfVertices(); ++i) {
-        Color col = this->vertices[i].Color.ToOpenGLFormat();
-        gl_vertices[index++] = this->vertices[i].Position[0];
-        gl_vertices[index++] = this->vertices[i].Position[1];
-        gl_vertices[index++] = this->vertices[i].Position[2];
-        gl_vertices[index++] = this->vertices[i].Normal[0];
-        gl_vertices[index++] = this->vertices[i].Normal[1];
-        gl_vertices[index++] = this->vertices[i].Normal[2];
-        gl_vertices[index++] = this->vertices[i].UV[0];
-        gl_vertices[index++] = this->vertices[i].UV[1];
-        gl_vertices[index++] = col[0];
-        gl_vertices[index++] = col[1];
-        gl_vertices[index++] = col[2];
-        gl_vertices[index++] = col[3];
-    }
-
-    unsigned int * gl_indices = &this->indices[0];
-
-    glGenVertexArrays(1, &this->VAO);
-    glGenBuffers(1, &this->VBO);
-    glGenBuffers(1, &this->EBO);
-    glBindVertexArray(this->VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
-    glBufferData(GL_ARRAY_BUFFER, NumberOfVertices()*12*sizeof(float), gl_vertices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, NumberOfIndices()*sizeof(unsigned int), gl_indices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 12 * sizeof(float), (void*)0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 12 * sizeof(float), (void*)(3*sizeof(float)));
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 12 * sizeof(float), (void*)(6*sizeof(float)));
-    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, 12 * sizeof(float), (void*)(8*sizeof(float)));
-    glEnableVertexAttribArray(0);
-    glEnableVertexAttribArray(1);
-    glEnableVertexAttribArray(2);
-    glEnableVertexAttribArray(3);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    this->dirtyVertices.Add(0, NumberOfVertices());
+    this->dirtyIndices.Add(0, NumberOfIndices());
+    this->formatDirty = true;
+    UpdateMesh();
+}
+
+void Starsurge::Mesh::UpdateMesh() {
+    if (this->pool != NULL) {
+        UpdateAllocation();
+    }
+    else if (!this->VAO.IsValid()) {
+        this->VAO = GLObject::Create(GLObjectType::VertexArray);
+        this->VBO = GLObject::Create(GLObjectType::Buffer);
+        this->EBO = GLObject::Create(GLObjectType::Buffer);
+        ResetBuffers();
+    }
+    // The element buffer binding is part of the VAO's state, so bind the VAO first.
+    GeometryRange buffers = GetBuffers();
+    GLStateCache::BindVertexArray(buffers.VAO);
+    GLStateCache::BindBuffer(GL_ARRAY_BUFFER, buffers.VBO);
+    GLStateCache::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.EBO);
+    if (!this->dirtyVertices.IsEmpty() || this->formatDirty) {
+        UploadVertices();
+    }
+    if (this->formatDirty) {
+        SetupAttributes();
+    }
+    // Crossing 65536 vertices switches the index width, which needs every index re-encoded.
+    if (GetRequiredIndexType() != this->indexType) {
+        this->dirtyIndices.Add(0, NumberOfIndices());
+    }
+    if (!this->dirtyIndices.IsEmpty()) {
+        UploadIndices();
+    }
+}
+
+void Starsurge::Mesh::ResetBuffers() {
+    // Fresh buffers have no storage, whatever this mesh (or the one it was moved from) had before.
+    this->vertexCapacity = this->indexCapacity = 0;
+    this->vertexUsage = this->indexUsage = this->indexType = 0;
+    this->formatDirty = true;
+    this->dirtyVertices.Add(0, NumberOfVertices());
+    this->dirtyIndices.Add(0, NumberOfIndices());
+}
+
+void Starsurge::Mesh::UpdateAllocation() {
+    const size_t indexBytes = NumberOfIndices() * ((GetRequiredIndexType() == GL_UNSIGNED_SHORT) ? sizeof(unsigned short) : sizeof(unsigned int));
+    if (this->allocation.IsValid()) {
+        GeometryRange range = this->allocation.GetRange();
+        if (range.Format == this->format && range.VertexCount == NumberOfVertices() && range.IndexBytes == indexBytes) {
+            return;
+        }
+    }
+    // Everything gets uploaded again anyway, so free first and let the new range reuse the space.
+    this->allocation.Reset();
+    this->allocation = this->pool->Allocate(this->format, NumberOfVertices(), indexBytes);
+    ResetBuffers();
+}
+
+void Starsurge::Mesh::WriteBuffer(unsigned int target, const void * data, size_t size, size_t begin, size_t end, size_t & capacity, unsigned int & usage) {
+    if (!this->allocation.IsValid()) {
+        UploadBuffer(target, data, size, begin, end, this->dynamic, capacity, usage);
+        return;
+    }
+    // The range was sized for exactly this data, the arena's usage hint covers every mesh in it.
+    GeometryRange range = this->allocation.GetRange();
+    size_t offset = (target == GL_ARRAY_BUFFER) ? range.VertexOffset : range.IndexOffset;
+    if (end > begin) {
+        glBufferSubData(target, offset + begin, end - begin, (const unsigned char*)data + begin);
+    }
+    capacity = size;
+    usage = GL_DYNAMIC_DRAW;
+}
+
+void Starsurge::Mesh::SetGeometryPool(GeometryPool * t_pool) {
+    if (t_pool == this->pool) {
+        return;
+    }
+    this->pool = t_pool;
+    this->allocation.Reset();
+    this->VAO.Reset();
+    this->VBO.Reset();
+    this->EBO.Reset();
+}
+
+Starsurge::GeometryPool * Starsurge::Mesh::GetGeometryPool() const {
+    return this->pool;
+}
+
+bool Starsurge::Mesh::IsDirty() const {
+    bool haveBuffers = (this->pool != NULL) ? this->allocation.IsValid() : this->VAO.IsValid();
+    return !haveBuffers || this->formatDirty || !this->dirtyVertices.IsEmpty() || !this->dirtyIndices.IsEmpty();
+}
+
+void Starsurge::Mesh::UploadVertices() {
+    const size_t stride = this->format.GetStride();
+    const size_t size = GetVertexBufferSize();
+    if (this->source != NULL) { // Already encoded.
+        WriteBuffer(GL_ARRAY_BUFFER, this->source->GetVertexData(), size, 0, size, this->vertexCapacity, this->vertexUsage);
+        this->dirtyVertices.Clear();
+        return;
+    }
+
+    bool whole = this->formatDirty || this->vertexCapacity != size;
+    size_t first = whole ? 0 : this->dirtyVertices.Begin;
+    size_t last = whole ? NumberOfVertices() : std::min<size_t>(this->dirtyVertices.End, NumberOfVertices());
+
+    if (!this->format.NeedsConversion()) { // Zero copy, GL reads the Vertex array directly.
+        std::vector<unsigned char>().swap(this->encodedVertices);
+        WriteBuffer(GL_ARRAY_BUFFER, this->vertices.data(), size, first*stride, last*stride, this->vertexCapacity, this->vertexUsage);
+        this->dirtyVertices.Clear();
+        return;
+    }
+
+    // Static meshes dropped their copy after the last upload, so they re-encode everything.
+    bool haveCopy = !this->formatDirty && this->encodedVertices.size() == size;
+    this->encodedVertices.resize(size);
+    if (!haveCopy && NumberOfVertices() > 0) {
+        EncodeVertices(this->vertices.data(), NumberOfVertices(), this->format, this->encodedVertices.data());
+    }
+    else if (last > first) {
+        EncodeVertices(&this->vertices[first], last - first, this->format, this->encodedVertices.data() + first*stride);
+    }
+
+    WriteBuffer(GL_ARRAY_BUFFER, this->encodedVertices.data(), size, first*stride, last*stride, this->vertexCapacity, this->vertexUsage);
+    this->dirtyVertices.Clear();
+    if (!this->dynamic) {
+        std::vector<unsigned char>().swap(this->encodedVertices);
+    }
+}
+
+void Starsurge::Mesh::UploadIndices() {
+    const unsigned int type = GetRequiredIndexType();
+    const size_t indexSize = (type == GL_UNSIGNED_SHORT) ? sizeof(unsigned short) : sizeof(unsigned int);
+    const size_t size = NumberOfIndices()*indexSize;
+    bool whole = type != this->indexType || this->indexCapacity != size;
+    size_t first = whole ? 0 : this->dirtyIndices.Begin;
+    size_t last = whole ? NumberOfIndices() : std::min<size_t>(this->dirtyIndices.End, NumberOfIndices());
+    last = std::max(first, last);
+    this->indexType = type;
+
+    if (this->source != NULL && this->source->GetHeader().IndexSize != indexSize) {
+        Materialize();
+    }
+    const void * data = this->indices.data();
+    if (this->source != NULL) {
+        data = this->source->GetIndexData();
+    }
+    else if (type == GL_UNSIGNED_SHORT) {
+        // Like the vertices, static meshes don't keep the narrowed copy around between updates.
+        bool haveCopy = !whole && this->shortIndices.size() == NumberOfIndices();
+        size_t from = haveCopy ? first : 0;
+        size_t to = haveCopy ? last : NumberOfIndices();
+        this->shortIndices.resize(NumberOfIndices());
+        for (size_t i = from; i < to; ++i) {
+            this->shortIndices[i] = (unsigned short)this->indices[i];
+        }
+        data = this->shortIndices.data();
+    }
+
+    WriteBuffer(GL_ELEMENT_ARRAY_BUFFER, data, size, first*indexSize, last*indexSize, this->indexCapacity, this->indexUsage);
+    this->dirtyIndices.Clear();
+    if (!this->dynamic || type != GL_UNSIGNED_SHORT) {
+        std::vector<unsigned short>().swap(this->shortIndices);
+    }
+}
+
+unsigned int Starsurge::Mesh::GetRequiredIndexType() const {
+    return (VertexCount() <= 65536) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+unsigned int Starsurge::Mesh::GetIndexType() const {
+    return (this->indexType != 0) ? this->indexType : GetRequiredIndexType();
+}
+
+size_t Starsurge::Mesh::GetIndexSize() const {
+    return (GetIndexType() == GL_UNSIGNED_SHORT) ? sizeof(unsigned short) : sizeof(unsigned int);
+}
+
+void Starsurge::Mesh::AddSubmesh(unsigned int firstIndex, unsigned int indexCount, unsigned int materialSlot) {
+    if (firstIndex + indexCount > IndexCount()) {
+        Error("Tried to add a submesh past the end of the mesh's indices.");
+        return;
+    }
+    Submesh submesh = { firstIndex, indexCount, materialSlot };
+    this->submeshes.push_back(submesh);
+}
+
+void Starsurge::Mesh::ClearSubmeshes() {
+    this->submeshes.clear();
+}
+
+const std::vector<Starsurge::Submesh>& Starsurge::Mesh::GetSubmeshes() const {
+    if (this->submeshes.empty()) {
+        Submesh whole = { 0, (unsigned int)IndexCount(), 0 };
+        this->wholeMesh.assign(1, whole);
+        return this->wholeMesh;
+    }
+    return this->submeshes;
+}
+
+unsigned int Starsurge::Mesh::NumberOfSubmeshes() const {
+    return this->submeshes.empty() ? 1 : this->submeshes.size();
+}
+
+void Starsurge::VertexFormat::SetupAttributes() const {
+    const size_t stride = GetStride();
+    AttributeLayout layouts[4] = {
+        GetPositionLayout(this->Position),
+        GetNormalLayout(this->Normal),
+        GetUVLayout(this->UV),
+        GetColorLayout(this->Color)
+    };
+    size_t offset = 0;
+    for (unsigned int i = 0; i < 4; ++i) {
+        glVertexAttribPointer(i, layouts[i].size, layouts[i].type, layouts[i].normalized, stride, (void*)offset);
+        glEnableVertexAttribArray(i);
+        offset += layouts[i].bytes;
+    }
+}
+
+void Starsurge::Mesh::SetupAttributes() {
+    // A pool arena's VAO was set up for its format when the arena was made.
+    if (!this->allocation.IsValid()) {
+        this->format.SetupAttributes();
+    }
+    this->formatDirty = false;
+}
+
+void Starsurge::Mesh::SetDynamic(bool t_dynamic) {
+    this->dynamic = t_dynamic;
+}
+
+bool Starsurge::Mesh::IsDynamic() const {
+    return this->dynamic;
+}
+
+const std::vector<Starsurge::Vertex>& Starsurge::Mesh::GetVertices() const {
+    Materialize();
+    return this->vertices;
+}
+
+const std::vector<unsigned int>& Starsurge::Mesh::GetIndices() const {
+    Materialize();
+    return this->indices;
+}
+
+Starsurge::Vertex Starsurge::Mesh::GetVertex(size_t i) const {
+    Materialize();
+    return this->vertices[i];
+}
+
+void Starsurge::Mesh::SetVertices(std::vector<Vertex> t_vertices) {
+    Materialize();
+    this->vertices = std::move(t_vertices);
+    this->dirtyVertices.Add(0, this->vertices.size());
+    this->boundsDirty = true;
+}
+
+void Starsurge::Mesh::SetVertices(size_t first, const Vertex * t_vertices, size_t count) {
+    Materialize();
+    if (first + count > this->vertices.size()) {
+        Error("Tried to set vertices past the end of the mesh.");
+        return;
+    }
+    std::copy(t_vertices, t_vertices + count, this->vertices.begin() + first);
+    this->dirtyVertices.Add(first, count);
+    this->boundsDirty = true;
+}
+
+void Starsurge::Mesh::SetVertex(size_t i, const Vertex& vertex) {
+    SetVertices(i, &vertex, 1);
+}
+
+void Starsurge::Mesh::SetIndices(std::vector<unsigned int> t_indices) {
+    Materialize();
+    this->indices = std::move(t_indices);
+    this->dirtyIndices.Add(0, this->indices.size());
+}
+
+void Starsurge::Mesh::SetIndices(size_t first, const unsigned int * t_indices, size_t count) {
+    Materialize();
+    if (first + count > this->indices.size()) {
+        Error("Tried to set indices past the end of the mesh.");
+        return;
+    }
+    std::copy(t_indices, t_indices + count, this->indices.begin() + first);
+    this->dirtyIndices.Add(first, count);
+}
+
+void Starsurge::Mesh::ComputeBounds() const {
+    ComputeVertexBounds(GetVertices(), this->boundsPositions, this->aabb, this->boundingSphere);
+    this->boundsDirty = false;
+}
+
+void Starsurge::Mesh::SetVertexFormat(VertexFormat t_format) {
+    if (t_format != this->format) { // The file's vertex block is only good for its own format.
+        Materialize();
+    }
+    this->format = t_format;
+    this->formatDirty = true;
+}
+
+Starsurge::VertexFormat Starsurge::Mesh::GetVertexFormat() const {
+    return this->format;
+}
+
+size_t Starsurge::Mesh::GetVertexBufferSize() const {
+    return VertexCount() * this->format.GetStride();
+}
+
+size_t Starsurge::Mesh::GetBytesSaved() const {
+    return VertexCount() * (VertexFormat::Full().GetStride() - this->format.GetStride());
+}
+
+Starsurge::GeometryRange Starsurge::Mesh::GetBuffers() const {
+    if (this->allocation.IsValid()) {
+        return this->allocation.GetRange();
+    }
+    GeometryRange buffers = {};
+    buffers.Format = this->format;
+    buffers.VAO = this->VAO.Get();
+    buffers.VBO = this->VBO.Get();
+    buffers.EBO = this->EBO.Get();
+    buffers.VertexCount = VertexCount();
+    buffers.IndexBytes = IndexCount() * GetIndexSize();
+    return buffers;
 }
 
 unsigned int Starsurge::Mesh::GetVAO() {
-    return this->VAO;
+    return this->allocation.IsValid() ? this->allocation.GetRange().VAO : this->VAO.Get();
 }
 
 unsigned int Starsurge::Mesh::GetVBO() {
-    return this->VBO;
+    return this->allocation.IsValid() ? this->allocation.GetRange().VBO : this->VBO.Get();
 }
 
 unsigned int Starsurge::Mesh::GetEBO() {
-    return this->EBO;
+    return this->allocation.IsValid() ? this->allocation.GetRange().EBO : this->EBO.Get();
+}
+
+unsigned int Starsurge::Mesh::GetBaseVertex() const {
+    return this->allocation.IsValid() ? this->allocation.GetRange().BaseVertex : 0;
+}
+
+size_t Starsurge::Mesh::GetIndexOffset() const {
+    return this->allocation.IsValid() ? this->allocation.GetRange().IndexOffset : 0;
 }
 
 unsigned int Starsurge::Mesh::NumberOfVertices() {
-    return this->vertices.size();
+    return VertexCount();
 }
 
 unsigned int Starsurge::Mesh::NumberOfIndices() {
-    return this->indices.size();
+    return IndexCount();
+}
+
+size_t Starsurge::Mesh::VertexCount() const {
+    return (this->source != NULL) ? this->source->GetHeader().VertexCount : this->vertices.size();
+}
+
+size_t Starsurge::Mesh::IndexCount() const {
+    return (this->source != NULL) ? this->source->GetHeader().IndexCount : this->indices.size();
+}
+
+void Starsurge::Mesh::Materialize() const {
+    if (this->source == NULL) {
+        return;
+    }
+    const MeshFileHeader & header = this->source->GetHeader();
+    this->vertices.resize(header.VertexCount);
+    if (!this->format.NeedsConversion()) {
+        std::memcpy((void*)this->vertices.data(), this->source->GetVertexData(), header.VertexBytes);
+    }
+    else {
+        DecodeVertices(this->source->GetVertexData(), header.VertexCount, this->format, this->vertices.data());
+    }
+    this->indices.resize(header.IndexCount);
+    if (header.IndexSize == 2) {
+        const unsigned short * shortIndices = (const unsigned short*)this->source->GetIndexData();
+        std::copy(shortIndices, shortIndices + header.IndexCount, this->indices.begin());
+    }
+    else {
+        std::memcpy(this->indices.data(), this->source->GetIndexData(), header.IndexBytes);
+    }
+    this->source.reset();
+}
+
+bool Starsurge::Mesh::Save(const std::string & path) const {
+    Materialize();
+    AABB box = GetAABB();
+    BoundingSphere sphere = GetBoundingSphere();
+    const unsigned char * vertexData = (const unsigned char*)this->vertices.data();
+    std::vector<unsigned char> encoded;
+    if (this->format.NeedsConversion()) {
+        encoded.resize(GetVertexBufferSize());
+        EncodeVertices(this->vertices.data(), this->vertices.size(), this->format, encoded.data());
+        vertexData = encoded.data();
+    }
+    return MeshFile::Write(path, this->format, vertexData, this->vertices.size(), this->indices, this->submeshes, box, sphere);
+}
+
+Starsurge::Mesh Starsurge::Mesh::Load(const std::string & path, bool checkIndices) {
+    std::shared_ptr<MeshFile> file = std::make_shared<MeshFile>();
+    if (!file->Open(path)) {
+        return Mesh();
+    }
+    const MeshFileHeader & header = file->GetHeader();
+    if (checkIndices) {
+        unsigned int maxIndex = 0;
+        if (header.IndexSize == 2) {
+            const unsigned short * shortIndices = (const unsigned short*)file->GetIndexData();
+            maxIndex = (header.IndexCount > 0) ? *std::max_element(shortIndices, shortIndices + header.IndexCount) : 0;
+        }
+        else {
+            const unsigned int * wideIndices = (const unsigned int*)file->GetIndexData();
+            maxIndex = (header.IndexCount > 0) ? *std::max_element(wideIndices, wideIndices + header.IndexCount) : 0;
+        }
+        if (header.IndexCount > 0 && maxIndex >= header.VertexCount) {
+            Error("Can't load mesh "+path+": index "+std::to_string(maxIndex)+" is past the last vertex.");
+            return Mesh();
+        }
+    }
+
+    Mesh mesh;
+    mesh.format = file->GetVertexFormat();
+    mesh.source = file;
+    std::vector<Submesh> submeshes = file->GetSubmeshes();
+    for (size_t i = 0; i < submeshes.size(); ++i) {
+        mesh.AddSubmesh(submeshes[i].FirstIndex, submeshes[i].IndexCount, submeshes[i].MaterialSlot);
+    }
+
+    mesh.aabb = file->GetAABB();
+    mesh.boundingSphere = file->GetBoundingSphere();
+    mesh.boundsDirty = false;
+    mesh.RebuildMesh();
+    return mesh;
 }
 
 Starsurge::Mesh Starsurge::Mesh::Triangle(Vector3 pt1, Vector3 pt2, Vector3 pt3) {
-    Vertex v1;
-    v1.Position = pt1;
-    v1.Normal = Vector3(0,0,0);
-    v1.UV = Vector2(0,0);
-    v1.Color = Colors::WHITE;
-    Vertex v2;
-    v2.Position = pt2;
-    v2.Normal = Vector3(0,0,0);
-    v2.UV = Vector2(0,0);
-    v2.Color = Colors::WHITE;
-    Vertex v3;
-    v3.Position = pt3;
-    v3.Normal = Vector3(0,0,0);
-    v3.UV = Vector2(0,0);
-    v3.Color = Colors::WHITE;
-    std::vector<Vertex> vertices = { v1, v2, v3 };
-    std::vector<unsigned int> indices = { 0, 1, 2 };
-    return Mesh(vertices, indices);
+    std::vector<Vertex> vertices(std::begin(TRIANGLE_VERTICES), std::end(TRIANGLE_VERTICES));
+    vertices[0].Position = pt1;
+    vertices[1].Position = pt2;
+    vertices[2].Position = pt3;
+    std::vector<unsigned int> indices(std::begin(TRIANGLE_INDICES), std::end(TRIANGLE_INDICES));
+    MeshNormals::GenerateNormals(vertices, indices);
+    return Mesh(std::move(vertices), std::move(indices));
 }
 
 Starsurge::Mesh Starsurge::Mesh::Quad(Vector3 pt1, Vector3 pt2, Vector3 pt3, Vector3 pt4) {
-    Vertex v1;
-    v1.Position = pt1;
-    v1.Normal = Vector3(0,0,0);
-    v1.UV = Vector2(0,0);
-    v1.Color = Color(255,0,0,255);
-    Vertex v2;
-    v2.Position = pt2;
-    v2.Normal = Vector3(0,0,0);
-    v2.UV = Vector2(0,0);
-    v2.Color = Color(0,255,0,255);
-    Vertex v3;
-    v3.Position = pt3;
-    v3.Normal = Vector3(0,0,0);
-    v3.UV = Vector2(0,0);
-    v3.Color = Color(0,0,255,255);
-    Vertex v4;
-    v4.Position = pt4;
-    v4.Normal = Vector3(0,0,0);
-    v4.UV = Vector2(0,0);
-    v4.Color = Color(255,0,255,255);
-    std::vector<Vertex> vertices = { v1, v2, v3, v4 };
-    std::vector<unsigned int> indices = { 0, 1, 3, 1, 2, 3 };
-    return Mesh(vertices, indices);
+    std::vector<Vertex> vertices(std::begin(QUAD_VERTICES), std::end(QUAD_VERTICES));
+    vertices[0].Position = pt1;
+    vertices[1].Position = pt2;
+    vertices[2].Position = pt3;
+    vertices[3].Position = pt4;
+    std::vector<unsigned int> indices(std::begin(QUAD_INDICES), std::end(QUAD_INDICES));
+    MeshNormals::GenerateNormals(vertices, indices);
+    return Mesh(std::move(vertices), std::move(indices));
+}
+
+Starsurge::AABB Starsurge::Mesh::GetAABB() const {
+    if (this->boundsDirty) {
+        ComputeBounds();
+    }
+    return this->aabb;
+}
+
+Starsurge::BoundingSphere Starsurge::Mesh::GetBoundingSphere() const {
+    if (this->boundsDirty) {
+        ComputeBounds();
+    }
+    return this->boundingSphere;
 }
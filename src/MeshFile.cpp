@@ -0,0 +1,151 @@
+#include <cstring>
+#include <fstream>
+#include "../include/MeshFile.h"
+#include "../include/Logging.h"
+
+static_assert(sizeof(Starsurge::Submesh) == 3*sizeof(uint32_t), "Submeshes are written to .ssm files as is.");
+
+namespace {
+    uint64_t AlignUp(uint64_t offset) {
+        return (offset + Starsurge::MESH_FILE_ALIGNMENT - 1) / Starsurge::MESH_FILE_ALIGNMENT * Starsurge::MESH_FILE_ALIGNMENT;
+    }
+
+    // A block is usable if it's aligned and lies entirely inside the file. Written to survive overflow
+    // from corrupt offsets.
+    bool BlockFits(uint64_t offset, uint64_t bytes, size_t fileSize) {
+        return offset % Starsurge::MESH_FILE_ALIGNMENT == 0 && offset <= fileSize && bytes <= fileSize - offset;
+    }
+}
+
+bool Starsurge::MeshFile::Open(const std::string & path) {
+    Close();
+    if (!this->file.Open(path)) {
+        return false;
+    }
+    const MeshFileHeader * h = (const MeshFileHeader*)this->file.GetData();
+    const size_t fileSize = this->file.GetSize();
+    std::string problem;
+    if (fileSize < sizeof(MeshFileHeader) || std::memcmp(h->Magic, MESH_FILE_MAGIC, sizeof(h->Magic)) != 0) {
+        problem = "it isn't a mesh file";
+    }
+    else if (h->Version != MESH_FILE_VERSION || h->HeaderSize < sizeof(MeshFileHeader)) {
+        problem = "unsupported version "+std::to_string(h->Version);
+    }
+    else if (h->PositionEncoding > (uint8_t)PositionEncoding::Half || h->NormalEncoding > (uint8_t)NormalEncoding::Octahedral ||
+        h->UVEncoding > (uint8_t)UVEncoding::UNorm16 || h->ColorEncoding > (uint8_t)ColorEncoding::UNorm8) {
+        problem = "unknown vertex encoding";
+    }
+    else if (h->IndexSize != 2 && h->IndexSize != 4) {
+        problem = "bad index size";
+    }
+    else {
+        this->header = h;
+        if (h->VertexStride != GetVertexFormat().GetStride() || h->VertexBytes != (uint64_t)h->VertexCount * h->VertexStride ||
+            h->IndexBytes != (uint64_t)h->IndexCount * h->IndexSize) {
+            problem = "block sizes don't match the header";
+        }
+        else if (!BlockFits(h->VertexOffset, h->VertexBytes, fileSize) || !BlockFits(h->IndexOffset, h->IndexBytes, fileSize) ||
+            !BlockFits(h->SubmeshOffset, (uint64_t)h->SubmeshCount * sizeof(Submesh), fileSize)) {
+            problem = "it's truncated";
+        }
+    }
+    if (!problem.empty()) {
+        Error("Can't load mesh "+path+": "+problem+".");
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void Starsurge::MeshFile::Close() {
+    this->file.Close();
+    this->header = NULL;
+}
+
+Starsurge::VertexFormat Starsurge::MeshFile::GetVertexFormat() const {
+    return { (PositionEncoding)this->header->PositionEncoding, (NormalEncoding)this->header->NormalEncoding,
+        (UVEncoding)this->header->UVEncoding, (ColorEncoding)this->header->ColorEncoding };
+}
+
+std::vector<Starsurge::Submesh> Starsurge::MeshFile::GetSubmeshes() const {
+    std::vector<Submesh> submeshes(this->header->SubmeshCount);
+    if (!submeshes.empty()) {
+        std::memcpy(submeshes.data(), this->file.GetData() + this->header->SubmeshOffset, submeshes.size()*sizeof(Submesh));
+    }
+    return submeshes;
+}
+
+Starsurge::AABB Starsurge::MeshFile::GetAABB() const {
+    return AABB(Vector3(this->header->BoundsMin), Vector3(this->header->BoundsMax));
+}
+
+Starsurge::BoundingSphere Starsurge::MeshFile::GetBoundingSphere() const {
+    return BoundingSphere(Vector3(this->header->SphereCenter), this->header->SphereRadius);
+}
+
+bool Starsurge::MeshFile::Write(const std::string & path, VertexFormat format, const unsigned char * vertexData, size_t vertexCount,
+    const std::vector<unsigned int> & indices, const std::vector<Submesh> & submeshes, const AABB & aabb, const BoundingSphere & sphere) {
+    // Loading can skip its own check for files written here.
+    for (size_t i = 0; i < indices.size(); ++i) {
+        if (indices[i] >= vertexCount) {
+            Error("Can't write mesh "+path+": index "+std::to_string(indices[i])+" is past the last vertex.");
+            return false;
+        }
+    }
+    // Same rule as Mesh::GetIndexType, so the index block is exactly what the EBO holds.
+    const uint32_t indexSize = (vertexCount <= 65536) ? 2 : 4;
+
+    MeshFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.Magic, MESH_FILE_MAGIC, sizeof(header.Magic));
+    header.Version = MESH_FILE_VERSION;
+    header.HeaderSize = sizeof(MeshFileHeader);
+    header.PositionEncoding = (uint8_t)format.Position;
+    header.NormalEncoding = (uint8_t)format.Normal;
+    header.UVEncoding = (uint8_t)format.UV;
+    header.ColorEncoding = (uint8_t)format.Color;
+    header.VertexCount = (uint32_t)vertexCount;
+    header.VertexStride = (uint32_t)format.GetStride();
+    header.IndexCount = (uint32_t)indices.size();
+    header.IndexSize = indexSize;
+    header.SubmeshCount = (uint32_t)submeshes.size();
+    header.VertexOffset = AlignUp(sizeof(MeshFileHeader));
+    header.VertexBytes = (uint64_t)header.VertexCount * header.VertexStride;
+    header.IndexOffset = AlignUp(header.VertexOffset + header.VertexBytes);
+    header.IndexBytes = (uint64_t)header.IndexCount * indexSize;
+    header.SubmeshOffset = AlignUp(header.IndexOffset + header.IndexBytes);
+    for (size_t i = 0; i < 3; ++i) {
+        header.BoundsMin[i] = aabb.Min[i];
+        header.BoundsMax[i] = aabb.Max[i];
+        header.SphereCenter[i] = sphere.Center[i];
+    }
+    header.SphereRadius = sphere.Radius;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        Error("Couldn't open "+path+" for writing.");
+        return false;
+    }
+    const char padding[MESH_FILE_ALIGNMENT] = {};
+    uint64_t written = 0;
+    auto writeBlock = [&](uint64_t offset, const void * data, uint64_t bytes) {
+        out.write(padding, offset - written);
+        out.write((const char*)data, bytes);
+        written = offset + bytes;
+    };
+    writeBlock(0, &header, sizeof(header));
+    writeBlock(header.VertexOffset, vertexData, header.VertexBytes);
+    if (indexSize == 2) {
+        std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+        writeBlock(header.IndexOffset, shortIndices.data(), header.IndexBytes);
+    }
+    else {
+        writeBlock(header.IndexOffset, indices.data(), header.IndexBytes);
+    }
+    writeBlock(header.SubmeshOffset, submeshes.data(), submeshes.size()*sizeof(Submesh));
+    if (!out) {
+        Error("Failed writing mesh "+path+".");
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include "../include/MeshNormals.h"
+
+namespace {
+    using Starsurge::Vertex;
+    using Starsurge::Vector3;
+
+    // Below this many triangles or vertices per worker, starting a thread costs more than the work.
+    const size_t MIN_ITEMS_PER_THREAD = 32768;
+    // UV triangles with less than this much (doubled) signed area have no usable gradient.
+    const float MIN_UV_AREA = 1e-12f;
+    const float PI = 3.14159265358979f;
+
+    // Runs func(first, end) over [0, count), split into contiguous ranges across threads. Callers only
+    // ever write to the items in their own range.
+    template<typename F>
+    void ForEachRange(size_t count, F func) {
+        size_t workers = std::min<size_t>(count / MIN_ITEMS_PER_THREAD, std::thread::hardware_concurrency());
+        if (workers <= 1) {
+            func(0, count);
+            return;
+        }
+        const size_t chunk = (count + workers - 1) / workers;
+        std::vector<std::thread> pool;
+        for (size_t begin = chunk; begin < count; begin += chunk) {
+            pool.emplace_back(func, begin, std::min(count, begin + chunk));
+        }
+        func(0, chunk);
+        for (size_t i = 0; i < pool.size(); ++i) {
+            pool[i].join();
+        }
+    }
+
+    // Splits the vertices into contiguous ranges, one per thread, and gives each thread every triangle
+    // that touches its range, in index order. triangle(tri, owned) gets a mask of which corners' vertices
+    // are in the range and only writes to those, then finish(first, end) wraps up the range. Every thread
+    // reads all the indices, but the sums need no atomics and each vertex adds up its triangles in the
+    // same order for any thread count. Triangles with an index past the last vertex are skipped.
+    template<typename Triangle, typename Finish>
+    void ForEachOwnedTriangle(const std::vector<unsigned int> & indices, size_t vertexCount, Triangle triangle, Finish finish) {
+        const size_t triangleCount = indices.size() / 3;
+        ForEachRange(vertexCount, [&](size_t first, size_t end) {
+            const size_t span = end - first;
+            for (size_t t = 0; t < triangleCount; ++t) {
+                const unsigned int * tri = &indices[t*3];
+                unsigned int owned = ((size_t)tri[0] - first < span) | ((size_t)tri[1] - first < span) << 1 | ((size_t)tri[2] - first < span) << 2;
+                if (owned != 0 && tri[0] < vertexCount && tri[1] < vertexCount && tri[2] < vertexCount) {
+                    triangle(tri, owned);
+                }
+            }
+            finish(first, end);
+        });
+    }
+
+    Vector3 Scaled(const Vector3 & v, float s) {
+        return Vector3(v[0]*s, v[1]*s, v[2]*s);
+    }
+
+    // v with its component along the unit vector n removed.
+    Vector3 Reject(const Vector3 & v, const Vector3 & n) {
+        return v - Scaled(n, Vector3::Dot(v, n));
+    }
+
+    // Any unit vector perpendicular to the unit vector n.
+    Vector3 Perpendicular(const Vector3 & n) {
+        Vector3 axis = (std::fabs(n[0]) < 0.9f) ? Vector3(1, 0, 0) : Vector3(0, 1, 0);
+        Vector3 ret = Reject(axis, n);
+        ret.Normalize();
+        return ret;
+    }
+
+    // The triangle's interior angles at each corner. Zero for degenerate triangles.
+    void CornerAngles(const Vector3 & p0, const Vector3 & p1, const Vector3 & p2, float * angles) {
+        Vector3 e01 = p1 - p0, e12 = p2 - p1, e20 = p0 - p2;
+        float l01 = e01.Magnitude(), l12 = e12.Magnitude(), l20 = e20.Magnitude();
+        if (l01 == 0 || l12 == 0 || l20 == 0) {
+            angles[0] = angles[1] = angles[2] = 0;
+            return;
+        }
+        angles[0] = std::acos(std::clamp(-Vector3::Dot(e01, e20) / (l01*l20), -1.0f, 1.0f));
+        angles[1] = std::acos(std::clamp(-Vector3::Dot(e12, e01) / (l12*l01), -1.0f, 1.0f));
+        angles[2] = std::max(0.0f, PI - angles[0] - angles[1]);
+    }
+}
+
+void Starsurge::MeshNormals::GenerateNormals(std::vector<Vertex> & vertices, const std::vector<unsigned int> & indices, NormalWeighting weighting) {
+    std::vector<Vector3> sums(vertices.size(), Vector3(0, 0, 0));
+    ForEachOwnedTriangle(indices, vertices.size(), [&](const unsigned int * tri, unsigned int owned) {
+        const Vector3 & p0 = vertices[tri[0]].Position;
+        const Vector3 & p1 = vertices[tri[1]].Position;
+        const Vector3 & p2 = vertices[tri[2]].Position;
+        // The cross product's length is twice the area.
+        Vector3 normal = Vector3::CrossProduct(p1 - p0, p2 - p0);
+        float weights[3] = { 1, 1, 1 };
+        if (weighting == NormalWeighting::Angle) {
+            float length = normal.Magnitude();
+            if (length > 0) {
+                normal = Scaled(normal, 1.0f / length);
+            }
+            CornerAngles(p0, p1, p2, weights);
+        }
+        for (size_t k = 0; k < 3; ++k) {
+            if (owned & (1 << k)) {
+                sums[tri[k]] += Scaled(normal, weights[k]);
+            }
+        }
+    }, [&](size_t first, size_t end) {
+        // Vertices without any non-degenerate triangle keep whatever normal they had.
+        for (size_t v = first; v < end; ++v) {
+            float length = sums[v].Magnitude();
+            if (length > 0) {
+                vertices[v].Normal = Scaled(sums[v], 1.0f / length);
+            }
+        }
+    });
+}
+
+void Starsurge::MeshNormals::GenerateNormals(Mesh & mesh, NormalWeighting weighting) {
+    std::vector<Vertex> vertices = mesh.GetVertices();
+    GenerateNormals(vertices, mesh.GetIndices(), weighting);
+    mesh.SetVertices(std::move(vertices));
+}
+
+std::vector<Starsurge::Vector4> Starsurge::MeshNormals::GenerateTangents(const std::vector<Vertex> & vertices, const std::vector<unsigned int> & indices) {
+    std::vector<Vector3> normals(vertices.size());
+    ForEachRange(vertices.size(), [&](size_t first, size_t end) {
+        for (size_t v = first; v < end; ++v) {
+            normals[v] = vertices[v].Normal;
+            if (normals[v].Magnitude() > 0) {
+                normals[v].Normalize();
+            }
+        }
+    });
+
+    // Each corner adds the triangle's U and V directions projected onto the vertex's tangent plane, at
+    // unit length and weighted by the corner angle.
+    std::vector<Vector3> tangents(vertices.size(), Vector3(0, 0, 0)), bitangents(vertices.size(), Vector3(0, 0, 0));
+    std::vector<Vector4> ret(vertices.size());
+    ForEachOwnedTriangle(indices, vertices.size(), [&](const unsigned int * tri, unsigned int owned) {
+        const Vertex & v0 = vertices[tri[0]], & v1 = vertices[tri[1]], & v2 = vertices[tri[2]];
+        Vector3 e1 = v1.Position - v0.Position, e2 = v2.Position - v0.Position;
+        float du1 = v1.UV[0] - v0.UV[0], dv1 = v1.UV[1] - v0.UV[1];
+        float du2 = v2.UV[0] - v0.UV[0], dv2 = v2.UV[1] - v0.UV[1];
+        float uvArea = du1*dv2 - du2*dv1;
+        if (std::fabs(uvArea) < MIN_UV_AREA) {
+            return;
+        }
+        // Solve e1 = du1*U + dv1*V, e2 = du2*U + dv2*V. Only directions matter, so skip dividing by the
+        // area and fix the sign instead.
+        float sign = (uvArea > 0) ? 1.0f : -1.0f;
+        Vector3 u = Scaled(Scaled(e1, dv2) - Scaled(e2, dv1), sign);
+        Vector3 v = Scaled(Scaled(e2, du1) - Scaled(e1, du2), sign);
+        float angles[3];
+        CornerAngles(v0.Position, v1.Position, v2.Position, angles);
+        for (size_t k = 0; k < 3; ++k) {
+            if (!(owned & (1 << k))) {
+                continue;
+            }
+            const Vector3 & n = normals[tri[k]];
+            Vector3 tangent = Reject(u, n), bitangent = Reject(v, n);
+            float tangentLength = tangent.Magnitude(), bitangentLength = bitangent.Magnitude();
+            if (tangentLength > 0) {
+                tangents[tri[k]] += Scaled(tangent, angles[k] / tangentLength);
+            }
+            if (bitangentLength > 0) {
+                bitangents[tri[k]] += Scaled(bitangent, angles[k] / bitangentLength);
+            }
+        }
+    }, [&](size_t first, size_t end) {
+        for (size_t i = first; i < end; ++i) {
+            const Vector3 & n = normals[i];
+            if (n.Magnitude() == 0) {
+                ret[i] = Vector4(1, 0, 0, 1);
+                continue;
+            }
+            Vector3 tangent = tangents[i];
+            if (tangent.Magnitude() > 1e-6f) {
+                tangent.Normalize();
+            }
+            else {
+                tangent = Perpendicular(n);
+            }
+            float handedness = (Vector3::Dot(Vector3::CrossProduct(n, tangent), bitangents[i]) < 0) ? -1.0f : 1.0f;
+            ret[i] = Vector4(tangent[0], tangent[1], tangent[2], handedness);
+        }
+    });
+    return ret;
+}
+
+std::vector<Starsurge::Vector4> Starsurge::MeshNormals::GenerateTangents(const Mesh & mesh) {
+    return GenerateTangents(mesh.GetVertices(), mesh.GetIndices());
+}
@@ -0,0 +1,469 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <unordered_set>
+#include "../include/MeshOptimizer.h"
+#include "../include/Logging.h"
+
+namespace {
+    using Starsurge::Vertex;
+    using Starsurge::Vector3;
+
+    // Forsyth's tuned constants, for an LRU cache a bit bigger than the hardware's.
+    const int SCORE_CACHE_SIZE = 32;
+    const float CACHE_DECAY_POWER = 1.5f;
+    const float LAST_TRIANGLE_SCORE = 0.75f;
+    const float VALENCE_BOOST_SCALE = 2.0f;
+    const float VALENCE_BOOST_POWER = 0.5f;
+
+    float VertexScore(int cachePosition, unsigned int remainingTriangles) {
+        if (remainingTriangles == 0) {
+            return -1;
+        }
+        float score = 0;
+        if (cachePosition >= 0) {
+            if (cachePosition < 3) { // Used by the last triangle, don't just redo its neighbour.
+                score = LAST_TRIANGLE_SCORE;
+            }
+            else {
+                float scaler = 1.0f / (SCORE_CACHE_SIZE - 3);
+                score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+            }
+        }
+        // Finish off vertices with few triangles left so they can leave the cache for good.
+        score += VALENCE_BOOST_SCALE * std::pow((float)remainingTriangles, -VALENCE_BOOST_POWER);
+        return score;
+    }
+
+    // Below this many vertices per worker, starting a thread costs more than the hashing.
+    const size_t MIN_WELD_VERTICES_PER_THREAD = 32768;
+
+    // The 12 floats of a vertex turned into comparable integers, either their exact bits or their epsilon
+    // grid cells.
+    struct WeldKeys {
+        const Vertex * vertices;
+        float invEpsilon;
+
+        void Get(unsigned int i, int64_t keys[12]) const {
+            const float * v = vertices[i].Position.GetData(); // Vertex is 12 packed floats.
+            for (size_t k = 0; k < 12; ++k) {
+                if (invEpsilon == 0) {
+                    float value = (v[k] == 0) ? 0.0f : v[k];
+                    uint32_t bits;
+                    std::memcpy(&bits, &value, sizeof(bits));
+                    keys[k] = bits;
+                }
+                else {
+                    keys[k] = (int64_t)std::floor(v[k] * invEpsilon + 0.5f);
+                }
+            }
+        }
+        uint64_t Hash(unsigned int i) const {
+            int64_t keys[12];
+            Get(i, keys);
+            uint64_t hash = 14695981039346656037ull;
+            for (size_t k = 0; k < 12; ++k) {
+                hash = (hash ^ (uint64_t)keys[k]) * 1099511628211ull;
+                hash ^= hash >> 29;
+            }
+            return hash;
+        }
+        bool Equal(unsigned int a, unsigned int b) const {
+            int64_t ka[12], kb[12];
+            Get(a, ka);
+            Get(b, kb);
+            return std::memcmp(ka, kb, sizeof(ka)) == 0;
+        }
+    };
+
+    // Finds the first vertex with the same key for every vertex whose hash lands in this shard.
+    void WeldShard(const WeldKeys & keys, const std::vector<uint64_t> & hashes, size_t shard, size_t shards, std::vector<unsigned int> & representative) {
+        auto hasher = [&hashes](unsigned int i) { return (size_t)hashes[i]; };
+        auto equal = [&keys, &hashes](unsigned int a, unsigned int b) { return hashes[a] == hashes[b] && keys.Equal(a, b); };
+        std::unordered_set<unsigned int, decltype(hasher), decltype(equal)> seen(16, hasher, equal);
+        for (size_t i = 0; i < hashes.size(); ++i) {
+            if (hashes[i] % shards != shard) {
+                continue;
+            }
+            // Vertices are visited in order, so the one already in the set is the earliest.
+            representative[i] = *seen.insert((unsigned int)i).first;
+        }
+    }
+
+    // Runs indices through a FIFO cache and returns how many vertices were transformed. A vertex is cached
+    // if it was inserted less than cacheSize insertions ago; resetting every timestamp to 0 with time past
+    // cacheSize empties the cache.
+    unsigned int SimulateFIFO(const unsigned int * indices, size_t count, unsigned int cacheSize, std::vector<unsigned int> & timestamps, unsigned int & time) {
+        unsigned int misses = 0;
+        for (size_t i = 0; i < count; ++i) {
+            unsigned int v = indices[i];
+            if (time - timestamps[v] >= cacheSize) {
+                timestamps[v] = time++;
+                misses++;
+            }
+        }
+        return misses;
+    }
+}
+
+Starsurge::VertexCacheStats Starsurge::MeshOptimizer::AnalyzeVertexCache(const std::vector<unsigned int> & indices, size_t vertexCount, unsigned int cacheSize) {
+    VertexCacheStats stats = { 0, 0, 0 };
+    std::vector<unsigned int> timestamps(vertexCount, 0);
+    unsigned int time = cacheSize + 1;
+    std::vector<bool> used(vertexCount, false);
+    size_t unique = 0;
+    size_t triangles = 0;
+    // Like MeshNormals, triangles pointing past the last vertex are skipped, and so is a partial one at
+    // the end.
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        const unsigned int * tri = &indices[t];
+        if (tri[0] >= vertexCount || tri[1] >= vertexCount || tri[2] >= vertexCount) {
+            continue;
+        }
+        for (size_t k = 0; k < 3; ++k) {
+            if (!used[tri[k]]) {
+                used[tri[k]] = true;
+                unique++;
+            }
+        }
+        stats.VerticesTransformed += SimulateFIFO(tri, 3, cacheSize, timestamps, time);
+        triangles++;
+    }
+    if (triangles == 0) {
+        return stats;
+    }
+    stats.ACMR = (float)stats.VerticesTransformed / triangles;
+    stats.ATVR = (float)stats.VerticesTransformed / unique;
+    return stats;
+}
+
+void Starsurge::MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int> & indices, size_t vertexCount) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // Triangles around each vertex, packed into one array. The first remaining[v] entries of a vertex's
+    // slice are the triangles it still has to emit.
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount*3; ++i) {
+        remaining[indices[i]]++;
+    }
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        offsets[v+1] = offsets[v] + remaining[v];
+    }
+    std::vector<unsigned int> adjacency(triangleCount*3);
+    std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        for (size_t k = 0; k < 3; ++k) {
+            unsigned int v = indices[t*3 + k];
+            adjacency[fill[v]++] = t;
+        }
+    }
+
+    std::vector<float> vertexScores(vertexCount);
+    std::vector<int> cachePositions(vertexCount, -1);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        vertexScores[v] = VertexScore(-1, remaining[v]);
+    }
+    std::vector<float> triangleScores(triangleCount);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        triangleScores[t] = vertexScores[indices[t*3]] + vertexScores[indices[t*3+1]] + vertexScores[indices[t*3+2]];
+    }
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> output;
+    output.reserve(triangleCount*3);
+    std::vector<unsigned int> cache, nextCache;
+    cache.reserve(SCORE_CACHE_SIZE + 3);
+    nextCache.reserve(SCORE_CACHE_SIZE + 3);
+    size_t cursor = 0; // Every triangle before this one has been emitted.
+
+    size_t best = 0;
+    float bestScore = triangleScores[0];
+    for (size_t t = 1; t < triangleCount; ++t) {
+        if (triangleScores[t] > bestScore) {
+            best = t;
+            bestScore = triangleScores[t];
+        }
+    }
+
+    for (size_t n = 0; n < triangleCount; ++n) {
+        if (bestScore < 0) { // Nothing in the cache connects to what's left, take the next one in order.
+            while (emitted[cursor]) {
+                cursor++;
+            }
+            best = cursor;
+        }
+
+        emitted[best] = true;
+        unsigned int tri[3] = { indices[best*3], indices[best*3+1], indices[best*3+2] };
+        nextCache.clear();
+        for (size_t k = 0; k < 3; ++k) {
+            unsigned int v = tri[k];
+            output.push_back(v);
+            nextCache.push_back(v);
+
+            // Drop the triangle from the vertex's remaining list.
+            unsigned int * list = &adjacency[offsets[v]];
+            for (unsigned int j = 0; j < remaining[v]; ++j) {
+                if (list[j] == best) {
+                    std::swap(list[j], list[remaining[v]-1]);
+                    break;
+                }
+            }
+            remaining[v]--;
+        }
+        // The LRU cache keeps its old order behind the triangle's vertices, and can overflow by up to three.
+        for (size_t i = 0; i < cache.size(); ++i) {
+            unsigned int v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2]) {
+                nextCache.push_back(v);
+            }
+        }
+        cache.swap(nextCache);
+
+        for (size_t i = 0; i < cache.size(); ++i) {
+            unsigned int v = cache[i];
+            cachePositions[v] = (i < (size_t)SCORE_CACHE_SIZE) ? (int)i : -1;
+            vertexScores[v] = VertexScore(cachePositions[v], remaining[v]);
+        }
+
+        // Only triangles touching the cache changed score, pick the best of them.
+        bestScore = -1;
+        for (size_t i = 0; i < cache.size(); ++i) {
+            unsigned int v = cache[i];
+            const unsigned int * list = &adjacency[offsets[v]];
+            for (unsigned int j = 0; j < remaining[v]; ++j) {
+                unsigned int t = list[j];
+                float score = vertexScores[indices[t*3]] + vertexScores[indices[t*3+1]] + vertexScores[indices[t*3+2]];
+                triangleScores[t] = score;
+                if (score > bestScore) {
+                    best = t;
+                    bestScore = score;
+                }
+            }
+        }
+        if (cache.size() > (size_t)SCORE_CACHE_SIZE) {
+            cache.resize(SCORE_CACHE_SIZE);
+        }
+    }
+
+    indices.swap(output);
+}
+
+void Starsurge::MeshOptimizer::OptimizeOverdraw(std::vector<unsigned int> & indices, const std::vector<Vertex> & vertices, float threshold) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // Hard boundaries: triangles where the cache simulation misses all three vertices, nothing is lost by
+    // cutting there.
+    std::vector<unsigned int> timestamps(vertices.size(), 0);
+    unsigned int time = DEFAULT_CACHE_SIZE + 1;
+    std::vector<size_t> hardClusters;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        unsigned int misses = SimulateFIFO(&indices[t*3], 3, DEFAULT_CACHE_SIZE, timestamps, time);
+        if (t == 0 || misses == 3) {
+            hardClusters.push_back(t);
+        }
+    }
+    hardClusters.push_back(triangleCount);
+
+    // Soft boundaries: within a hard cluster, cut again wherever the running ACMR is already within
+    // threshold of the whole cluster's.
+    std::vector<size_t> clusters;
+    for (size_t c = 0; c + 1 < hardClusters.size(); ++c) {
+        size_t begin = hardClusters[c], end = hardClusters[c+1];
+        std::fill(timestamps.begin(), timestamps.end(), 0);
+        time = DEFAULT_CACHE_SIZE + 1;
+        unsigned int clusterMisses = SimulateFIFO(&indices[begin*3], (end-begin)*3, DEFAULT_CACHE_SIZE, timestamps, time);
+        float clusterACMR = (float)clusterMisses / (end - begin);
+
+        std::fill(timestamps.begin(), timestamps.end(), 0);
+        time = DEFAULT_CACHE_SIZE + 1;
+        size_t start = begin;
+        unsigned int misses = 0;
+        clusters.push_back(begin);
+        for (size_t t = begin; t < end; ++t) {
+            misses += SimulateFIFO(&indices[t*3], 3, DEFAULT_CACHE_SIZE, timestamps, time);
+            size_t length = t + 1 - start;
+            if (t + 1 < end && length >= 8 && (float)misses / length <= clusterACMR * threshold) {
+                clusters.push_back(t + 1);
+                start = t + 1;
+                misses = 0;
+                std::fill(timestamps.begin(), timestamps.end(), 0);
+                time = DEFAULT_CACHE_SIZE + 1;
+            }
+        }
+    }
+    clusters.push_back(triangleCount);
+
+    // Sort clusters by how far they face away from the mesh's center, outer surfaces first.
+    Vector3 meshCenter(0, 0, 0);
+    float meshArea = 0;
+    std::vector<Vector3> centroids(clusters.size() - 1);
+    std::vector<Vector3> normals(clusters.size() - 1);
+    for (size_t c = 0; c + 1 < clusters.size(); ++c) {
+        Vector3 centroid(0, 0, 0), normal(0, 0, 0);
+        float area = 0;
+        for (size_t t = clusters[c]; t < clusters[c+1]; ++t) {
+            const Vector3 & a = vertices[indices[t*3]].Position;
+            const Vector3 & b = vertices[indices[t*3+1]].Position;
+            const Vector3 & p = vertices[indices[t*3+2]].Position;
+            Vector3 n = Vector3::CrossProduct(b - a, p - a);
+            float triangleArea = n.Magnitude();
+            Vector3 center = a + b + p;
+            centroid += Vector3(center[0]*triangleArea, center[1]*triangleArea, center[2]*triangleArea);
+            normal += n;
+            area += triangleArea;
+        }
+        meshCenter += centroid;
+        meshArea += area;
+        float inv = (area > 0) ? 1.0f / (3*area) : 0;
+        centroids[c] = Vector3(centroid[0]*inv, centroid[1]*inv, centroid[2]*inv);
+        float length = normal.Magnitude();
+        normals[c] = (length > 0) ? Vector3(normal[0]/length, normal[1]/length, normal[2]/length) : normal;
+    }
+    float invMesh = (meshArea > 0) ? 1.0f / (3*meshArea) : 0;
+    meshCenter = Vector3(meshCenter[0]*invMesh, meshCenter[1]*invMesh, meshCenter[2]*invMesh);
+
+    std::vector<size_t> order(clusters.size() - 1);
+    std::vector<float> keys(order.size());
+    for (size_t c = 0; c < order.size(); ++c) {
+        order[c] = c;
+        keys[c] = Vector3::Dot(centroids[c] - meshCenter, normals[c]);
+    }
+    std::stable_sort(order.begin(), order.end(), [&keys](size_t a, size_t b) { return keys[a] > keys[b]; });
+
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        size_t c = order[i];
+        output.insert(output.end(), indices.begin() + clusters[c]*3, indices.begin() + clusters[c+1]*3);
+    }
+    indices.swap(output);
+}
+
+size_t Starsurge::MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex> & vertices, std::vector<unsigned int> & indices) {
+    const unsigned int UNUSED = 0xFFFFFFFF;
+    std::vector<unsigned int> remap(vertices.size(), UNUSED);
+    std::vector<Vertex> output;
+    output.reserve(vertices.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+        unsigned int & target = remap[indices[i]];
+        if (target == UNUSED) {
+            target = output.size();
+            output.push_back(vertices[indices[i]]);
+        }
+        indices[i] = target;
+    }
+    vertices.swap(output);
+    return vertices.size();
+}
+
+Starsurge::WeldReport Starsurge::MeshOptimizer::WeldVertices(std::vector<Vertex> & vertices, std::vector<unsigned int> & indices, float epsilon) {
+    const size_t count = vertices.size();
+    WeldReport report = { count, count };
+    if (count == 0) {
+        return report;
+    }
+
+    WeldKeys keys = { vertices.data(), (epsilon > 0) ? 1.0f / epsilon : 0.0f };
+    std::vector<uint64_t> hashes(count);
+    std::vector<unsigned int> representative(count);
+    size_t workers = std::min<size_t>(count / MIN_WELD_VERTICES_PER_THREAD, std::thread::hardware_concurrency());
+    if (workers <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            hashes[i] = keys.Hash(i);
+        }
+        WeldShard(keys, hashes, 0, 1, representative);
+    }
+    else {
+        // Hash in contiguous chunks, then give each thread the vertices whose hash falls in its shard so
+        // equal vertices always meet in the same set.
+        std::vector<std::thread> pool;
+        const size_t chunk = (count + workers - 1) / workers;
+        for (size_t w = 0; w < workers; ++w) {
+            pool.emplace_back([&keys, &hashes, w, chunk, count]() {
+                for (size_t i = w*chunk; i < std::min(count, (w+1)*chunk); ++i) {
+                    hashes[i] = keys.Hash(i);
+                }
+            });
+        }
+        for (size_t w = 0; w < workers; ++w) {
+            pool[w].join();
+        }
+        pool.clear();
+        for (size_t w = 0; w < workers; ++w) {
+            pool.emplace_back(WeldShard, std::cref(keys), std::cref(hashes), w, workers, std::ref(representative));
+        }
+        for (size_t w = 0; w < workers; ++w) {
+            pool[w].join();
+        }
+    }
+
+    // Compact the survivors in order and point every duplicate at its survivor's new slot.
+    std::vector<unsigned int> remap(count);
+    size_t kept = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (representative[i] == i) {
+            remap[i] = kept;
+            vertices[kept++] = vertices[i];
+        }
+        else {
+            remap[i] = remap[representative[i]];
+        }
+    }
+    vertices.resize(kept);
+    for (size_t i = 0; i < indices.size(); ++i) {
+        indices[i] = remap[indices[i]];
+    }
+    report.VerticesAfter = kept;
+    return report;
+}
+
+Starsurge::WeldReport Starsurge::MeshOptimizer::WeldVertices(Mesh & mesh, float epsilon) {
+    std::vector<Vertex> vertices = mesh.GetVertices();
+    std::vector<unsigned int> indices = mesh.GetIndices();
+    WeldReport report = WeldVertices(vertices, indices, epsilon);
+    if (report.VerticesAfter != report.VerticesBefore) {
+        mesh.SetVertices(std::move(vertices));
+        mesh.SetIndices(std::move(indices));
+    }
+    float reduction = (report.VerticesBefore > 0) ? 100.0f * (report.VerticesBefore - report.VerticesAfter) / report.VerticesBefore : 0;
+    Log("Welded mesh: "+std::to_string(report.VerticesBefore)+" -> "+std::to_string(report.VerticesAfter)+
+        " vertices ("+std::to_string(reduction)+"% fewer).");
+    return report;
+}
+
+Starsurge::MeshOptimizerReport Starsurge::MeshOptimizer::Optimize(Mesh & mesh) {
+    std::vector<Vertex> vertices = mesh.GetVertices();
+    std::vector<unsigned int> indices = mesh.GetIndices();
+
+    MeshOptimizerReport report;
+    report.Before = AnalyzeVertexCache(indices, vertices.size());
+    // Triangles only move within their submesh, so every range still covers its own material's.
+    std::vector<Submesh> submeshes = mesh.GetSubmeshes();
+    std::vector<unsigned int> part;
+    for (size_t s = 0; s < submeshes.size(); ++s) {
+        std::vector<unsigned int>::iterator first = indices.begin() + submeshes[s].FirstIndex;
+        part.assign(first, first + submeshes[s].IndexCount);
+        OptimizeVertexCache(part, vertices.size());
+        OptimizeOverdraw(part, vertices);
+        std::copy(part.begin(), part.end(), first);
+    }
+    // Remapping only renames vertices, so it can run over every submesh at once.
+    OptimizeVertexFetch(vertices, indices);
+    report.After = AnalyzeVertexCache(indices, vertices.size());
+
+    mesh.SetVertices(std::move(vertices));
+    mesh.SetIndices(std::move(indices));
+    Log("Optimized mesh: ACMR "+std::to_string(report.Before.ACMR)+" -> "+std::to_string(report.After.ACMR)+
+        ", ATVR "+std::to_string(report.Before.ATVR)+" -> "+std::to_string(report.After.ATVR)+".");
+    return report;
+}
@@ -1,16 +1,182 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <algorithm>
 #include "../include/MeshRenderer.h"
+#include "../include/GLStateCache.h"
 
-Starsurge::MeshRenderer::MeshRenderer(Mesh * t_mesh, Material * t_mat) : Component(typeid(MeshRenderer).name()) {
+namespace {
+    // Where the shader prelude reads InstanceData from, see RenderQueue.
+    const unsigned int INSTANCE_MODEL_LOCATION = 4;
+    const unsigned int INSTANCE_COLOR_LOCATION = 8;
+}
+
+Starsurge::MeshRenderer::MeshRenderer(Mesh * t_mesh, Material * t_mat) : Component(typeid(MeshRenderer).name()), color(Colors::WHITE), currentLOD(0), lodHysteresis(0.1f) {
+    this->mesh = t_mesh;
+    this->materials.push_back(t_mat);
+}
+
+Starsurge::MeshRenderer::MeshRenderer(Mesh * t_mesh, std::vector<Material*> t_materials) : Component(typeid(MeshRenderer).name()), color(Colors::WHITE), currentLOD(0), lodHysteresis(0.1f) {
     this->mesh = t_mesh;
-    this->material = t_mat;
+    this->materials = t_materials;
+}
+
+void Starsurge::MeshRenderer::Render(const Matrix4 & model) {
+    Mesh * mesh = GetCurrentMesh();
+    if (mesh->IsDirty()) {
+        mesh->UpdateMesh();
+    }
+    GeometryRange buffers = mesh->GetBuffers();
+    GLStateCache::BindVertexArray(buffers.VAO);
+    // A RenderQueue or RenderInstanced may have left this VAO reading instances, go back to the generic
+    // values and set those instead.
+    RenderQueue::DisableInstanceAttributes();
+    const float * columns = model.GetData();
+    for (unsigned int i = 0; i < 4; ++i) {
+        glVertexAttrib4fv(INSTANCE_MODEL_LOCATION + i, columns + i*4);
+    }
+    Color tint = this->color.ToOpenGLFormat();
+    glVertexAttrib4f(INSTANCE_COLOR_LOCATION, tint[0], tint[1], tint[2], tint[3]);
+    DrawSubmeshes(mesh, buffers, 0);
+}
+
+void Starsurge::MeshRenderer::RenderInstanced(unsigned int instanceBuffer, size_t offset, unsigned int count) {
+    Mesh * mesh = GetCurrentMesh();
+    if (count == 0) {
+        return;
+    }
+    if (mesh->IsDirty()) {
+        mesh->UpdateMesh();
+    }
+    GeometryRange buffers = mesh->GetBuffers();
+    GLStateCache::BindVertexArray(buffers.VAO);
+    GLStateCache::BindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    RenderQueue::EnableInstanceAttributes();
+    RenderQueue::PointInstanceAttributes(offset);
+    DrawSubmeshes(mesh, buffers, count);
+}
+
+void Starsurge::MeshRenderer::Submit(RenderQueue & queue, const Matrix4 & model) {
+    Mesh * mesh = GetCurrentMesh();
+    const std::vector<Submesh> & submeshes = mesh->GetSubmeshes();
+    for (size_t i = 0; i < submeshes.size(); ++i) {
+        const Submesh & submesh = submeshes[i];
+        Material * material = GetMaterial(submesh.MaterialSlot);
+        if (submesh.FirstIndex + submesh.IndexCount > mesh->NumberOfIndices() || material == NULL) {
+            continue;
+        }
+        queue.Submit(mesh, submesh, i, material, model, this->color);
+    }
+}
+
+void Starsurge::MeshRenderer::DrawSubmeshes(Mesh * mesh, const GeometryRange & buffers, unsigned int instances) {
+    // Half floats and normalized integers are expanded by GL, only octahedral normals need the shader.
+    bool octahedral = mesh->GetVertexFormat().Normal == NormalEncoding::Octahedral;
+    const unsigned int indexType = mesh->GetIndexType();
+    const size_t indexSize = mesh->GetIndexSize();
+    // Pooled meshes share their buffers with other meshes, unpooled ones start at 0.
+    const size_t indexOffset = buffers.IndexOffset;
+    const int baseVertex = buffers.BaseVertex;
+
+    const std::vector<Submesh> & submeshes = mesh->GetSubmeshes();
+    Material * applied = NULL;
+    for (size_t i = 0; i < submeshes.size(); ++i) {
+        const Submesh & submesh = submeshes[i];
+        if (submesh.FirstIndex + submesh.IndexCount > mesh->NumberOfIndices()) {
+            continue;
+        }
+        Material * material = GetMaterial(submesh.MaterialSlot);
+        if (material == NULL) {
+            continue;
+        }
+        if (material != applied) { // Consecutive submeshes often share a material.
+            material->Apply();
+            material->GetShader()->SetOctahedralNormals(octahedral);
+            applied = material;
+        }
+        void * indices = (void*)(indexOffset + submesh.FirstIndex*indexSize);
+        if (instances == 0) {
+            glDrawElementsBaseVertex(GL_TRIANGLES, submesh.IndexCount, indexType, indices, baseVertex);
+        }
+        else {
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES, submesh.IndexCount, indexType, indices, instances, baseVertex);
+        }
+    }
+}
+
+Starsurge::Mesh * Starsurge::MeshRenderer::GetMesh() {
+    return this->mesh;
+}
+
+Starsurge::Material * Starsurge::MeshRenderer::GetMaterial(unsigned int slot) {
+    if (slot >= this->materials.size()) {
+        return NULL;
+    }
+    return this->materials[slot];
+}
+
+void Starsurge::MeshRenderer::SetMaterial(unsigned int slot, Material * t_mat) {
+    if (slot >= this->materials.size()) {
+        this->materials.resize(slot + 1, NULL);
+    }
+    this->materials[slot] = t_mat;
+}
+
+unsigned int Starsurge::MeshRenderer::NumberOfMaterials() {
+    return this->materials.size();
+}
+
+const std::vector<Starsurge::Material*> & Starsurge::MeshRenderer::GetMaterials() const {
+    return this->materials;
+}
+
+void Starsurge::MeshRenderer::SetColor(Color t_color) {
+    this->color = t_color;
+}
+
+Starsurge::Color Starsurge::MeshRenderer::GetColor() {
+    return this->color;
+}
+
+void Starsurge::MeshRenderer::AddLOD(Mesh * t_mesh, float t_screenSize) {
+    MeshLOD lod = { t_mesh, t_screenSize };
+    auto it = std::upper_bound(this->lods.begin(), this->lods.end(), lod, [](const MeshLOD & a, const MeshLOD & b) { return a.ScreenSize > b.ScreenSize; });
+    this->lods.insert(it, lod);
+}
+
+void Starsurge::MeshRenderer::ClearLODs() {
+    this->lods.clear();
+    this->currentLOD = 0;
+}
+
+unsigned int Starsurge::MeshRenderer::NumberOfLODs() {
+    return this->lods.size();
+}
+
+void Starsurge::MeshRenderer::SelectLOD(float screenSize) {
+    // LOD i (i > 0) starts below lods[i-1].ScreenSize. Going coarser needs the size to drop clearly under
+    // the next threshold, going finer needs it clearly over the current one.
+    const float h = this->lodHysteresis;
+    unsigned int lod = std::min(this->currentLOD, (unsigned int)this->lods.size());
+    while (lod < this->lods.size() && screenSize < this->lods[lod].ScreenSize * (1 - h)) {
+        lod++;
+    }
+    while (lod > 0 && screenSize > this->lods[lod-1].ScreenSize * (1 + h)) {
+        lod--;
+    }
+    this->currentLOD = lod;
+}
+
+void Starsurge::MeshRenderer::SetLODHysteresis(float t_hysteresis) {
+    this->lodHysteresis = std::max(0.0f, t_hysteresis);
+}
+
+unsigned int Starsurge::MeshRenderer::GetCurrentLOD() {
+    return this->currentLOD;
 }
 
-void Starsurge::MeshRenderer::Render() {
-    this->material->Apply();
-    glBindVertexArray(this->mesh->GetVAO());
-    //glDrawArrays(GL_TRIANGLES, 0, this->mesh->NumberOfVertices());
-    glDrawElements(GL_TRIANGLES, this->mesh->NumberOfIndices(), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+Starsurge::Mesh * Starsurge::MeshRenderer::GetCurrentMesh() {
+    if (this->currentLOD == 0 || this->currentLOD > this->lods.size()) {
+        return this->mesh;
+    }
+    return this->lods[this->currentLOD-1].LODMesh;
 }
@@ -0,0 +1,317 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include "../include/MeshSimplifier.h"
+#include "../include/MeshOptimizer.h"
+#include "../include/Logging.h"
+
+namespace {
+    using Starsurge::Vertex;
+    using Starsurge::Vector3;
+
+    // Sum of squared distances to a set of planes, weighted by the area of the triangle each came from.
+    struct Quadric {
+        double a2 = 0, ab = 0, ac = 0, ad = 0;
+        double b2 = 0, bc = 0, bd = 0;
+        double c2 = 0, cd = 0;
+        double d2 = 0;
+        double weight = 0;
+
+        void AddPlane(double a, double b, double c, double d, double w) {
+            a2 += w*a*a; ab += w*a*b; ac += w*a*c; ad += w*a*d;
+            b2 += w*b*b; bc += w*b*c; bd += w*b*d;
+            c2 += w*c*c; cd += w*c*d;
+            d2 += w*d*d;
+            weight += w;
+        }
+        void Add(const Quadric & q) {
+            a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+            b2 += q.b2; bc += q.bc; bd += q.bd;
+            c2 += q.c2; cd += q.cd;
+            d2 += q.d2;
+            weight += q.weight;
+        }
+        // Weighted mean squared distance from p to the planes.
+        double Error(const Vector3 & p) const {
+            double x = p[0], y = p[1], z = p[2];
+            double e = a2*x*x + 2*ab*x*y + 2*ac*x*z + 2*ad*x
+                + b2*y*y + 2*bc*y*z + 2*bd*y
+                + c2*z*z + 2*cd*z
+                + d2;
+            return (weight > 0) ? std::fabs(e) / weight : 0;
+        }
+    };
+
+    // cos(60 degrees).
+    const float MAX_NORMAL_TURN = 0.5f;
+    const float MIN_AREA_RATIO = 0.001f;
+
+    struct Collapse {
+        unsigned int from;
+        unsigned int to;
+        double cost;
+    };
+
+    uint64_t EdgeKey(unsigned int a, unsigned int b) {
+        return (a < b) ? ((uint64_t)a << 32 | b) : ((uint64_t)b << 32 | a);
+    }
+}
+
+std::vector<unsigned int> Starsurge::MeshSimplifier::Simplify(const std::vector<Vertex> & vertices, const std::vector<unsigned int> & indices, size_t targetIndexCount, float targetError, float * resultError) {
+    std::vector<unsigned int> result(indices);
+    const size_t vertexCount = vertices.size();
+    if (resultError != NULL) {
+        *resultError = 0;
+    }
+    if (result.size() <= targetIndexCount || vertexCount == 0) {
+        return result;
+    }
+
+    Vector3 min = vertices[0].Position, max = vertices[0].Position;
+    for (size_t i = 1; i < vertexCount; ++i) {
+        min = Vector3::Min(min, vertices[i].Position);
+        max = Vector3::Max(max, vertices[i].Position);
+    }
+    Vector3 size = max - min;
+    double extent = std::max(size[0], std::max(size[1], size[2]));
+    if (extent <= 0) {
+        extent = 1;
+    }
+    const double errorLimit = (double)targetError * extent * (double)targetError * extent;
+
+    // Vertices sharing a position form one point of the surface. Quadrics and topology work on these.
+    std::vector<unsigned int> positionId(vertexCount);
+    std::vector<unsigned int> groupSize(vertexCount, 0);
+    {
+        std::unordered_map<uint64_t, std::vector<unsigned int>> buckets;
+        for (size_t i = 0; i < vertexCount; ++i) {
+            const float * p = vertices[i].Position.GetData();
+            uint32_t bits[3];
+            std::memcpy(bits, p, sizeof(bits));
+            uint64_t hash = ((uint64_t)bits[0] * 73856093ull) ^ ((uint64_t)bits[1] * 19349663ull) ^ ((uint64_t)bits[2] * 83492791ull);
+            std::vector<unsigned int> & bucket = buckets[hash];
+            positionId[i] = i;
+            for (size_t j = 0; j < bucket.size(); ++j) {
+                // The same bits the hash used. Vector's operator== compares array addresses.
+                if (std::memcmp(vertices[bucket[j]].Position.GetData(), p, sizeof(bits)) == 0) {
+                    positionId[i] = bucket[j];
+                    break;
+                }
+            }
+            if (positionId[i] == i) {
+                bucket.push_back(i);
+            }
+            groupSize[positionId[i]]++;
+        }
+    }
+
+    // Lock seams, and borders: edges only one triangle uses.
+    std::vector<bool> lockedPosition(vertexCount, false);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        if (groupSize[positionId[i]] > 1) {
+            lockedPosition[positionId[i]] = true;
+        }
+    }
+    {
+        std::unordered_map<uint64_t, unsigned int> edgeUses;
+        for (size_t t = 0; t + 2 < result.size(); t += 3) {
+            for (size_t k = 0; k < 3; ++k) {
+                edgeUses[EdgeKey(positionId[result[t+k]], positionId[result[t+(k+1)%3]])]++;
+            }
+        }
+        for (auto it = edgeUses.begin(); it != edgeUses.end(); ++it) {
+            if (it->second == 1) {
+                lockedPosition[it->first >> 32] = true;
+                lockedPosition[it->first & 0xFFFFFFFF] = true;
+            }
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t t = 0; t + 2 < result.size(); t += 3) {
+        const Vector3 & p0 = vertices[result[t]].Position;
+        const Vector3 & p1 = vertices[result[t+1]].Position;
+        const Vector3 & p2 = vertices[result[t+2]].Position;
+        Vector3 normal = Vector3::CrossProduct(p1 - p0, p2 - p0);
+        float length = normal.Magnitude();
+        if (length == 0) {
+            continue;
+        }
+        double a = normal[0]/length, b = normal[1]/length, c = normal[2]/length;
+        double d = -(a*p0[0] + b*p0[1] + c*p0[2]);
+        for (size_t k = 0; k < 3; ++k) {
+            quadrics[positionId[result[t+k]]].AddPlane(a, b, c, d, length * 0.5);
+        }
+    }
+
+    // Each pass collapses an independent set of the cheapest edges: no two collapses touch the same
+    // triangles, so their costs and flip checks stay valid for the whole pass.
+    std::vector<unsigned int> remap(vertexCount);
+    std::vector<unsigned int> triangleOffsets(vertexCount + 1);
+    std::vector<unsigned int> triangleLists;
+    std::vector<unsigned char> touched(vertexCount);
+    std::vector<Collapse> candidates;
+    double maxError = 0;
+    const size_t targetTriangles = targetIndexCount / 3;
+    while (result.size() > targetIndexCount) {
+        size_t triangleCount = result.size() / 3;
+        std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+        for (size_t i = 0; i < result.size(); ++i) {
+            triangleOffsets[result[i] + 1]++;
+        }
+        for (size_t v = 0; v < vertexCount; ++v) {
+            triangleOffsets[v+1] += triangleOffsets[v];
+        }
+        triangleLists.resize(result.size());
+        std::vector<unsigned int> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+        for (size_t i = 0; i < result.size(); ++i) {
+            triangleLists[fill[result[i]]++] = i / 3;
+        }
+
+        candidates.clear();
+        for (size_t t = 0; t < triangleCount; ++t) {
+            for (size_t k = 0; k < 3; ++k) {
+                unsigned int from = result[t*3 + k];
+                unsigned int to = result[t*3 + (k+1)%3];
+                for (int dir = 0; dir < 2; ++dir) {
+                    if (!lockedPosition[positionId[from]]) {
+                        Quadric q = quadrics[positionId[from]];
+                        q.Add(quadrics[positionId[to]]);
+                        Collapse collapse = { from, to, q.Error(vertices[to].Position) };
+                        candidates.push_back(collapse);
+                    }
+                    std::swap(from, to);
+                }
+            }
+        }
+        if (candidates.empty()) {
+            break;
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Collapse & a, const Collapse & b) { return a.cost < b.cost; });
+
+        for (size_t v = 0; v < vertexCount; ++v) {
+            remap[v] = v;
+        }
+        std::fill(touched.begin(), touched.end(), 0);
+        size_t collapses = 0;
+        for (size_t c = 0; c < candidates.size() && triangleCount > targetTriangles; ++c) {
+            const Collapse & collapse = candidates[c];
+            if (collapse.cost > errorLimit) {
+                break;
+            }
+            if (touched[collapse.from] || touched[collapse.to]) {
+                continue;
+            }
+
+            // Moving from onto to must not flip any triangle that survives the collapse.
+            const Vector3 & target = vertices[collapse.to].Position;
+            bool flips = false;
+            size_t removed = 0;
+            for (unsigned int j = triangleOffsets[collapse.from]; j < triangleOffsets[collapse.from + 1]; ++j) {
+                const unsigned int * tri = &result[triangleLists[j]*3];
+                if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to) {
+                    removed++;
+                    continue;
+                }
+                Vector3 p[3] = { vertices[tri[0]].Position, vertices[tri[1]].Position, vertices[tri[2]].Position };
+                Vector3 before = Vector3::CrossProduct(p[1] - p[0], p[2] - p[0]);
+                for (size_t k = 0; k < 3; ++k) {
+                    if (tri[k] == collapse.from) {
+                        p[k] = target;
+                    }
+                }
+                Vector3 after = Vector3::CrossProduct(p[1] - p[0], p[2] - p[0]);
+                // Also reject turning the triangle more than 60 degrees, that's a fold in the making,
+                // and squashing it to a sliver whose normal is just rounding error.
+                float beforeArea = before.Magnitude(), afterArea = after.Magnitude();
+                if (afterArea < MIN_AREA_RATIO * beforeArea || Vector3::Dot(before, after) <= MAX_NORMAL_TURN * beforeArea * afterArea) {
+                    flips = true;
+                    break;
+                }
+            }
+            if (flips) {
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            quadrics[positionId[collapse.to]].Add(quadrics[positionId[collapse.from]]);
+            maxError = std::max(maxError, collapse.cost);
+            for (unsigned int j = triangleOffsets[collapse.from]; j < triangleOffsets[collapse.from + 1]; ++j) {
+                const unsigned int * tri = &result[triangleLists[j]*3];
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = 1;
+            }
+            triangleCount -= removed;
+            collapses++;
+        }
+        if (collapses == 0) {
+            break;
+        }
+
+        // Apply the collapses, dropping triangles that lost an edge.
+        size_t write = 0;
+        for (size_t t = 0; t + 2 < result.size(); t += 3) {
+            unsigned int a = remap[result[t]], b = remap[result[t+1]], c = remap[result[t+2]];
+            if (positionId[a] == positionId[b] || positionId[b] == positionId[c] || positionId[a] == positionId[c]) {
+                continue;
+            }
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    if (resultError != NULL) {
+        *resultError = (float)(std::sqrt(maxError) / extent);
+    }
+    return result;
+}
+
+std::vector<Starsurge::Mesh> Starsurge::MeshSimplifier::GenerateLODs(Mesh & mesh, unsigned int levels, float ratio, float maxError) {
+    const std::vector<Vertex> & vertices = mesh.GetVertices();
+    const std::vector<unsigned int> & indices = mesh.GetIndices();
+    std::vector<Submesh> submeshes = mesh.GetSubmeshes();
+    std::vector<std::vector<unsigned int>> parts(submeshes.size());
+    for (size_t s = 0; s < submeshes.size(); ++s) {
+        parts[s].assign(indices.begin() + submeshes[s].FirstIndex, indices.begin() + submeshes[s].FirstIndex + submeshes[s].IndexCount);
+    }
+
+    std::vector<Mesh> lods;
+    for (unsigned int level = 1; level <= levels; ++level) {
+        // Each level simplifies the previous one, so the chain stays consistent.
+        size_t before = 0, after = 0;
+        float error = 0;
+        for (size_t s = 0; s < parts.size(); ++s) {
+            before += parts[s].size();
+            size_t target = (size_t)(parts[s].size() / 3 * ratio) * 3;
+            float partError = 0;
+            parts[s] = Simplify(vertices, parts[s], target, maxError, &partError);
+            error = std::max(error, partError);
+            after += parts[s].size();
+        }
+        if (after >= before) {
+            break;
+        }
+
+        std::vector<unsigned int> lodIndices;
+        std::vector<Submesh> lodSubmeshes;
+        for (size_t s = 0; s < parts.size(); ++s) {
+            Submesh submesh = { (unsigned int)lodIndices.size(), (unsigned int)parts[s].size(), submeshes[s].MaterialSlot };
+            lodSubmeshes.push_back(submesh);
+            lodIndices.insert(lodIndices.end(), parts[s].begin(), parts[s].end());
+        }
+        std::vector<Vertex> lodVertices = vertices;
+        MeshOptimizer::OptimizeVertexFetch(lodVertices, lodIndices);
+
+        Mesh lod(std::move(lodVertices), std::move(lodIndices), mesh.GetVertexFormat());
+        lod.SetDynamic(mesh.IsDynamic());
+        for (size_t s = 0; s < lodSubmeshes.size(); ++s) {
+            lod.AddSubmesh(lodSubmeshes[s].FirstIndex, lodSubmeshes[s].IndexCount, lodSubmeshes[s].MaterialSlot);
+        }
+        lods.push_back(std::move(lod));
+        Log("LOD "+std::to_string(level)+": "+std::to_string(after/3)+" triangles, error "+std::to_string(error)+".");
+    }
+    return lods;
+}
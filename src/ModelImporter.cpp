@@ -0,0 +1,40 @@
+#include <algorithm>
+#include <cctype>
+#include "../include/ModelImporter.h"
+#include "../include/Logging.h"
+
+namespace {
+    std::string LowercaseExtension(const std::string & path) {
+        size_t dot = path.find_last_of('.');
+        if (dot == std::string::npos || path.find_first_of("/\\", dot) != std::string::npos) {
+            return "";
+        }
+        std::string extension = path.substr(dot + 1);
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+        return extension;
+    }
+}
+
+Starsurge::Mesh Starsurge::ModelImporter::Import(const std::string & path, VertexFormat format) {
+    ModelData model;
+    if (!Load(path, model)) {
+        return Mesh();
+    }
+    Mesh mesh(std::move(model.Vertices), std::move(model.Indices), format);
+    for (size_t i = 0; i < model.Submeshes.size(); ++i) {
+        mesh.AddSubmesh(model.Submeshes[i].FirstIndex, model.Submeshes[i].IndexCount, model.Submeshes[i].MaterialSlot);
+    }
+    return mesh;
+}
+
+bool Starsurge::ModelImporter::Load(const std::string & path, ModelData & model) {
+    std::string extension = LowercaseExtension(path);
+    if (extension == "obj") {
+        return LoadOBJ(path, model);
+    }
+    if (extension == "gltf" || extension == "glb") {
+        return LoadGLTF(path, model);
+    }
+    Error("Can't import "+path+": unknown model format.");
+    return false;
+}
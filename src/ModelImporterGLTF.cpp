@@ -0,0 +1,706 @@
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include "../include/ModelImporter.h"
+#include "../include/MeshOptimizer.h"
+#include "../include/MappedFile.h"
+#include "../include/Matrix.h"
+#include "../include/Quaternion.h"
+#include "../include/Logging.h"
+
+namespace {
+    using namespace Starsurge;
+
+    // Just enough JSON for glTF. Lookups of missing keys or indices give a null value, so chains like
+    // json.Get("scenes").At(0).Get("nodes") never need checking along the way.
+    struct JsonValue {
+        enum class Kind { Null, Bool, Number, String, Array, Object };
+        Kind Type = Kind::Null;
+        bool Boolean = false;
+        double Number = 0;
+        std::string String;
+        std::vector<JsonValue> Array;
+        std::vector<std::pair<std::string, JsonValue>> Object;
+
+        const JsonValue & Get(const char * key) const {
+            for (size_t i = 0; i < this->Object.size(); ++i) {
+                if (this->Object[i].first == key) {
+                    return this->Object[i].second;
+                }
+            }
+            return Null();
+        }
+        const JsonValue & At(size_t i) const { return (i < this->Array.size()) ? this->Array[i] : Null(); }
+        size_t Size() const { return this->Array.size(); }
+        bool IsNull() const { return this->Type == Kind::Null; }
+        double AsNumber(double fallback) const { return (this->Type == Kind::Number) ? this->Number : fallback; }
+        // Indices are stored as doubles, anything negative or fractional counts as missing.
+        size_t AsIndex(size_t fallback = SIZE_MAX) const {
+            if (this->Type != Kind::Number || this->Number < 0 || this->Number != std::floor(this->Number)) {
+                return fallback;
+            }
+            return (size_t)this->Number;
+        }
+
+        static const JsonValue & Null() {
+            static const JsonValue null;
+            return null;
+        }
+    };
+
+    class JsonParser {
+    public:
+        JsonParser(const char * t_begin, const char * t_end) : p(t_begin), end(t_end) {}
+
+        bool Parse(JsonValue & value) {
+            if (!ParseValue(value, 0)) {
+                return false;
+            }
+            SkipSpaces();
+            return this->p == this->end;
+        }
+    private:
+        static const int MAX_DEPTH = 256;
+
+        void SkipSpaces() {
+            while (this->p < this->end && (*this->p == ' ' || *this->p == '\t' || *this->p == '\n' || *this->p == '\r')) {
+                ++this->p;
+            }
+        }
+        bool Consume(const char * literal) {
+            size_t length = std::strlen(literal);
+            if ((size_t)(this->end - this->p) < length || std::strncmp(this->p, literal, length) != 0) {
+                return false;
+            }
+            this->p += length;
+            return true;
+        }
+        bool ParseValue(JsonValue & value, int depth) {
+            SkipSpaces();
+            if (this->p == this->end || depth > MAX_DEPTH) {
+                return false;
+            }
+            switch (*this->p) {
+                case '{': return ParseObject(value, depth);
+                case '[': return ParseArray(value, depth);
+                case '"':
+                    value.Type = JsonValue::Kind::String;
+                    return ParseString(value.String);
+                case 't':
+                    value.Type = JsonValue::Kind::Bool;
+                    value.Boolean = true;
+                    return Consume("true");
+                case 'f':
+                    value.Type = JsonValue::Kind::Bool;
+                    return Consume("false");
+                case 'n':
+                    return Consume("null");
+                default: {
+                    value.Type = JsonValue::Kind::Number;
+                    std::from_chars_result result = std::from_chars(this->p, this->end, value.Number);
+                    this->p = result.ptr;
+                    return result.ec == std::errc();
+                }
+            }
+        }
+        bool ParseObject(JsonValue & value, int depth) {
+            value.Type = JsonValue::Kind::Object;
+            ++this->p;
+            SkipSpaces();
+            if (this->p < this->end && *this->p == '}') {
+                ++this->p;
+                return true;
+            }
+            while (true) {
+                SkipSpaces();
+                std::pair<std::string, JsonValue> member;
+                if (this->p == this->end || *this->p != '"' || !ParseString(member.first)) {
+                    return false;
+                }
+                SkipSpaces();
+                if (!Consume(":") || !ParseValue(member.second, depth + 1)) {
+                    return false;
+                }
+                value.Object.push_back(std::move(member));
+                SkipSpaces();
+                if (Consume("}")) {
+                    return true;
+                }
+                if (!Consume(",")) {
+                    return false;
+                }
+            }
+        }
+        bool ParseArray(JsonValue & value, int depth) {
+            value.Type = JsonValue::Kind::Array;
+            ++this->p;
+            SkipSpaces();
+            if (this->p < this->end && *this->p == ']') {
+                ++this->p;
+                return true;
+            }
+            while (true) {
+                value.Array.emplace_back();
+                if (!ParseValue(value.Array.back(), depth + 1)) {
+                    return false;
+                }
+                SkipSpaces();
+                if (Consume("]")) {
+                    return true;
+                }
+                if (!Consume(",")) {
+                    return false;
+                }
+            }
+        }
+        bool ParseHex4(unsigned int & code) {
+            if (this->end - this->p < 4) {
+                return false;
+            }
+            std::from_chars_result result = std::from_chars(this->p, this->p + 4, code, 16);
+            if (result.ec != std::errc() || result.ptr != this->p + 4) {
+                return false;
+            }
+            this->p += 4;
+            return true;
+        }
+        static void AppendUTF8(std::string & out, unsigned int code) {
+            if (code < 0x80) {
+                out += (char)code;
+            }
+            else if (code < 0x800) {
+                out += (char)(0xC0 | (code >> 6));
+                out += (char)(0x80 | (code & 0x3F));
+            }
+            else if (code < 0x10000) {
+                out += (char)(0xE0 | (code >> 12));
+                out += (char)(0x80 | ((code >> 6) & 0x3F));
+                out += (char)(0x80 | (code & 0x3F));
+            }
+            else {
+                out += (char)(0xF0 | (code >> 18));
+                out += (char)(0x80 | ((code >> 12) & 0x3F));
+                out += (char)(0x80 | ((code >> 6) & 0x3F));
+                out += (char)(0x80 | (code & 0x3F));
+            }
+        }
+        bool ParseString(std::string & out) {
+            ++this->p;
+            while (this->p < this->end && *this->p != '"') {
+                char c = *this->p++;
+                if (c != '\\') {
+                    out += c;
+                    continue;
+                }
+                if (this->p == this->end) {
+                    return false;
+                }
+                c = *this->p++;
+                switch (c) {
+                    case '"': case '\\': case '/': out += c; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'n': out += '\n'; break;
+                    case 'r': out += '\r'; break;
+                    case 't': out += '\t'; break;
+                    case 'u': {
+                        unsigned int code;
+                        if (!ParseHex4(code)) {
+                            return false;
+                        }
+                        if (code >= 0xD800 && code < 0xDC00) { // High surrogate, the low half follows.
+                            unsigned int low;
+                            if (!Consume("\\u") || !ParseHex4(low) || low < 0xDC00 || low >= 0xE000) {
+                                return false;
+                            }
+                            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        AppendUTF8(out, code);
+                        break;
+                    }
+                    default: return false;
+                }
+            }
+            if (this->p == this->end) {
+                return false;
+            }
+            ++this->p;
+            return true;
+        }
+
+        const char * p;
+        const char * end;
+    };
+
+    // A glTF buffer: part of the .glb, a mapped .bin file, or a decoded data: URI.
+    struct Buffer {
+        const unsigned char * Data = NULL;
+        size_t Size = 0;
+        std::unique_ptr<MappedFile> File;
+        std::vector<unsigned char> Decoded;
+    };
+
+    bool DecodeBase64(const std::string & text, size_t begin, std::vector<unsigned char> & out) {
+        unsigned int bits = 0;
+        int count = 0;
+        for (size_t i = begin; i < text.size(); ++i) {
+            char c = text[i];
+            int value;
+            if (c >= 'A' && c <= 'Z') value = c - 'A';
+            else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+            else if (c >= '0' && c <= '9') value = c - '0' + 52;
+            else if (c == '+' || c == '-') value = 62;
+            else if (c == '/' || c == '_') value = 63;
+            else if (c == '=') break;
+            else return false;
+            bits = (bits << 6) | value;
+            count += 6;
+            if (count >= 8) {
+                count -= 8;
+                out.push_back((unsigned char)(bits >> count));
+            }
+        }
+        return true;
+    }
+
+    // URIs are relative to the file and may be percent encoded.
+    std::string ResolveURI(const std::string & path, const std::string & uri) {
+        std::string decoded;
+        for (size_t i = 0; i < uri.size(); ++i) {
+            unsigned int code;
+            if (uri[i] == '%' && i + 2 < uri.size() && std::from_chars(uri.data() + i + 1, uri.data() + i + 3, code, 16).ec == std::errc()) {
+                decoded += (char)code;
+                i += 2;
+            }
+            else {
+                decoded += uri[i];
+            }
+        }
+        size_t slash = path.find_last_of("/\\");
+        return (slash == std::string::npos) ? decoded : path.substr(0, slash + 1) + decoded;
+    }
+
+    size_t ComponentSize(size_t componentType) {
+        switch (componentType) {
+            case 5120: case 5121: return 1; // BYTE, UNSIGNED_BYTE
+            case 5122: case 5123: return 2; // SHORT, UNSIGNED_SHORT
+            case 5125: case 5126: return 4; // UNSIGNED_INT, FLOAT
+            default: return 0;
+        }
+    }
+
+    size_t ComponentCount(const std::string & type) {
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2") return 2;
+        if (type == "VEC3") return 3;
+        if (type == "VEC4") return 4;
+        return 0;
+    }
+
+    // A validated view of one accessor's elements.
+    struct Accessor {
+        const unsigned char * Data = NULL;
+        size_t Count = 0;
+        size_t Stride = 0;
+        size_t ComponentType = 0;
+        size_t Components = 0;
+        bool Normalized = false;
+
+        float Read(size_t element, size_t component) const {
+            const unsigned char * src = this->Data + element*this->Stride + component*ComponentSize(this->ComponentType);
+            switch (this->ComponentType) {
+                case 5120: { int8_t v; std::memcpy(&v, src, 1); return this->Normalized ? std::fmax(v / 127.0f, -1.0f) : v; }
+                case 5121: { return this->Normalized ? src[0] / 255.0f : src[0]; }
+                case 5122: { int16_t v; std::memcpy(&v, src, 2); return this->Normalized ? std::fmax(v / 32767.0f, -1.0f) : v; }
+                case 5123: { uint16_t v; std::memcpy(&v, src, 2); return this->Normalized ? v / 65535.0f : v; }
+                case 5125: { uint32_t v; std::memcpy(&v, src, 4); return (float)v; }
+                default: { float v; std::memcpy(&v, src, 4); return v; }
+            }
+        }
+        uint32_t ReadIndex(size_t element) const {
+            const unsigned char * src = this->Data + element*this->Stride;
+            switch (this->ComponentType) {
+                case 5121: return src[0];
+                case 5123: { uint16_t v; std::memcpy(&v, src, 2); return v; }
+                default: { uint32_t v; std::memcpy(&v, src, 4); return v; }
+            }
+        }
+    };
+
+    struct Document {
+        JsonValue Json;
+        std::vector<Buffer> Buffers;
+
+        bool GetAccessor(size_t index, Accessor & accessor) const {
+            const JsonValue & a = this->Json.Get("accessors").At(index);
+            if (a.IsNull() || !a.Get("sparse").IsNull()) {
+                return false;
+            }
+            accessor.Count = a.Get("count").AsIndex(0);
+            accessor.ComponentType = a.Get("componentType").AsIndex(0);
+            accessor.Components = ComponentCount(a.Get("type").String);
+            accessor.Normalized = a.Get("normalized").Boolean;
+            const size_t elementSize = ComponentSize(accessor.ComponentType) * accessor.Components;
+            if (elementSize == 0) {
+                return false;
+            }
+
+            const JsonValue & view = this->Json.Get("bufferViews").At(a.Get("bufferView").AsIndex());
+            size_t bufferIndex = view.Get("buffer").AsIndex();
+            if (view.IsNull() || bufferIndex >= this->Buffers.size()) {
+                return false;
+            }
+            const Buffer & buffer = this->Buffers[bufferIndex];
+            size_t viewOffset = view.Get("byteOffset").AsIndex(0);
+            size_t viewLength = view.Get("byteLength").AsIndex(0);
+            size_t offset = a.Get("byteOffset").AsIndex(0);
+            accessor.Stride = view.Get("byteStride").AsIndex(elementSize);
+            // Everything the accessor touches has to be inside the view, and the view inside the buffer.
+            if (viewOffset > buffer.Size || viewLength > buffer.Size - viewOffset || accessor.Stride < elementSize) {
+                return false;
+            }
+            if (accessor.Count > 0 && (offset > viewLength || viewLength - offset < elementSize ||
+                accessor.Count - 1 > (viewLength - offset - elementSize) / accessor.Stride)) {
+                return false;
+            }
+            accessor.Data = buffer.Data + viewOffset + offset;
+            return true;
+        }
+    };
+
+    bool LoadBuffers(const std::string & path, const unsigned char * glbData, size_t glbSize, Document & doc) {
+        const JsonValue & buffers = doc.Json.Get("buffers");
+        doc.Buffers.resize(buffers.Size());
+        for (size_t i = 0; i < buffers.Size(); ++i) {
+            const JsonValue & uri = buffers.At(i).Get("uri");
+            Buffer & buffer = doc.Buffers[i];
+            if (uri.IsNull()) { // The .glb's own binary chunk.
+                if (i != 0 || glbData == NULL) {
+                    return false;
+                }
+                buffer.Data = glbData;
+                buffer.Size = glbSize;
+            }
+            else if (uri.String.compare(0, 5, "data:") == 0) {
+                size_t comma = uri.String.find(',');
+                if (comma == std::string::npos || uri.String.rfind(";base64", comma) == std::string::npos ||
+                    !DecodeBase64(uri.String, comma + 1, buffer.Decoded)) {
+                    return false;
+                }
+                buffer.Data = buffer.Decoded.data();
+                buffer.Size = buffer.Decoded.size();
+            }
+            else {
+                buffer.File.reset(new MappedFile());
+                if (!buffer.File->Open(ResolveURI(path, uri.String))) {
+                    return false;
+                }
+                buffer.Data = buffer.File->GetData();
+                buffer.Size = buffer.File->GetSize();
+            }
+            // byteLength is the size the views were laid out against, the data may have trailing padding.
+            size_t declared = buffers.At(i).Get("byteLength").AsIndex(0);
+            if (declared > buffer.Size) {
+                return false;
+            }
+            buffer.Size = declared;
+        }
+        return true;
+    }
+
+    // One primitive of one mesh instance, and where its output goes.
+    struct PrimitiveJob {
+        const JsonValue * Primitive;
+        Matrix4 World;
+        unsigned int MaterialSlot;
+        size_t VertexCount;
+        size_t IndexCount;
+        size_t FirstVertex;
+        size_t FirstIndex;
+    };
+
+    Matrix4 LocalTransform(const JsonValue & node) {
+        const JsonValue & matrix = node.Get("matrix");
+        if (matrix.Size() == 16) { // Column-major, same as Matrix4.
+            Matrix4 ret;
+            for (size_t i = 0; i < 16; ++i) {
+                ret.GetData()[i] = (float)matrix.At(i).AsNumber(0);
+            }
+            return ret;
+        }
+        const JsonValue & t = node.Get("translation");
+        const JsonValue & r = node.Get("rotation");
+        const JsonValue & s = node.Get("scale");
+        Vector3 translation(t.At(0).AsNumber(0), t.At(1).AsNumber(0), t.At(2).AsNumber(0));
+        Quaternion rotation(r.At(0).AsNumber(0), r.At(1).AsNumber(0), r.At(2).AsNumber(0), r.At(3).AsNumber(1));
+        Vector3 scale(s.At(0).AsNumber(1), s.At(1).AsNumber(1), s.At(2).AsNumber(1));
+        return Matrix4::TRS(translation, rotation, scale);
+    }
+
+    class SceneFlattener {
+    public:
+        SceneFlattener(const Document & t_doc, ModelData & t_model) : doc(t_doc), model(t_model) {}
+
+        bool Gather() {
+            const JsonValue & json = this->doc.Json;
+            const JsonValue & scenes = json.Get("scenes");
+            if (scenes.Size() == 0) { // No scene graph, take every mesh as is.
+                for (size_t m = 0; m < json.Get("meshes").Size(); ++m) {
+                    if (!AddMesh(m, Matrix4::Identity())) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            const JsonValue & roots = scenes.At(json.Get("scene").AsIndex(0)).Get("nodes");
+            for (size_t i = 0; i < roots.Size(); ++i) {
+                if (!AddNode(roots.At(i).AsIndex(), Matrix4::Identity(), 0)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        std::vector<PrimitiveJob> Jobs;
+    private:
+        bool AddNode(size_t index, const Matrix4 & parent, size_t depth) {
+            const JsonValue & node = this->doc.Json.Get("nodes").At(index);
+            if (node.IsNull() || depth > this->doc.Json.Get("nodes").Size()) { // Deeper than the node count means a cycle.
+                return false;
+            }
+            Matrix4 world = parent * LocalTransform(node);
+            if (!node.Get("mesh").IsNull() && !AddMesh(node.Get("mesh").AsIndex(), world)) {
+                return false;
+            }
+            const JsonValue & children = node.Get("children");
+            for (size_t i = 0; i < children.Size(); ++i) {
+                if (!AddNode(children.At(i).AsIndex(), world, depth + 1)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool AddMesh(size_t index, const Matrix4 & world) {
+            const JsonValue & primitives = this->doc.Json.Get("meshes").At(index).Get("primitives");
+            if (primitives.Size() == 0) {
+                return false;
+            }
+            for (size_t i = 0; i < primitives.Size(); ++i) {
+                const JsonValue & primitive = primitives.At(i);
+                if (primitive.Get("mode").AsIndex(4) != 4) {
+                    Log("Skipping a glTF primitive that isn't a triangle list.");
+                    continue;
+                }
+                Accessor positions, indices;
+                if (!this->doc.GetAccessor(primitive.Get("attributes").Get("POSITION").AsIndex(), positions) || positions.Components != 3) {
+                    return false;
+                }
+                const JsonValue & indexAccessor = primitive.Get("indices");
+                if (!indexAccessor.IsNull() && (!this->doc.GetAccessor(indexAccessor.AsIndex(), indices) || indices.Components != 1 ||
+                    (indices.ComponentType != 5121 && indices.ComponentType != 5123 && indices.ComponentType != 5125))) {
+                    return false;
+                }
+                PrimitiveJob job;
+                job.Primitive = &primitive;
+                job.World = world;
+                job.MaterialSlot = MaterialSlot(primitive.Get("material"));
+                job.VertexCount = positions.Count;
+                job.IndexCount = indexAccessor.IsNull() ? positions.Count : indices.Count;
+                job.IndexCount -= job.IndexCount % 3;
+                job.FirstVertex = this->vertexCount;
+                job.FirstIndex = this->indexCount;
+                this->vertexCount += job.VertexCount;
+                this->indexCount += job.IndexCount;
+                this->Jobs.push_back(job);
+            }
+            return true;
+        }
+
+        // glTF material index to a slot in model.MaterialNames, in order of first use.
+        unsigned int MaterialSlot(const JsonValue & material) {
+            size_t index = material.AsIndex();
+            std::string name;
+            if (index != SIZE_MAX) {
+                name = this->doc.Json.Get("materials").At(index).Get("name").String;
+                if (name.empty()) {
+                    name = "material" + std::to_string(index);
+                }
+            }
+            for (size_t i = 0; i < this->model.MaterialNames.size(); ++i) {
+                if (this->model.MaterialNames[i] == name) {
+                    return i;
+                }
+            }
+            this->model.MaterialNames.push_back(name);
+            return this->model.MaterialNames.size() - 1;
+        }
+
+        const Document & doc;
+        ModelData & model;
+        size_t vertexCount = 0;
+        size_t indexCount = 0;
+    };
+
+    bool ConvertPrimitive(const Document & doc, const PrimitiveJob & job, ModelData & model) {
+        const JsonValue & attributes = job.Primitive->Get("attributes");
+        Accessor positions, normals, uvs, colors, indices;
+        doc.GetAccessor(attributes.Get("POSITION").AsIndex(), positions);
+        bool hasNormals = doc.GetAccessor(attributes.Get("NORMAL").AsIndex(), normals) && normals.Components == 3 && normals.Count == positions.Count;
+        bool hasUVs = doc.GetAccessor(attributes.Get("TEXCOORD_0").AsIndex(), uvs) && uvs.Components == 2 && uvs.Count == positions.Count;
+        bool hasColors = doc.GetAccessor(attributes.Get("COLOR_0").AsIndex(), colors) && colors.Components >= 3 && colors.Count == positions.Count;
+        bool hasIndices = doc.GetAccessor(job.Primitive->Get("indices").AsIndex(), indices);
+
+        // Normals go through the inverse transpose, which is the cofactor matrix divided by the determinant.
+        // Only the determinant's sign matters since the normals are renormalized.
+        const Matrix4 & m = job.World;
+        Vector3 c0(m(0,0), m(1,0), m(2,0)), c1(m(0,1), m(1,1), m(2,1)), c2(m(0,2), m(1,2), m(2,2));
+        Vector3 n0 = Vector3::CrossProduct(c1, c2), n1 = Vector3::CrossProduct(c2, c0), n2 = Vector3::CrossProduct(c0, c1);
+        const bool mirrored = Vector3::Dot(c0, n0) < 0;
+        const float sign = mirrored ? -1.0f : 1.0f;
+
+        Vertex * out = &model.Vertices[job.FirstVertex];
+        for (size_t i = 0; i < job.VertexCount; ++i) {
+            Vertex & v = out[i];
+            v.Position = m.TransformPoint(Vector3(positions.Read(i, 0), positions.Read(i, 1), positions.Read(i, 2)));
+            if (hasNormals) {
+                float x = sign*normals.Read(i, 0), y = sign*normals.Read(i, 1), z = sign*normals.Read(i, 2);
+                Vector3 n(n0[0]*x + n1[0]*y + n2[0]*z, n0[1]*x + n1[1]*y + n2[1]*z, n0[2]*x + n1[2]*y + n2[2]*z);
+                if (n.Magnitude() > 0) {
+                    n.Normalize();
+                }
+                v.Normal = n;
+            }
+            else {
+                v.Normal = Vector3(0, 0, 0);
+            }
+            v.UV = hasUVs ? Vector2(uvs.Read(i, 0), uvs.Read(i, 1)) : Vector2(0, 0);
+            if (hasColors) {
+                // glTF colors are linear 0-1 floats or normalized integers, Color is 0-255.
+                float alpha = (colors.Components == 4) ? colors.Read(i, 3) : 1.0f;
+                v.Color = Color(colors.Read(i, 0)*255.0f, colors.Read(i, 1)*255.0f, colors.Read(i, 2)*255.0f, alpha*255.0f);
+            }
+            else {
+                v.Color = Colors::WHITE;
+            }
+        }
+
+        unsigned int * outIndices = &model.Indices[job.FirstIndex];
+        for (size_t i = 0; i < job.IndexCount; ++i) {
+            uint32_t index = hasIndices ? indices.ReadIndex(i) : (uint32_t)i;
+            if (index >= job.VertexCount) {
+                return false;
+            }
+            outIndices[i] = (unsigned int)(job.FirstVertex + index);
+        }
+        if (mirrored) { // A negative scale turns the triangles inside out, flip them back.
+            for (size_t i = 0; i + 2 < job.IndexCount; i += 3) {
+                std::swap(outIndices[i+1], outIndices[i+2]);
+            }
+        }
+        return true;
+    }
+}
+
+bool Starsurge::ModelImporter::LoadGLTF(const std::string & path, ModelData & model) {
+    MappedFile file;
+    if (!file.Open(path)) {
+        return false;
+    }
+    const unsigned char * data = file.GetData();
+    const size_t size = file.GetSize();
+
+    // A .glb is a 12 byte header, then a JSON chunk and an optional binary chunk. Anything else is JSON.
+    const char * jsonBegin = (const char*)data;
+    const char * jsonEnd = (const char*)data + size;
+    const unsigned char * binData = NULL;
+    size_t binSize = 0;
+    if (size >= 12 && std::memcmp(data, "glTF", 4) == 0) {
+        uint32_t header[3], chunk[2];
+        std::memcpy(header, data, sizeof(header));
+        std::memcpy(chunk, data + 12, std::min<size_t>(sizeof(chunk), size - 12));
+        if (header[1] != 2 || size < 20 || chunk[1] != 0x4E4F534A || chunk[0] > size - 20) {
+            Error("Can't load "+path+": not a valid glTF 2.0 binary.");
+            return false;
+        }
+        jsonBegin = (const char*)data + 20;
+        jsonEnd = jsonBegin + chunk[0];
+        size_t binOffset = 20 + ((chunk[0] + 3) & ~3u);
+        if (binOffset + 8 <= size) {
+            std::memcpy(chunk, data + binOffset, sizeof(chunk));
+            if (chunk[1] == 0x004E4942 && chunk[0] <= size - binOffset - 8) {
+                binData = data + binOffset + 8;
+                binSize = chunk[0];
+            }
+        }
+    }
+
+    Document doc;
+    if (!JsonParser(jsonBegin, jsonEnd).Parse(doc.Json) || doc.Json.Type != JsonValue::Kind::Object) {
+        Error("Can't load "+path+": malformed JSON.");
+        return false;
+    }
+    if (doc.Json.Get("asset").Get("version").String.compare(0, 2, "2.") != 0) {
+        Error("Can't load "+path+": only glTF 2.0 is supported.");
+        return false;
+    }
+    if (!LoadBuffers(path, binData, binSize, doc)) {
+        Error("Can't load "+path+": a buffer is missing or too small.");
+        return false;
+    }
+
+    model = ModelData();
+    SceneFlattener flattener(doc, model);
+    if (!flattener.Gather()) {
+        Error("Can't load "+path+": a node, mesh or accessor is invalid or unsupported.");
+        return false;
+    }
+    const std::vector<PrimitiveJob> & jobs = flattener.Jobs;
+    size_t vertexCount = 0, indexCount = 0;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        vertexCount += jobs[i].VertexCount;
+        indexCount += jobs[i].IndexCount;
+        if (!model.Submeshes.empty() && model.Submeshes.back().MaterialSlot == jobs[i].MaterialSlot) {
+            model.Submeshes.back().IndexCount += jobs[i].IndexCount;
+        }
+        else {
+            Submesh submesh = { (unsigned int)jobs[i].FirstIndex, (unsigned int)jobs[i].IndexCount, jobs[i].MaterialSlot };
+            model.Submeshes.push_back(submesh);
+        }
+    }
+
+    // Every primitive already knows where its output goes, so they convert in parallel.
+    model.Vertices.resize(vertexCount);
+    model.Indices.resize(indexCount);
+    std::atomic<size_t> next(0);
+    std::atomic<bool> failed(false);
+    auto worker = [&]() {
+        for (size_t i = next++; i < jobs.size(); i = next++) {
+            if (!ConvertPrimitive(doc, jobs[i], model)) {
+                failed = true;
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    size_t threads = std::min<size_t>(jobs.size(), std::max(1u, std::thread::hardware_concurrency()));
+    for (size_t i = 1; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (size_t i = 0; i < pool.size(); ++i) {
+        pool[i].join();
+    }
+    if (failed) {
+        Error("Can't load "+path+": an index is past the end of its primitive.");
+        model = ModelData();
+        return false;
+    }
+
+    // Primitives are usually indexed already, this catches unindexed ones and instances of the same data.
+    MeshOptimizer::WeldVertices(model.Vertices, model.Indices);
+    return true;
+}
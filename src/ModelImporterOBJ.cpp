@@ -0,0 +1,529 @@
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <unordered_map>
+#include "../include/ModelImporter.h"
+#include "../include/Logging.h"
+
+namespace {
+    using Starsurge::Vertex;
+
+    // Bytes read from the file at a time, and the least worth handing to a thread of its own.
+    const size_t BLOCK_SIZE = 32 << 20;
+    const size_t MIN_CHUNK_SIZE = 1 << 20;
+    const uint32_t NONE = 0xFFFFFFFF;
+
+    // One face corner as written in the file. OBJ indices are 1-based, negative ones count back from the
+    // last element read so far, which for a chunk parsed on its own isn't known until the chunks before
+    // it have been counted.
+    struct Corner {
+        int64_t Index[3]; // v, vt, vn
+        unsigned char Present; // Bit k set when Index[k] was given.
+        unsigned char Relative; // Bit k set when Index[k] is relative to the chunk's own start.
+    };
+
+    // Resolved v/vt/vn triple, the identity of an output vertex.
+    struct CornerKey {
+        uint32_t Index[3];
+
+        bool operator==(const CornerKey & other) const {
+            return this->Index[0] == other.Index[0] && this->Index[1] == other.Index[1] && this->Index[2] == other.Index[2];
+        }
+    };
+
+    // Open addressing map from CornerKey to a vertex id. Much lighter than std::unordered_map at the tens
+    // of millions of entries a big scan produces.
+    class CornerTable {
+    public:
+        explicit CornerTable(size_t expected = 0) { Reserve(expected); }
+
+        // The id already stored for key, or stores and returns id.
+        uint32_t Insert(const CornerKey & key, uint32_t id) {
+            if ((this->count + 1) * 2 > this->ids.size()) {
+                Reserve(std::max<size_t>(this->count * 2, 1024));
+            }
+            size_t slot = Find(key);
+            if (this->ids[slot] == NONE) {
+                this->keys[slot] = key;
+                this->ids[slot] = id;
+                this->count++;
+            }
+            return this->ids[slot];
+        }
+    private:
+        static size_t Hash(const CornerKey & key) {
+            uint64_t h = key.Index[0] * 0x9E3779B97F4A7C15ull;
+            h ^= (key.Index[1] + 0x632BE59BD9B4E019ull + (h << 6) + (h >> 2)) * 0xBF58476D1CE4E5B9ull;
+            h ^= (key.Index[2] + 0x94D049BB133111EBull + (h << 6) + (h >> 2)) * 0x94D049BB133111EBull;
+            return (size_t)(h ^ (h >> 31));
+        }
+        size_t Find(const CornerKey & key) const {
+            const size_t mask = this->ids.size() - 1;
+            size_t slot = Hash(key) & mask;
+            while (this->ids[slot] != NONE && !(this->keys[slot] == key)) {
+                slot = (slot + 1) & mask;
+            }
+            return slot;
+        }
+        void Reserve(size_t expected) {
+            size_t capacity = 1024;
+            while (capacity < expected * 2) {
+                capacity *= 2;
+            }
+            if (capacity <= this->ids.size()) {
+                return;
+            }
+            std::vector<CornerKey> oldKeys(capacity);
+            std::vector<uint32_t> oldIds(capacity, NONE);
+            oldKeys.swap(this->keys);
+            oldIds.swap(this->ids);
+            for (size_t i = 0; i < oldIds.size(); ++i) {
+                if (oldIds[i] != NONE) {
+                    size_t slot = Find(oldKeys[i]);
+                    this->keys[slot] = oldKeys[i];
+                    this->ids[slot] = oldIds[i];
+                }
+            }
+        }
+
+        std::vector<CornerKey> keys;
+        std::vector<uint32_t> ids;
+        size_t count = 0;
+    };
+
+    // What one thread pulls out of its share of a block.
+    struct Chunk {
+        const char * Begin;
+        const char * End;
+
+        std::vector<float> Positions;
+        std::vector<float> Colors; // Empty unless a vertex in this chunk had one.
+        std::vector<float> Normals;
+        std::vector<float> UVs;
+        std::vector<Corner> Corners; // Three per triangle.
+        std::vector<std::pair<size_t, std::string>> MaterialSwitches; // Corner index and usemtl name.
+        size_t MalformedLines = 0;
+
+        // Filled in by the merge.
+        size_t Base[3];
+        std::vector<CornerKey> UniqueKeys;
+        std::vector<uint32_t> LocalIndices;
+        std::vector<std::pair<size_t, std::string>> IndexedSwitches; // Same as MaterialSwitches, by index.
+        size_t IndexOffset;
+    };
+
+    bool IsSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    const char * SkipSpaces(const char * p, const char * end) {
+        while (p < end && IsSpace(*p)) {
+            ++p;
+        }
+        return p;
+    }
+
+    // std::from_chars, but also taking the leading '+' some exporters write.
+    template<typename T>
+    const char * ParseNumber(const char * p, const char * end, T & value) {
+        if (p < end && *p == '+') {
+            ++p;
+        }
+        std::from_chars_result result = std::from_chars(p, end, value);
+        return (result.ec == std::errc()) ? result.ptr : NULL;
+    }
+
+    // Reads up to count floats. Returns how many were read.
+    size_t ParseFloats(const char * p, const char * end, float * out, size_t count) {
+        size_t n = 0;
+        while (n < count) {
+            p = SkipSpaces(p, end);
+            if (p == end || (p = ParseNumber(p, end, out[n])) == NULL) {
+                break;
+            }
+            n++;
+        }
+        return n;
+    }
+
+    // "f v v/vt v//vn v/vt/vn ...", triangulated as a fan around the first corner.
+    bool ParseFace(const char * p, const char * end, Chunk & chunk) {
+        const size_t counts[3] = { chunk.Positions.size()/3, chunk.UVs.size()/2, chunk.Normals.size()/3 };
+        Corner polygon[3];
+        size_t corners = 0;
+        while (true) {
+            p = SkipSpaces(p, end);
+            if (p == end) {
+                break;
+            }
+            Corner corner = {};
+            for (int k = 0; k < 3; ++k) {
+                if (k > 0) {
+                    if (p == end || *p != '/') {
+                        break;
+                    }
+                    ++p;
+                    if (p < end && *p == '/') { // v//vn
+                        continue;
+                    }
+                }
+                int64_t index;
+                if ((p = ParseNumber(p, end, index)) == NULL || index == 0) {
+                    return false;
+                }
+                corner.Present |= 1 << k;
+                if (index > 0) {
+                    corner.Index[k] = index - 1;
+                }
+                else {
+                    corner.Index[k] = (int64_t)counts[k] + index;
+                    corner.Relative |= 1 << k;
+                }
+            }
+            if (p < end && !IsSpace(*p)) {
+                return false;
+            }
+            if (corners < 3) {
+                polygon[corners] = corner;
+            }
+            else { // Fan: keep the first corner and slide the last one along.
+                polygon[1] = polygon[2];
+                polygon[2] = corner;
+            }
+            corners++;
+            if (corners >= 3) {
+                chunk.Corners.insert(chunk.Corners.end(), polygon, polygon + 3);
+            }
+        }
+        return corners >= 3;
+    }
+
+    void ParseChunk(Chunk & chunk) {
+        const char * p = chunk.Begin;
+        while (p < chunk.End) {
+            const char * eol = (const char*)std::memchr(p, '\n', chunk.End - p);
+            if (eol == NULL) {
+                eol = chunk.End;
+            }
+            const char * line = SkipSpaces(p, eol);
+            p = eol + 1;
+            if (line == eol || *line == '#') {
+                continue;
+            }
+            const char * keyEnd = line;
+            while (keyEnd < eol && !IsSpace(*keyEnd)) {
+                ++keyEnd;
+            }
+            const size_t keyLength = keyEnd - line;
+            bool ok = true;
+            if (keyLength == 1 && line[0] == 'v') {
+                float values[6] = {};
+                size_t n = ParseFloats(keyEnd, eol, values, 6);
+                ok = n >= 3;
+                chunk.Positions.insert(chunk.Positions.end(), values, values + 3);
+                if (n == 6 || !chunk.Colors.empty()) {
+                    chunk.Colors.resize(chunk.Positions.size() - 3, 1.0f); // Earlier vertices default to white.
+                    chunk.Colors.insert(chunk.Colors.end(), { (n == 6) ? values[3] : 1.0f, (n == 6) ? values[4] : 1.0f, (n == 6) ? values[5] : 1.0f });
+                }
+            }
+            else if (keyLength == 2 && line[0] == 'v' && line[1] == 't') {
+                float values[2] = { 0, 0 };
+                ok = ParseFloats(keyEnd, eol, values, 2) >= 1;
+                chunk.UVs.insert(chunk.UVs.end(), values, values + 2);
+            }
+            else if (keyLength == 2 && line[0] == 'v' && line[1] == 'n') {
+                float values[3] = {};
+                ok = ParseFloats(keyEnd, eol, values, 3) == 3;
+                chunk.Normals.insert(chunk.Normals.end(), values, values + 3);
+            }
+            else if (keyLength == 1 && line[0] == 'f') {
+                size_t before = chunk.Corners.size();
+                ok = ParseFace(keyEnd, eol, chunk);
+                if (!ok) {
+                    chunk.Corners.resize(before);
+                }
+            }
+            else if (keyLength == 6 && std::strncmp(line, "usemtl", 6) == 0) {
+                const char * name = SkipSpaces(keyEnd, eol);
+                const char * nameEnd = eol;
+                while (nameEnd > name && IsSpace(nameEnd[-1])) {
+                    --nameEnd;
+                }
+                chunk.MaterialSwitches.push_back(std::make_pair(chunk.Corners.size(), std::string(name, nameEnd)));
+            }
+            // Anything else (o, g, s, mtllib, curves...) doesn't affect the geometry we import.
+            if (!ok) {
+                chunk.MalformedLines++;
+            }
+        }
+    }
+
+    // Turns the chunk's corners into global v/vt/vn indices and dedupes them within the chunk. Triangles
+    // pointing at elements that don't exist are dropped.
+    void ResolveChunk(Chunk & chunk, const size_t totals[3]) {
+        CornerTable table(chunk.Corners.size() / 4);
+        size_t nextSwitch = 0;
+        for (size_t t = 0; t + 2 < chunk.Corners.size(); t += 3) {
+            while (nextSwitch < chunk.MaterialSwitches.size() && chunk.MaterialSwitches[nextSwitch].first <= t) {
+                chunk.IndexedSwitches.push_back(std::make_pair(chunk.LocalIndices.size(), chunk.MaterialSwitches[nextSwitch].second));
+                nextSwitch++;
+            }
+            CornerKey keys[3];
+            bool valid = true;
+            for (size_t c = 0; c < 3 && valid; ++c) {
+                const Corner & corner = chunk.Corners[t + c];
+                for (int k = 0; k < 3; ++k) {
+                    if (!(corner.Present & (1 << k))) {
+                        keys[c].Index[k] = NONE;
+                        continue;
+                    }
+                    int64_t index = corner.Index[k] + ((corner.Relative & (1 << k)) ? (int64_t)chunk.Base[k] : 0);
+                    if (index < 0 || index >= (int64_t)totals[k]) {
+                        valid = false;
+                        break;
+                    }
+                    keys[c].Index[k] = (uint32_t)index;
+                }
+            }
+            if (!valid) {
+                chunk.MalformedLines++;
+                continue;
+            }
+            for (size_t c = 0; c < 3; ++c) {
+                uint32_t id = table.Insert(keys[c], (uint32_t)chunk.UniqueKeys.size());
+                if (id == chunk.UniqueKeys.size()) {
+                    chunk.UniqueKeys.push_back(keys[c]);
+                }
+                chunk.LocalIndices.push_back(id);
+            }
+        }
+        for (; nextSwitch < chunk.MaterialSwitches.size(); ++nextSwitch) {
+            chunk.IndexedSwitches.push_back(std::make_pair(chunk.LocalIndices.size(), chunk.MaterialSwitches[nextSwitch].second));
+        }
+        std::vector<Corner>().swap(chunk.Corners);
+    }
+
+    template<typename F>
+    void ForEachChunk(std::vector<Chunk> & chunks, F func) {
+        std::vector<std::thread> pool;
+        for (size_t i = 1; i < chunks.size(); ++i) {
+            pool.emplace_back([&, i]() { func(chunks[i]); });
+        }
+        if (!chunks.empty()) {
+            func(chunks[0]);
+        }
+        for (size_t i = 0; i < pool.size(); ++i) {
+            pool[i].join();
+        }
+    }
+
+    // Everything gathered so far, across blocks.
+    struct OBJState {
+        std::vector<float> Positions;
+        std::vector<float> Colors;
+        std::vector<float> Normals;
+        std::vector<float> UVs;
+        CornerTable Vertices;
+        std::vector<CornerKey> VertexKeys;
+        std::vector<unsigned int> Indices;
+        // Where each material starts in Indices, in order.
+        std::vector<std::pair<size_t, unsigned int>> MaterialRanges;
+        std::unordered_map<std::string, unsigned int> MaterialSlots;
+        std::vector<std::string> MaterialNames;
+        size_t MalformedLines = 0;
+
+        bool HasColors() const { return !this->Colors.empty(); }
+    };
+
+    void ProcessBlock(const char * begin, const char * end, OBJState & state) {
+        // Split the block at line breaks, one chunk per thread.
+        size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        size_t chunkCount = std::max<size_t>(1, std::min(threads, (size_t)(end - begin) / MIN_CHUNK_SIZE));
+        std::vector<Chunk> chunks(chunkCount);
+        const char * p = begin;
+        for (size_t i = 0; i < chunkCount; ++i) {
+            const char * chunkEnd = (i + 1 == chunkCount) ? end : begin + (end - begin) * (i + 1) / chunkCount;
+            if (chunkEnd < p) {
+                chunkEnd = p;
+            }
+            const char * eol = (const char*)std::memchr(chunkEnd, '\n', end - chunkEnd);
+            chunkEnd = (eol == NULL) ? end : eol + 1;
+            chunks[i].Begin = p;
+            chunks[i].End = chunkEnd;
+            p = chunkEnd;
+        }
+        ForEachChunk(chunks, ParseChunk);
+
+        // Element counts decide where each chunk's relative indices point, and vertex colors, once seen
+        // anywhere, are needed for every vertex.
+        bool anyColors = state.HasColors();
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            anyColors = anyColors || !chunks[i].Colors.empty();
+        }
+        if (anyColors && !state.HasColors()) {
+            state.Colors.assign(state.Positions.size(), 1.0f);
+        }
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            Chunk & chunk = chunks[i];
+            chunk.Base[0] = state.Positions.size() / 3;
+            chunk.Base[1] = state.UVs.size() / 2;
+            chunk.Base[2] = state.Normals.size() / 3;
+            if (anyColors) {
+                chunk.Colors.resize(chunk.Positions.size(), 1.0f);
+                state.Colors.insert(state.Colors.end(), chunk.Colors.begin(), chunk.Colors.end());
+            }
+            state.Positions.insert(state.Positions.end(), chunk.Positions.begin(), chunk.Positions.end());
+            state.UVs.insert(state.UVs.end(), chunk.UVs.begin(), chunk.UVs.end());
+            state.Normals.insert(state.Normals.end(), chunk.Normals.begin(), chunk.Normals.end());
+            std::vector<float>().swap(chunk.Positions);
+            std::vector<float>().swap(chunk.Colors);
+            std::vector<float>().swap(chunk.UVs);
+            std::vector<float>().swap(chunk.Normals);
+            state.MalformedLines += chunk.MalformedLines;
+        }
+        // Faces may only use elements defined before them, but a forward reference within the block is
+        // still caught later by the final bounds check.
+        const size_t totals[3] = { state.Positions.size() / 3, state.UVs.size() / 2, state.Normals.size() / 3 };
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            chunks[i].MalformedLines = 0;
+        }
+        ForEachChunk(chunks, [&](Chunk & chunk) { ResolveChunk(chunk, totals); });
+
+        // Only the unique corners of each chunk go through the shared table.
+        size_t indexOffset = state.Indices.size();
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            Chunk & chunk = chunks[i];
+            state.MalformedLines += chunk.MalformedLines;
+            for (size_t k = 0; k < chunk.UniqueKeys.size(); ++k) {
+                uint32_t id = state.Vertices.Insert(chunk.UniqueKeys[k], (uint32_t)state.VertexKeys.size());
+                if (id == state.VertexKeys.size()) {
+                    state.VertexKeys.push_back(chunk.UniqueKeys[k]);
+                }
+                chunk.UniqueKeys[k].Index[0] = id; // Reused as the local to global map.
+            }
+            for (size_t s = 0; s < chunk.IndexedSwitches.size(); ++s) {
+                const std::string & name = chunk.IndexedSwitches[s].second;
+                auto it = state.MaterialSlots.find(name);
+                if (it == state.MaterialSlots.end()) {
+                    it = state.MaterialSlots.insert(std::make_pair(name, (unsigned int)state.MaterialNames.size())).first;
+                    state.MaterialNames.push_back(name);
+                }
+                state.MaterialRanges.push_back(std::make_pair(indexOffset + chunk.IndexedSwitches[s].first, it->second));
+            }
+            chunk.IndexOffset = indexOffset;
+            indexOffset += chunk.LocalIndices.size();
+        }
+        state.Indices.resize(indexOffset);
+        ForEachChunk(chunks, [&](Chunk & chunk) {
+            for (size_t k = 0; k < chunk.LocalIndices.size(); ++k) {
+                state.Indices[chunk.IndexOffset + k] = chunk.UniqueKeys[chunk.LocalIndices[k]].Index[0];
+            }
+        });
+    }
+
+    void BuildVertices(const OBJState & state, std::vector<Vertex> & vertices) {
+        vertices.resize(state.VertexKeys.size());
+        size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        size_t per = std::max<size_t>((vertices.size() + threads - 1) / threads, 65536);
+        std::vector<std::thread> pool;
+        auto build = [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                const CornerKey & key = state.VertexKeys[i];
+                Vertex & v = vertices[i];
+                const float * p = &state.Positions[key.Index[0]*3];
+                v.Position = Starsurge::Vector3(p[0], p[1], p[2]);
+                if (key.Index[2] != NONE) {
+                    const float * n = &state.Normals[key.Index[2]*3];
+                    v.Normal = Starsurge::Vector3(n[0], n[1], n[2]);
+                }
+                if (key.Index[1] != NONE) {
+                    v.UV = Starsurge::Vector2(state.UVs[key.Index[1]*2], state.UVs[key.Index[1]*2 + 1]);
+                }
+                if (state.HasColors()) {
+                    const float * c = &state.Colors[key.Index[0]*3];
+                    v.Color = Starsurge::Color(c[0]*255.0f, c[1]*255.0f, c[2]*255.0f, 255);
+                }
+                else {
+                    v.Color = Starsurge::Colors::WHITE;
+                }
+            }
+        };
+        for (size_t first = per; first < vertices.size(); first += per) {
+            pool.emplace_back(build, first, std::min(first + per, vertices.size()));
+        }
+        build(0, std::min(per, vertices.size()));
+        for (size_t i = 0; i < pool.size(); ++i) {
+            pool[i].join();
+        }
+    }
+}
+
+bool Starsurge::ModelImporter::LoadOBJ(const std::string & path, ModelData & model) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        Error("Couldn't open "+path+".");
+        return false;
+    }
+
+    // Read a block, parse everything up to its last line break and carry the partial line over.
+    OBJState state;
+    std::vector<char> buffer;
+    size_t carried = 0;
+    while (true) {
+        buffer.resize(carried + BLOCK_SIZE);
+        file.read(buffer.data() + carried, BLOCK_SIZE);
+        size_t size = carried + (size_t)file.gcount();
+        bool last = !file;
+        size_t usable = size;
+        if (!last) {
+            while (usable > carried && buffer[usable-1] != '\n') {
+                --usable;
+            }
+            if (usable == carried) { // A line longer than a block, keep reading.
+                carried = size;
+                continue;
+            }
+        }
+        if (usable > 0) {
+            ProcessBlock(buffer.data(), buffer.data() + usable, state);
+        }
+        if (last) {
+            break;
+        }
+        carried = size - usable;
+        std::memmove(buffer.data(), buffer.data() + usable, carried);
+    }
+
+    if (state.MalformedLines > 0) {
+        Log("Skipped "+std::to_string(state.MalformedLines)+" malformed lines in "+path+".");
+    }
+    BuildVertices(state, model.Vertices);
+    model.Indices.swap(state.Indices);
+
+    // usemtl switches become submeshes. Faces before the first one get an unnamed material.
+    model.Submeshes.clear();
+    model.MaterialNames = state.MaterialNames;
+    if (!state.MaterialRanges.empty()) {
+        if (state.MaterialRanges[0].first > 0) {
+            state.MaterialRanges.insert(state.MaterialRanges.begin(), std::make_pair((size_t)0, (unsigned int)model.MaterialNames.size()));
+            model.MaterialNames.push_back("");
+        }
+        for (size_t i = 0; i < state.MaterialRanges.size(); ++i) {
+            size_t first = state.MaterialRanges[i].first;
+            size_t last = (i + 1 < state.MaterialRanges.size()) ? state.MaterialRanges[i+1].first : model.Indices.size();
+            if (last <= first) {
+                continue;
+            }
+            if (!model.Submeshes.empty() && model.Submeshes.back().MaterialSlot == state.MaterialRanges[i].second) {
+                model.Submeshes.back().IndexCount += (unsigned int)(last - first);
+                continue;
+            }
+            Submesh submesh = { (unsigned int)first, (unsigned int)(last - first), state.MaterialRanges[i].second };
+            model.Submeshes.push_back(submesh);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,109 @@
+#include <cstring>
+#include <cstdint>
+#include "../include/Packing.h"
+
+unsigned short Starsurge::FloatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t absBits = bits & 0x7FFFFFFF;
+
+    if (absBits >= 0x7F800000) { // Infinity or NaN, keep NaNs quiet.
+        return (unsigned short)(sign | 0x7C00 | (absBits > 0x7F800000 ? 0x200 : 0));
+    }
+    if (absBits >= 0x477FF000) { // 65520 and up round to infinity.
+        return (unsigned short)(sign | 0x7C00);
+    }
+    if (absBits < 0x38800000) { // Below 2^-14, a half subnormal.
+        if (absBits < 0x33000000) {
+            return (unsigned short)sign;
+        }
+        uint32_t exponent = absBits >> 23;
+        uint32_t mantissa = (absBits & 0x7FFFFF) | 0x800000;
+        uint32_t shift = 126 - exponent;
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t midpoint = 1u << (shift - 1);
+        if (rest > midpoint || (rest == midpoint && (half & 1))) {
+            half++;
+        }
+        return (unsigned short)(sign | half);
+    }
+
+    // Rebias the exponent from 127 to 15 and drop 13 mantissa bits. A carry out of the mantissa correctly
+    // bumps the exponent.
+    uint32_t half = (absBits - 0x38000000) >> 13;
+    uint32_t rest = absBits & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+        half++;
+    }
+    return (unsigned short)(sign | half);
+}
+
+float Starsurge::HalfToFloat(unsigned short half) {
+    uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+    uint32_t bits;
+    if (exponent == 0x1F) {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else if (exponent == 0) {
+        // Subnormal halves are normal floats, mantissa * 2^-24.
+        float value = (float)mantissa * (1.0f / 16777216.0f);
+        return sign ? -value : value;
+    }
+    else {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float ret;
+    std::memcpy(&ret, &bits, sizeof(ret));
+    return ret;
+}
+
+Starsurge::Vector2 Starsurge::OctahedralEncode(const Vector3& normal) {
+    float l1 = std::fabs(normal[0]) + std::fabs(normal[1]) + std::fabs(normal[2]);
+    if (l1 == 0) {
+        return Vector2(0, 0);
+    }
+    float x = normal[0] / l1;
+    float y = normal[1] / l1;
+    if (normal[2] < 0) { // Fold the lower hemisphere over the diagonals.
+        float foldedX = (1 - std::fabs(y)) * (x >= 0 ? 1.0f : -1.0f);
+        float foldedY = (1 - std::fabs(x)) * (y >= 0 ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+    return Vector2(x, y);
+}
+
+Starsurge::Vector3 Starsurge::OctahedralDecode(const Vector2& encoded) {
+    Vector3 n(encoded[0], encoded[1], 1 - std::fabs(encoded[0]) - std::fabs(encoded[1]));
+    float t = std::fmax(-n[2], 0.0f);
+    n[0] += (n[0] >= 0) ? -t : t;
+    n[1] += (n[1] >= 0) ? -t : t;
+    return n.Unit();
+}
+
+short Starsurge::PackSNorm16(float value) {
+    value = std::fmin(std::fmax(value, -1.0f), 1.0f);
+    return (short)std::lround(value * 32767.0f);
+}
+
+unsigned short Starsurge::PackUNorm16(float value) {
+    value = std::fmin(std::fmax(value, 0.0f), 1.0f);
+    return (unsigned short)std::lround(value * 65535.0f);
+}
+
+unsigned char Starsurge::PackUNorm8(float value) {
+    value = std::fmin(std::fmax(value, 0.0f), 1.0f);
+    return (unsigned char)std::lround(value * 255.0f);
+}
+
+float Starsurge::UnpackSNorm16(short value) {
+    return std::fmax(value / 32767.0f, -1.0f);
+}
+
+float Starsurge::UnpackUNorm16(unsigned short value) {
+    return value / 65535.0f;
+}
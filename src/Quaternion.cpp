@@ -0,0 +1,228 @@
+#include "../include/Quaternion.h"
+
+static_assert(sizeof(Starsurge::Quaternion) == 4*sizeof(float), "Quaternion arrays must be tightly packed floats.");
+
+namespace {
+    using namespace Starsurge;
+
+    // The batch functions work on four quaternions at a time, transposed into x, y, z and w columns.
+    struct QuaternionColumns {
+        SIMD::Float4 x, y, z, w;
+
+        void Load(const Quaternion * q) {
+            x = SIMD::Load4(q[0].GetData());
+            y = SIMD::Load4(q[1].GetData());
+            z = SIMD::Load4(q[2].GetData());
+            w = SIMD::Load4(q[3].GetData());
+            SIMD::Transpose4(x, y, z, w);
+        }
+        void Store(Quaternion * q) const {
+            SIMD::Float4 r0 = x, r1 = y, r2 = z, r3 = w;
+            SIMD::Transpose4(r0, r1, r2, r3);
+            SIMD::Store4(q[0].GetData(), r0);
+            SIMD::Store4(q[1].GetData(), r1);
+            SIMD::Store4(q[2].GetData(), r2);
+            SIMD::Store4(q[3].GetData(), r3);
+        }
+        SIMD::Float4 Dot(const QuaternionColumns& other) const {
+            SIMD::Float4 d = SIMD::Mul(x, other.x);
+            d = SIMD::Add(d, SIMD::Mul(y, other.y));
+            d = SIMD::Add(d, SIMD::Mul(z, other.z));
+            return SIMD::Add(d, SIMD::Mul(w, other.w));
+        }
+        void Normalize() {
+            SIMD::Float4 inv = SIMD::SafeInverseSqrt(Dot(*this));
+            x = SIMD::Mul(x, inv);
+            y = SIMD::Mul(y, inv);
+            z = SIMD::Mul(z, inv);
+            w = SIMD::Mul(w, inv);
+        }
+    };
+
+    // Zero quaternions stay zero instead of logging an error per element.
+    Quaternion SafeNormalized(const Quaternion& q) {
+        SIMD::Float4 v = SIMD::Load4(q.GetData());
+        Quaternion ret;
+        SIMD::Store4(ret.GetData(), SIMD::Mul(v, SIMD::SafeInverseSqrt(SIMD::Splat(SIMD::Dot(v, v)))));
+        return ret;
+    }
+
+    // Weights for a*wa + b*wb. wb is negated when the quaternions are more than 180 degrees apart so we
+    // take the short way around.
+    void SlerpWeights(float d, float t, float & wa, float & wb) {
+        float sign = 1;
+        if (d < 0) {
+            d = -d;
+            sign = -1;
+        }
+        if (d > 0.9995f) { // Nearly parallel, sin(theta) is too small to divide by. Lerp instead.
+            wa = 1 - t;
+            wb = t * sign;
+            return;
+        }
+        float theta = std::acos(d);
+        float invSin = 1.0f / std::sin(theta);
+        wa = std::sin((1 - t) * theta) * invSin;
+        wb = std::sin(t * theta) * invSin * sign;
+    }
+}
+
+Starsurge::Quaternion Starsurge::Quaternion::AxisAngle(const Vector3& axis, float angle) {
+    Vector3 unit = axis.Unit();
+    float s = std::sin(angle * 0.5f);
+    return Quaternion(unit[0]*s, unit[1]*s, unit[2]*s, std::cos(angle * 0.5f));
+}
+
+Starsurge::Quaternion Starsurge::Quaternion::FromEuler(const Vector3& euler) {
+    // qz * qy * qx expanded.
+    float cx = std::cos(euler[0] * 0.5f), sx = std::sin(euler[0] * 0.5f);
+    float cy = std::cos(euler[1] * 0.5f), sy = std::sin(euler[1] * 0.5f);
+    float cz = std::cos(euler[2] * 0.5f), sz = std::sin(euler[2] * 0.5f);
+    return Quaternion(
+        sx*cy*cz - cx*sy*sz,
+        cx*sy*cz + sx*cy*sz,
+        cx*cy*sz - sx*sy*cz,
+        cx*cy*cz + sx*sy*sz
+    );
+}
+
+Starsurge::Matrix4 Starsurge::Quaternion::ToMatrix() const {
+    float x = this->data[0], y = this->data[1], z = this->data[2], w = this->data[3];
+    return Matrix4({
+        1 - 2*(y*y + z*z),     2*(x*y - z*w),     2*(x*z + y*w), 0,
+            2*(x*y + z*w), 1 - 2*(x*x + z*z),     2*(y*z - x*w), 0,
+            2*(x*z - y*w),     2*(y*z + x*w), 1 - 2*(x*x + y*y), 0,
+                        0,                 0,                 0, 1
+    });
+}
+
+Starsurge::Quaternion Starsurge::Quaternion::Nlerp(const Quaternion& a, const Quaternion& b, float t) {
+    SIMD::Float4 va = a.Load();
+    SIMD::Float4 vb = b.Load();
+    if (SIMD::Dot(va, vb) < 0) {
+        vb = SIMD::Sub(SIMD::Splat(0), vb);
+    }
+    Quaternion ret;
+    ret.Store(SIMD::Add(va, SIMD::Mul(SIMD::Sub(vb, va), SIMD::Splat(t))));
+    return SafeNormalized(ret);
+}
+
+Starsurge::Quaternion Starsurge::Quaternion::Slerp(const Quaternion& a, const Quaternion& b, float t) {
+    SIMD::Float4 va = a.Load();
+    SIMD::Float4 vb = b.Load();
+    float wa, wb;
+    SlerpWeights(SIMD::Dot(va, vb), t, wa, wb);
+    Quaternion ret;
+    ret.Store(SIMD::Add(SIMD::Mul(va, SIMD::Splat(wa)), SIMD::Mul(vb, SIMD::Splat(wb))));
+    return SafeNormalized(ret);
+}
+
+void Starsurge::Quaternion::BatchNormalize(Quaternion * quats, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        QuaternionColumns q;
+        q.Load(quats + i);
+        q.Normalize();
+        q.Store(quats + i);
+    }
+    for (; i < count; ++i) {
+        quats[i] = SafeNormalized(quats[i]);
+    }
+}
+
+void Starsurge::Quaternion::BatchMultiply(const Quaternion * lhs, const Quaternion * rhs, Quaternion * out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        QuaternionColumns a, b, r;
+        a.Load(lhs + i);
+        b.Load(rhs + i);
+        r.x = SIMD::Sub(SIMD::Add(SIMD::Add(SIMD::Mul(a.w, b.x), SIMD::Mul(a.x, b.w)), SIMD::Mul(a.y, b.z)), SIMD::Mul(a.z, b.y));
+        r.y = SIMD::Add(SIMD::Sub(SIMD::Mul(a.w, b.y), SIMD::Mul(a.x, b.z)), SIMD::Add(SIMD::Mul(a.y, b.w), SIMD::Mul(a.z, b.x)));
+        r.z = SIMD::Add(SIMD::Sub(SIMD::Add(SIMD::Mul(a.w, b.z), SIMD::Mul(a.x, b.y)), SIMD::Mul(a.y, b.x)), SIMD::Mul(a.z, b.w));
+        r.w = SIMD::Sub(SIMD::Sub(SIMD::Mul(a.w, b.w), SIMD::Mul(a.x, b.x)), SIMD::Add(SIMD::Mul(a.y, b.y), SIMD::Mul(a.z, b.z)));
+        r.Store(out + i);
+    }
+    for (; i < count; ++i) {
+        out[i] = lhs[i] * rhs[i];
+    }
+}
+
+void Starsurge::Quaternion::BatchRotate(const Quaternion * quats, const Vector3 * in, Vector3 * out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        QuaternionColumns q;
+        q.Load(quats + i);
+        SIMD::Float4 vx, vy, vz;
+        SIMD::Deinterleave3(in[i].GetData(), vx, vy, vz);
+
+        // t = 2*(q.xyz x v)
+        SIMD::Float4 tx = SIMD::Sub(SIMD::Mul(q.y, vz), SIMD::Mul(q.z, vy));
+        SIMD::Float4 ty = SIMD::Sub(SIMD::Mul(q.z, vx), SIMD::Mul(q.x, vz));
+        SIMD::Float4 tz = SIMD::Sub(SIMD::Mul(q.x, vy), SIMD::Mul(q.y, vx));
+        tx = SIMD::Add(tx, tx);
+        ty = SIMD::Add(ty, ty);
+        tz = SIMD::Add(tz, tz);
+
+        // v + w*t + q.xyz x t
+        SIMD::Float4 rx = SIMD::Add(SIMD::Add(vx, SIMD::Mul(q.w, tx)), SIMD::Sub(SIMD::Mul(q.y, tz), SIMD::Mul(q.z, ty)));
+        SIMD::Float4 ry = SIMD::Add(SIMD::Add(vy, SIMD::Mul(q.w, ty)), SIMD::Sub(SIMD::Mul(q.z, tx), SIMD::Mul(q.x, tz)));
+        SIMD::Float4 rz = SIMD::Add(SIMD::Add(vz, SIMD::Mul(q.w, tz)), SIMD::Sub(SIMD::Mul(q.x, ty), SIMD::Mul(q.y, tx)));
+        SIMD::Interleave3(out[i].GetData(), rx, ry, rz);
+    }
+    for (; i < count; ++i) {
+        out[i] = quats[i].Rotate(in[i]);
+    }
+}
+
+void Starsurge::Quaternion::BatchNlerp(const Quaternion * a, const Quaternion * b, float t, Quaternion * out, size_t count) {
+    SIMD::Float4 vt = SIMD::Splat(t);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        QuaternionColumns qa, qb;
+        qa.Load(a + i);
+        qb.Load(b + i);
+        // Flip b where the dot product is negative to take the shortest arc.
+        SIMD::Float4 d = qa.Dot(qb);
+        qb.x = SIMD::FlipSign(qb.x, d);
+        qb.y = SIMD::FlipSign(qb.y, d);
+        qb.z = SIMD::FlipSign(qb.z, d);
+        qb.w = SIMD::FlipSign(qb.w, d);
+
+        qa.x = SIMD::Add(qa.x, SIMD::Mul(SIMD::Sub(qb.x, qa.x), vt));
+        qa.y = SIMD::Add(qa.y, SIMD::Mul(SIMD::Sub(qb.y, qa.y), vt));
+        qa.z = SIMD::Add(qa.z, SIMD::Mul(SIMD::Sub(qb.z, qa.z), vt));
+        qa.w = SIMD::Add(qa.w, SIMD::Mul(SIMD::Sub(qb.w, qa.w), vt));
+        qa.Normalize();
+        qa.Store(out + i);
+    }
+    for (; i < count; ++i) {
+        out[i] = Nlerp(a[i], b[i], t);
+    }
+}
+
+void Starsurge::Quaternion::BatchSlerp(const Quaternion * a, const Quaternion * b, float t, Quaternion * out, size_t count) {
+    // There is no SIMD acos/sin here, so the weights are computed per quaternion and only the blend and
+    // normalization run four wide.
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        QuaternionColumns qa, qb;
+        qa.Load(a + i);
+        qb.Load(b + i);
+        float d[4], wa[4], wb[4];
+        SIMD::Extract(qa.Dot(qb), d);
+        for (size_t lane = 0; lane < 4; ++lane) {
+            SlerpWeights(d[lane], t, wa[lane], wb[lane]);
+        }
+        SIMD::Float4 va = SIMD::Load4(wa);
+        SIMD::Float4 vb = SIMD::Load4(wb);
+        qa.x = SIMD::Add(SIMD::Mul(qa.x, va), SIMD::Mul(qb.x, vb));
+        qa.y = SIMD::Add(SIMD::Mul(qa.y, va), SIMD::Mul(qb.y, vb));
+        qa.z = SIMD::Add(SIMD::Mul(qa.z, va), SIMD::Mul(qb.z, vb));
+        qa.w = SIMD::Add(SIMD::Mul(qa.w, va), SIMD::Mul(qb.w, vb));
+        qa.Normalize();
+        qa.Store(out + i);
+    }
+    for (; i < count; ++i) {
+        out[i] = Slerp(a[i], b[i], t);
+    }
+}
@@ -0,0 +1,244 @@
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include "../include/RenderQueue.h"
+#include "../include/GLStateCache.h"
+
+namespace {
+    using Starsurge::InstanceData;
+
+    // Where the shader prelude reads InstanceData from. The matrix takes one location per column.
+    const unsigned int INSTANCE_MODEL_LOCATION = 4;
+    const unsigned int INSTANCE_COLOR_LOCATION = 8;
+
+    // Key field widths. Ids past a field's range share its largest value, which only costs sort quality:
+    // merging draws compares the actual mesh, material and submesh.
+    const unsigned int SHADER_BITS = 8;
+    const unsigned int MATERIAL_BITS = 12;
+    const unsigned int MESH_BITS = 14;
+    const unsigned int SUBMESH_BITS = 5;
+    const unsigned int DEPTH_BITS = 24;
+    static_assert(1 + SHADER_BITS + MATERIAL_BITS + MESH_BITS + SUBMESH_BITS + DEPTH_BITS == 64, "Draw key fields must fill 64 bits.");
+
+    uint64_t Field(uint64_t value, unsigned int bits) {
+        const uint64_t max = (uint64_t(1) << bits) - 1;
+        return std::min(value, max);
+    }
+
+    // Non-negative floats order the same as their bit patterns, so the top bits are a coarse but
+    // monotonic depth.
+    uint64_t QuantizeDepth(float depth) {
+        depth = std::max(depth, 0.0f);
+        uint32_t bits;
+        std::memcpy(&bits, &depth, sizeof(bits));
+        return bits >> (32 - DEPTH_BITS);
+    }
+
+    // LSD radix sort on the keys, a byte per pass. All eight histograms come from one read, and bytes
+    // that are the same in every key (the unused high ids, mostly) are skipped.
+    template<typename Item>
+    void RadixSort(std::vector<Item> & items, std::vector<Item> & scratch) {
+        const size_t count = items.size();
+        size_t histograms[8][256] = {};
+        for (size_t i = 0; i < count; ++i) {
+            for (unsigned int b = 0; b < 8; ++b) {
+                histograms[b][(items[i].Key >> (b*8)) & 0xFF]++;
+            }
+        }
+        scratch.resize(count);
+        for (unsigned int b = 0; b < 8; ++b) {
+            size_t * histogram = histograms[b];
+            if (count == 0 || histogram[(items[0].Key >> (b*8)) & 0xFF] == count) {
+                continue;
+            }
+            size_t offset = 0;
+            for (unsigned int v = 0; v < 256; ++v) {
+                size_t n = histogram[v];
+                histogram[v] = offset;
+                offset += n;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                scratch[histogram[(items[i].Key >> (b*8)) & 0xFF]++] = items[i];
+            }
+            items.swap(scratch);
+        }
+    }
+}
+
+uint32_t Starsurge::RenderQueue::DenseIds::Get(const void * key) {
+    if (key != this->Last || this->Ids.empty()) {
+        auto it = this->Ids.emplace(key, (uint32_t)this->Ids.size()).first;
+        this->Last = key;
+        this->LastId = it->second;
+    }
+    return this->LastId;
+}
+
+void Starsurge::RenderQueue::DenseIds::Clear() {
+    this->Ids.clear();
+    this->Last = NULL;
+    this->LastId = 0;
+}
+
+Starsurge::RenderQueue::RenderQueue() : viewProjection(Matrix4::Identity()), instanceCapacity(0), sorting(true), instancing(true) {
+    this->stats = RenderQueueStats();
+}
+
+void Starsurge::RenderQueue::Begin(const Matrix4 & t_viewProjection) {
+    this->viewProjection = t_viewProjection;
+    this->commands.clear();
+    this->sortItems.clear();
+    this->shaderIds.Clear();
+    this->materialIds.Clear();
+    this->meshIds.Clear();
+}
+
+void Starsurge::RenderQueue::Submit(Mesh * mesh, const Submesh & submesh, unsigned int submeshIndex, Material * material, const Matrix4 & model, Color tint) {
+    // Depth is the clip space w of the mesh's bounds center, the distance along the view direction.
+    const Matrix4 & vp = this->viewProjection;
+    Vector3 center = model.TransformPoint(mesh->GetBoundingSphere().Center);
+    float depth = vp(3,0)*center[0] + vp(3,1)*center[1] + vp(3,2)*center[2] + vp(3,3);
+
+    uint64_t shader = Field(this->shaderIds.Get(material->GetShader()), SHADER_BITS);
+    uint64_t mat = Field(this->materialIds.Get(material), MATERIAL_BITS);
+    uint64_t meshId = Field(this->meshIds.Get(mesh), MESH_BITS);
+    uint64_t sub = Field(submeshIndex, SUBMESH_BITS);
+    uint64_t z = QuantizeDepth(depth);
+    uint64_t state = (((shader << MATERIAL_BITS | mat) << MESH_BITS | meshId) << SUBMESH_BITS) | sub;
+
+    SortItem item;
+    item.Index = this->commands.size();
+    if (material->IsTransparent()) {
+        const uint64_t farFirst = ((uint64_t(1) << DEPTH_BITS) - 1) - z;
+        item.Key = uint64_t(RenderPass::Transparent) << 63 | farFirst << (63 - DEPTH_BITS) | state;
+    }
+    else {
+        item.Key = uint64_t(RenderPass::Opaque) << 63 | state << DEPTH_BITS | z;
+    }
+    this->sortItems.push_back(item);
+
+    Command command;
+    command.DrawMesh = mesh;
+    command.DrawMaterial = material;
+    command.Range = submesh;
+    std::memcpy(command.Instance.Model, model.GetData(), sizeof(command.Instance.Model));
+    Color color = tint.ToOpenGLFormat();
+    for (size_t k = 0; k < 4; ++k) {
+        command.Instance.Color[k] = color[k];
+    }
+    this->commands.push_back(command);
+}
+
+void Starsurge::RenderQueue::Execute() {
+    this->stats = RenderQueueStats();
+    const size_t count = this->commands.size();
+    this->stats.Commands = count;
+    if (count == 0) {
+        return;
+    }
+    if (this->sorting) {
+        RadixSort(this->sortItems, this->sortScratch);
+    }
+
+    // Instances go into the buffer in draw order, so every merged run is contiguous. Orphaning lets the
+    // GPU keep reading last frame's instances.
+    this->instances.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        this->instances[i] = this->commands[this->sortItems[i].Index].Instance;
+    }
+    if (!this->instanceBuffer.IsValid()) {
+        this->instanceBuffer = GLObject::Create(GLObjectType::Buffer);
+    }
+    const size_t bytes = count * sizeof(InstanceData);
+    this->instanceCapacity = std::max(this->instanceCapacity, bytes);
+    GLStateCache::BindBuffer(GL_ARRAY_BUFFER, this->instanceBuffer.Get());
+    glBufferData(GL_ARRAY_BUFFER, this->instanceCapacity, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, this->instances.data());
+
+    unsigned int vao = 0;
+    Material * applied = NULL;
+    Shader * program = NULL;
+    for (size_t first = 0; first < count;) {
+        const Command & command = this->commands[this->sortItems[first].Index];
+        size_t end = first + 1;
+        while (this->instancing && end < count) {
+            const Command & next = this->commands[this->sortItems[end].Index];
+            if (next.DrawMesh != command.DrawMesh || next.DrawMaterial != command.DrawMaterial ||
+                next.Range.FirstIndex != command.Range.FirstIndex || next.Range.IndexCount != command.Range.IndexCount) {
+                break;
+            }
+            end++;
+        }
+
+        bool transparent = (this->sortItems[first].Key >> 63) == uint64_t(RenderPass::Transparent);
+        GLStateCache::SetBlending(transparent);
+        if (transparent) {
+            GLStateCache::SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        }
+
+        Mesh * mesh = command.DrawMesh;
+        if (mesh->IsDirty()) {
+            mesh->UpdateMesh();
+        }
+        // One lookup per draw, pooled meshes take the pool's lock for it.
+        const GeometryRange buffers = mesh->GetBuffers();
+        if (buffers.VAO != vao) {
+            vao = buffers.VAO;
+            GLStateCache::BindVertexArray(vao);
+            EnableInstanceAttributes();
+            this->stats.VertexArrayChanges++;
+        }
+        if (command.DrawMaterial != applied) {
+            if (command.DrawMaterial->GetShader() != program) {
+                program = command.DrawMaterial->GetShader();
+                this->stats.ProgramChanges++;
+            }
+            command.DrawMaterial->Apply();
+            applied = command.DrawMaterial;
+            this->stats.MaterialChanges++;
+        }
+        // Half floats and normalized integers are expanded by GL, only octahedral normals need the shader.
+        program->SetOctahedralNormals(mesh->GetVertexFormat().Normal == NormalEncoding::Octahedral);
+
+        // Mesh updates bind their own vertex buffer.
+        GLStateCache::BindBuffer(GL_ARRAY_BUFFER, this->instanceBuffer.Get());
+        PointInstanceAttributes(first * sizeof(InstanceData));
+        void * indices = (void*)(buffers.IndexOffset + command.Range.FirstIndex*mesh->GetIndexSize());
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.Range.IndexCount, mesh->GetIndexType(), indices, end - first, buffers.BaseVertex);
+        this->stats.DrawCalls++;
+        first = end;
+    }
+}
+
+void Starsurge::RenderQueue::SetSorting(bool t_enabled) {
+    this->sorting = t_enabled;
+}
+
+void Starsurge::RenderQueue::SetInstancing(bool t_enabled) {
+    this->instancing = t_enabled;
+}
+
+Starsurge::RenderQueueStats Starsurge::RenderQueue::GetStats() const {
+    return this->stats;
+}
+
+void Starsurge::RenderQueue::EnableInstanceAttributes() {
+    for (unsigned int i = INSTANCE_MODEL_LOCATION; i <= INSTANCE_COLOR_LOCATION; ++i) {
+        glEnableVertexAttribArray(i);
+        glVertexAttribDivisor(i, 1);
+    }
+}
+
+void Starsurge::RenderQueue::PointInstanceAttributes(size_t offset) {
+    for (unsigned int i = 0; i < 4; ++i) {
+        glVertexAttribPointer(INSTANCE_MODEL_LOCATION + i, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(offset + offsetof(InstanceData, Model) + i*4*sizeof(float)));
+    }
+    glVertexAttribPointer(INSTANCE_COLOR_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(offset + offsetof(InstanceData, Color)));
+}
+
+void Starsurge::RenderQueue::DisableInstanceAttributes() {
+    for (unsigned int i = INSTANCE_MODEL_LOCATION; i <= INSTANCE_COLOR_LOCATION; ++i) {
+        glDisableVertexAttribArray(i);
+    }
+}
@@ -1,6 +1,6 @@
 #include "../include/Scene.h"
 
-Starsurge::Scene::Scene() { }
+Starsurge::Scene::Scene() : viewProjection(Matrix4::Identity()) { }
 Starsurge::Scene::~Scene() { }
 
 void Starsurge::Scene::SetBgColor(Color t_bgcolor) {
@@ -11,6 +11,14 @@ Starsurge::Color Starsurge::Scene::GetBgColor() {
     return this->bgcolor;
 }
 
+void Starsurge::Scene::SetViewProjection(Matrix4 t_viewProjection) {
+    this->viewProjection = t_viewProjection;
+}
+
+Starsurge::Matrix4 Starsurge::Scene::GetViewProjection() {
+    return this->viewProjection;
+}
+
 void Starsurge::Scene::AddEntity(Entity * entity) {
     if (FindEntity(entity->GetName()) != NULL) {
         Error("Tried to add multiple entities with the name "+entity->GetName()+".");
@@ -1,7 +1,9 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <cstring>
 #include <map>
 #include "../include/Shader.h"
+#include "../include/GLStateCache.h"
 #include "../include/Logging.h"
 #include "../include/Utils.h"
 
@@ -56,25 +58,40 @@ void Starsurge::Shader::Compile() {
         "layout (location = 1) in vec3 _internal_Normal;\n"
         "layout (location = 2) in vec2 _internal_UV;\n"
         "layout (location = 3) in vec4 _internal_Color;\n"
+        "// Per instance, see InstanceData. Plain draws set them as generic attributes.\n"
+        "layout (location = 4) in mat4 _internal_InstanceModel;\n"
+        "layout (location = 8) in vec4 _internal_InstanceColor;\n"
+        "\n"
+        "// Set per mesh when its normals are octahedral encoded in _internal_Normal.xy.\n"
+        "uniform bool _internal_OctahedralNormals;\n"
         "\n"
         "out vec4 vertexColor;\n"
         "\n"
+        "vec3 _internal_OctahedralDecode(vec2 e) {\n"
+        "   vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));\n"
+        "   float t = max(-n.z, 0.0);\n"
+        "   n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));\n"
+        "   return normalize(n);\n"
+        "}\n"
+        "\n"
         "struct VertexData {\n"
         "   vec3 Position;\n"
         "   vec3 Normal;\n"
         "   vec2 UV;\n"
         "   vec4 Color;\n"
+        "   mat4 Model;\n"
         "};\n\n\0";
     vert_code += this->code;
     vert_code += "\n"
         "void main() {\n"
         "   VertexData vertexData;\n"
         "   vertexData.Position = _internal_Position;\n"
-        "   vertexData.Normal = _internal_Normal;\n"
+        "   vertexData.Normal = _internal_OctahedralNormals ? _internal_OctahedralDecode(_internal_Normal.xy) : _internal_Normal;\n"
         "   vertexData.UV = _internal_UV;\n"
-        "   vertexData.Color = _internal_Color;\n"
+        "   vertexData.Color = _internal_Color * (1.0 / 255.0) * _internal_InstanceColor;\n"
+        "   vertexData.Model = _internal_InstanceModel;\n"
         "   gl_Position = vertex(vertexData);\n"
-        "   vertexColor = _internal_Color;\n"
+        "   vertexColor = vertexData.Color;\n"
         "}\0";
     const char * vert_code_c_str = vert_code.c_str();
 
@@ -88,6 +105,7 @@ void Starsurge::Shader::Compile() {
         "   vec3 Normal;\n"
         "   vec2 UV;\n"
         "   vec4 Color;\n"
+        "   mat4 Model;\n"
         "};\n\n\0";
     frag_code += this->code;
     frag_code += "void main() {\n"
@@ -122,15 +140,68 @@ void Starsurge::Shader::Compile() {
         glGetProgramInfoLog(this->shaderProgram, 512, NULL, infoLog);
         ShaderError(infoLog);
     }
+    ResolveUniforms();
 
     this->needs_recompiling = false;
 }
 
+void Starsurge::Shader::ResolveUniforms() {
+    // Looked up once per link instead of by name on every use.
+    this->locations.clear();
+    for (auto it = this->uniforms.begin(); it != this->uniforms.end(); ++it) {
+        this->locations.push_back(glGetUniformLocation(this->shaderProgram, it->first.c_str()));
+    }
+    this->octahedralLocation = glGetUniformLocation(this->shaderProgram, "_internal_OctahedralNormals");
+
+    // A new program starts with nothing uploaded.
+    this->uploaded.assign(this->locations.size(), UniformValue());
+    this->uploadedValid.assign(this->locations.size(), false);
+    this->lastApplied = 0;
+    this->octahedralNormals = -1;
+    this->generation++;
+}
+
+const std::vector<int> & Starsurge::Shader::GetUniformLocations() {
+    return this->locations;
+}
+
+unsigned int Starsurge::Shader::GetGeneration() {
+    return this->generation;
+}
+
+bool Starsurge::Shader::ExchangeUniform(unsigned int slot, const UniformValue & value) {
+    if (slot >= this->uploaded.size()) {
+        return false;
+    }
+    if (this->uploadedValid[slot] && std::memcmp(&this->uploaded[slot], &value, sizeof(UniformValue)) == 0) {
+        return false;
+    }
+    this->uploaded[slot] = value;
+    this->uploadedValid[slot] = true;
+    return true;
+}
+
+unsigned int Starsurge::Shader::GetLastApplied() {
+    return this->lastApplied;
+}
+
+void Starsurge::Shader::SetLastApplied(unsigned int materialId) {
+    this->lastApplied = materialId;
+}
+
+void Starsurge::Shader::SetOctahedralNormals(bool enabled) {
+    if (this->octahedralNormals == (int)enabled) {
+        return;
+    }
+    glUniform1i(this->octahedralLocation, enabled);
+    this->octahedralNormals = enabled;
+}
+
 void Starsurge::Shader::Use() {
     if (this->needs_recompiling) {
         Compile();
     }
-    glUseProgram(this->shaderProgram);
+    GLStateCache::UseProgram(this->shaderProgram);
 }
 
 unsigned int Starsurge::Shader::GetProgram() {
@@ -0,0 +1,127 @@
+#include "../include/Vector3Array.h"
+#include "../include/Mesh.h"
+
+namespace {
+    size_t RoundUp(size_t n, size_t multiple) {
+        return ((n + multiple - 1) / multiple) * multiple;
+    }
+}
+
+Starsurge::Vector3Array::Vector3Array(size_t t_count) : count(0) {
+    Resize(t_count);
+}
+
+Starsurge::Vector3Array::Vector3Array(const std::vector<Vector3>& vectors) : count(0) {
+    Resize(vectors.size());
+    for (size_t i = 0; i < vectors.size(); ++i) {
+        Set(i, vectors[i]);
+    }
+}
+
+void Starsurge::Vector3Array::Resize(size_t t_count) {
+    size_t padded = RoundUp(t_count, LANES);
+    this->x.resize(padded, 0);
+    this->y.resize(padded, 0);
+    this->z.resize(padded, 0);
+    // Shrinking can leave old values in the padding.
+    for (size_t i = t_count; i < padded; ++i) {
+        this->x[i] = 0;
+        this->y[i] = 0;
+        this->z[i] = 0;
+    }
+    this->count = t_count;
+}
+
+void Starsurge::Vector3Array::Clear() {
+    Resize(0);
+}
+
+void Starsurge::Vector3Array::PushBack(const Vector3& v) {
+    Resize(this->count + 1);
+    Set(this->count - 1, v);
+}
+
+void Starsurge::Vector3Array::LoadPositions(const std::vector<Vertex>& vertices) {
+    Resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        this->x[i] = vertices[i].Position[0];
+        this->y[i] = vertices[i].Position[1];
+        this->z[i] = vertices[i].Position[2];
+    }
+}
+
+void Starsurge::Vector3Array::StorePositions(std::vector<Vertex>& vertices) const {
+    if (vertices.size() != this->count) {
+        Error("Vector3Array has "+std::to_string(this->count)+" elements but there are "+std::to_string(vertices.size())+" vertices.");
+        return;
+    }
+    for (size_t i = 0; i < this->count; ++i) {
+        vertices[i].Position = Vector3(this->x[i], this->y[i], this->z[i]);
+    }
+}
+
+std::vector<Starsurge::Vector3> Starsurge::Vector3Array::ToVector() const {
+    std::vector<Vector3> ret(this->count);
+    for (size_t i = 0; i < this->count; ++i) {
+        ret[i] = Get(i);
+    }
+    return ret;
+}
+
+void Starsurge::Vector3Array::Add(const Vector3Array& other) {
+    if (other.count != this->count) {
+        Error("Tried to add Vector3Arrays of different sizes.");
+        return;
+    }
+    GetBatchKernels().Add(X(), Y(), Z(), other.X(), other.Y(), other.Z(), PaddedSize());
+}
+
+void Starsurge::Vector3Array::Add(const Vector3& offset) {
+    GetBatchKernels().Offset(X(), Y(), Z(), offset[0], offset[1], offset[2], PaddedSize());
+    Resize(this->count); // Re-zero the padding.
+}
+
+void Starsurge::Vector3Array::Scale(float s) {
+    Scale(Vector3(s, s, s));
+}
+
+void Starsurge::Vector3Array::Scale(const Vector3& s) {
+    GetBatchKernels().Scale(X(), Y(), Z(), s[0], s[1], s[2], PaddedSize());
+}
+
+void Starsurge::Vector3Array::Normalize() {
+    GetBatchKernels().Normalize(X(), Y(), Z(), PaddedSize());
+}
+
+void Starsurge::Vector3Array::Transform(const Matrix4& m) {
+    GetBatchKernels().Transform(X(), Y(), Z(), m.GetData(), PaddedSize());
+    Resize(this->count); // Re-zero the padding.
+}
+
+void Starsurge::Vector3Array::MinMax(Vector3 & min, Vector3 & max) const {
+    if (this->count == 0) {
+        min = Vector3(0, 0, 0);
+        max = Vector3(0, 0, 0);
+        return;
+    }
+    GetBatchKernels().MinMax(X(), Y(), Z(), this->count, min.GetData(), max.GetData());
+}
+
+void Starsurge::Vector3Array::Dot(const Vector3Array& a, const Vector3Array& b, std::vector<float>& out) {
+    if (a.count != b.count) {
+        Error("Tried to dot Vector3Arrays of different sizes.");
+        return;
+    }
+    out.resize(a.PaddedSize());
+    GetBatchKernels().Dot(a.X(), a.Y(), a.Z(), b.X(), b.Y(), b.Z(), out.data(), a.PaddedSize());
+    out.resize(a.count);
+}
+
+void Starsurge::Vector3Array::Cross(const Vector3Array& a, const Vector3Array& b, Vector3Array& out) {
+    if (a.count != b.count) {
+        Error("Tried to cross Vector3Arrays of different sizes.");
+        return;
+    }
+    out.Resize(a.count);
+    GetBatchKernels().Cross(a.X(), a.Y(), a.Z(), b.X(), b.Y(), b.Z(), out.X(), out.Y(), out.Z(), a.PaddedSize());
+}
@@ -0,0 +1,619 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <vector>
+#include <glad/glad.h>
+#include "../../include/Engine.h"
+using namespace Starsurge;
+
+// The plain loop implementation Vector<N> used before it had SIMD paths, kept here as the baseline.
+template<size_t N>
+struct ScalarVector {
+    float data[N];
+
+    static float Dot(const ScalarVector<N>& lhs, const ScalarVector<N>& rhs) {
+        float ret = 0;
+        for (size_t i = 0; i < N; ++i) {
+            ret += lhs.data[i]*rhs.data[i];
+        }
+        return ret;
+    }
+    void Normalize() {
+        float mag = std::sqrt(Dot(*this, *this));
+        for (size_t i = 0; i < N; ++i) {
+            this->data[i] *= (1.0/mag);
+        }
+    }
+    ScalarVector<N>& operator+=(const ScalarVector<N>& rhs) {
+        for (size_t i = 0; i < N; ++i) {
+            this->data[i] += rhs.data[i];
+        }
+        return *this;
+    }
+};
+
+static ScalarVector<3> ScalarCross(const ScalarVector<3>& a, const ScalarVector<3>& b) {
+    return ScalarVector<3>{{ a.data[1]*b.data[2] - a.data[2]*b.data[1], -(a.data[0]*b.data[2] - a.data[2]*b.data[0]), a.data[0]*b.data[1] - a.data[1]*b.data[0] }};
+}
+
+static float RandomFloat() {
+    return (float)std::rand() / RAND_MAX * 2.0f - 1.0f;
+}
+
+template<typename F>
+static double Time(F func) {
+    auto start = std::chrono::high_resolution_clock::now();
+    func();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Benchmarks that need GL get a 3.3 core context in an invisible window. NULL when there's no display.
+static GLFWwindow * CreateHiddenContext() {
+    if (!glfwInit()) {
+        return NULL;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow * window = glfwCreateWindow(64, 64, "Starsurge benchmark", NULL, NULL);
+    if (window == NULL) {
+        glfwTerminate();
+        return NULL;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return NULL;
+    }
+    GLStateCache::Invalidate();
+    return window;
+}
+
+static void DestroyHiddenContext(GLFWwindow * window) {
+    glfwDestroyWindow(window);
+    glfwTerminate();
+}
+
+static void Report(std::string name, double baseline, double optimized, float checksum) {
+    std::cout << name << ": " << baseline << "ms -> " << optimized << "ms (" << (baseline / optimized) << "x)"
+        << " [checksum " << checksum << "]" << std::endl;
+}
+
+static void BenchmarkVectorMath(size_t count, int rounds) {
+    std::vector<ScalarVector<3>> s3(count);
+    std::vector<ScalarVector<4>> s4(count);
+    std::vector<Vector3> v3(count);
+    std::vector<Vector4> v4(count);
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t j = 0; j < 4; ++j) {
+            float f = RandomFloat();
+            if (j < 3) {
+                s3[i].data[j] = f;
+                v3[i][j] = f;
+            }
+            s4[i].data[j] = f;
+            v4[i][j] = f;
+        }
+    }
+
+    float sink = 0;
+    double baseline = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            for (size_t i = 1; i < count; ++i) {
+                sink += ScalarVector<4>::Dot(s4[i-1], s4[i]);
+            }
+        }
+    });
+    double optimized = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            for (size_t i = 1; i < count; ++i) {
+                sink += Vector4::Dot(v4[i-1], v4[i]);
+            }
+        }
+    });
+    Report("Vector4::Dot", baseline, optimized, sink);
+
+    sink = 0;
+    baseline = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            for (size_t i = 1; i < count; ++i) {
+                ScalarVector<3> c = ScalarCross(s3[i-1], s3[i]);
+                sink += c.data[0];
+            }
+        }
+    });
+    optimized = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            for (size_t i = 1; i < count; ++i) {
+                Vector3 c = Vector3::CrossProduct(v3[i-1], v3[i]);
+                sink += c[0];
+            }
+        }
+    });
+    Report("Vector3::CrossProduct", baseline, optimized, sink);
+
+    sink = 0;
+    baseline = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            for (size_t i = 1; i < count; ++i) {
+                s3[i] += s3[i-1];
+                s3[i].Normalize();
+            }
+        }
+        sink += s3[count-1].data[0];
+    });
+    optimized = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            for (size_t i = 1; i < count; ++i) {
+                v3[i] += v3[i-1];
+                v3[i].Normalize();
+            }
+        }
+        sink += v3[count-1][0];
+    });
+    Report("Vector3 += / Normalize", baseline, optimized, sink);
+}
+
+static void BenchmarkMatrixMath(size_t count, int rounds) {
+    std::vector<Vector3> points(count);
+    std::vector<Vector3> out(count);
+    for (size_t i = 0; i < count; ++i) {
+        points[i] = Vector3(RandomFloat(), RandomFloat(), RandomFloat());
+    }
+    Matrix4 model = Matrix4::TRS(Vector3(1, 2, 3), Vector3(0.3f, -0.7f, 1.1f), Vector3(2, 2, 2));
+
+    float sink = 0;
+    double baseline = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = model.TransformPoint(points[i]);
+            }
+            sink += out[count-1][0];
+        }
+    });
+    double optimized = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            model.TransformPoints(points.data(), out.data(), count);
+            sink += out[count-1][0];
+        }
+    });
+    Report("Matrix4::TransformPoints", baseline, optimized, sink);
+
+    std::vector<Matrix4> worlds(count);
+    Matrix4 viewProjection = Matrix4::Translate(Vector3(0, 0, -10));
+    sink = 0;
+    baseline = Time([&]() {
+        for (size_t i = 0; i < count; ++i) {
+            Vector3 pos = points[i];
+            worlds[i] = Matrix4::Translate(pos) * Matrix4::RotateZ(pos[2]) * Matrix4::RotateY(pos[1]) * Matrix4::RotateX(pos[0]);
+            worlds[i] = viewProjection * worlds[i];
+            sink += worlds[i](0, 3);
+        }
+    });
+    optimized = Time([&]() {
+        for (size_t i = 0; i < count; ++i) {
+            Vector3 pos = points[i];
+            worlds[i] = viewProjection * Matrix4::TRS(pos, pos, Vector3(1, 1, 1));
+            sink += worlds[i](0, 3);
+        }
+    });
+    Report("World matrices (chained vs TRS)", baseline, optimized, sink);
+}
+
+template<size_t N>
+static void BenchmarkExpression(std::string name, size_t count, int rounds) {
+    std::vector<Vector<N>> a(count), b(count), c(count), out(count);
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t j = 0; j < N; ++j) {
+            a[i][j] = RandomFloat();
+            b[i][j] = RandomFloat();
+            c[i][j] = RandomFloat();
+        }
+    }
+
+    float sink = 0;
+    double baseline = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = a[i] + b[i] - c[i] + a[i];
+            }
+            sink += out[count-1][0];
+        }
+    });
+    double optimized = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = Lazy(a[i]) + b[i] - c[i] + a[i];
+            }
+            sink += out[count-1][0];
+        }
+    });
+    Report(name, baseline, optimized, sink);
+}
+
+static void BenchmarkVector3Array(size_t count, int rounds) {
+    std::vector<Vector3> aos(count);
+    for (size_t i = 0; i < count; ++i) {
+        aos[i] = Vector3(RandomFloat(), RandomFloat(), RandomFloat());
+    }
+    Vector3Array soa(aos);
+    Matrix4 model = Matrix4::TRS(Vector3(1, 2, 3), Vector3(0.3f, -0.7f, 1.1f), Vector3(0.5f, 0.5f, 0.5f));
+
+    float sink = 0;
+    double baseline = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            for (size_t i = 0; i < count; ++i) {
+                aos[i] = model.TransformPoint(aos[i]);
+                aos[i].Normalize();
+            }
+            sink += aos[count-1][0];
+        }
+    });
+    double optimized = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            soa.Transform(model);
+            soa.Normalize();
+            sink += soa.Get(count-1)[0];
+        }
+    });
+    Report("Transform + Normalize (AoS vs Vector3Array)", baseline, optimized, sink);
+
+    Vector3 min, max;
+    baseline = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            min = aos[0];
+            max = aos[0];
+            for (size_t i = 1; i < count; ++i) {
+                min = Vector3::Min(min, aos[i]);
+                max = Vector3::Max(max, aos[i]);
+            }
+            sink += min[0] + max[0];
+        }
+    });
+    optimized = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            soa.MinMax(min, max);
+            sink += min[0] + max[0];
+        }
+    });
+    Report("MinMax (AoS vs Vector3Array)", baseline, optimized, sink);
+}
+
+static void BenchmarkDispatch(size_t count, int rounds) {
+    Vector3Array soa(count);
+    std::vector<float> radius(count);
+    std::vector<float> vertices(count*12);
+    std::vector<float> packed(count*12);
+    std::vector<unsigned char> visible(count);
+    for (size_t i = 0; i < count; ++i) {
+        soa.Set(i, Vector3(RandomFloat(), RandomFloat(), RandomFloat()));
+        radius[i] = 0.1f;
+    }
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        vertices[i] = RandomFloat() * 255.0f;
+    }
+    const float planes[] = { 1, 0, 0, 0.5f, -1, 0, 0, 0.5f, 0, 1, 0, 0.5f, 0, -1, 0, 0.5f, 0, 0, 1, 0.5f, 0, 0, -1, 0.5f };
+    Matrix4 model = Matrix4::TRS(Vector3(0.1f, 0.2f, 0.3f), Vector3(0.3f, -0.7f, 1.1f), Vector3(1, 1, 1));
+
+    SIMDLevel detected = DetectSIMDLevel();
+    double scalar[3] = { 0, 0, 0 };
+    for (int level = 0; level <= (int)detected; ++level) {
+        if (!ForceSIMDLevel((SIMDLevel)level)) {
+            continue;
+        }
+        float sink = 0;
+        double times[3];
+        times[0] = Time([&]() {
+            for (int r = 0; r < rounds; ++r) {
+                soa.Transform(model);
+                soa.Normalize();
+            }
+            sink += soa.Get(0)[0];
+        });
+        times[1] = Time([&]() {
+            for (int r = 0; r < rounds; ++r) {
+                GetBatchKernels().PackVertices(vertices.data(), packed.data(), count);
+            }
+            sink += packed[count*12-1];
+        });
+        times[2] = Time([&]() {
+            for (int r = 0; r < rounds; ++r) {
+                GetBatchKernels().CullSpheres(planes, 6, soa.X(), soa.Y(), soa.Z(), radius.data(), count, visible.data());
+            }
+            sink += visible[0];
+        });
+        if (level == 0) {
+            for (int i = 0; i < 3; ++i) {
+                scalar[i] = times[i];
+            }
+        }
+        std::string name = GetSIMDLevelName((SIMDLevel)level);
+        Report(name+" Vector3Array transform + normalize", scalar[0], times[0], sink);
+        Report(name+" PackVertices", scalar[1], times[1], sink);
+        Report(name+" CullSpheres", scalar[2], times[2], sink);
+    }
+    ForceSIMDLevel(detected);
+}
+
+static void BenchmarkQuaternions(size_t count, int rounds) {
+    std::vector<Quaternion> a(count), b(count), out(count);
+    std::vector<Vector3> eulers(count), vectors(count), rotated(count);
+    for (size_t i = 0; i < count; ++i) {
+        eulers[i] = Vector3(RandomFloat()*3, RandomFloat()*3, RandomFloat()*3);
+        a[i] = Quaternion::FromEuler(eulers[i]);
+        b[i] = Quaternion::FromEuler(Vector3(RandomFloat()*3, RandomFloat()*3, RandomFloat()*3));
+        vectors[i] = Vector3(RandomFloat(), RandomFloat(), RandomFloat());
+    }
+
+    float sink = 0;
+    double baseline = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            for (size_t i = 0; i < count; ++i) {
+                rotated[i] = Matrix4::Rotate(eulers[i]).TransformDirection(vectors[i]);
+            }
+            sink += rotated[count-1][0];
+        }
+    });
+    double optimized = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            Quaternion::BatchRotate(a.data(), vectors.data(), rotated.data(), count);
+            sink += rotated[count-1][0];
+        }
+    });
+    Report("Rotate vectors (euler matrices vs BatchRotate)", baseline, optimized, sink);
+
+    baseline = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = Quaternion::Slerp(a[i], b[i], 0.25f);
+            }
+            sink += out[count-1][0];
+        }
+    });
+    optimized = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            Quaternion::BatchSlerp(a.data(), b.data(), 0.25f, out.data(), count);
+            sink += out[count-1][0];
+        }
+    });
+    Report("Slerp (single vs BatchSlerp)", baseline, optimized, sink);
+
+    optimized = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            Quaternion::BatchNlerp(a.data(), b.data(), 0.25f, out.data(), count);
+            sink += out[count-1][0];
+        }
+    });
+    Report("Slerp vs BatchNlerp", baseline, optimized, sink);
+}
+
+static void BenchmarkMeshLoading(size_t gridSize, int rounds) {
+    // A grid mesh, written out once as text (one line per vertex and per triangle) and once as .ssm.
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    for (size_t y = 0; y <= gridSize; ++y) {
+        for (size_t x = 0; x <= gridSize; ++x) {
+            Vertex v = { Vector3(x, y, RandomFloat()), Vector3(RandomFloat(), RandomFloat(), 1).Unit(), Vector2(x/(float)gridSize, y/(float)gridSize), Color(255, 128, 0, 255) };
+            vertices.push_back(v);
+        }
+    }
+    for (size_t y = 0; y < gridSize; ++y) {
+        for (size_t x = 0; x < gridSize; ++x) {
+            unsigned int a = y*(gridSize+1) + x, b = a + 1, c = a + gridSize + 1, d = c + 1;
+            indices.insert(indices.end(), { a, b, c, b, d, c });
+        }
+    }
+    const std::string textPath = "benchmark_mesh.txt", binaryPath = "benchmark_mesh.ssm", compactPath = "benchmark_mesh_compact.ssm";
+    {
+        std::ofstream text(textPath);
+        text << vertices.size() << " " << indices.size() << "\n";
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            const Vertex & v = vertices[i];
+            text << "v " << v.Position[0] << " " << v.Position[1] << " " << v.Position[2] << " " << v.Normal[0] << " " << v.Normal[1] << " " << v.Normal[2]
+                << " " << v.UV[0] << " " << v.UV[1] << " " << v.Color[0] << " " << v.Color[1] << " " << v.Color[2] << " " << v.Color[3] << "\n";
+        }
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            text << "f " << indices[i] << " " << indices[i+1] << " " << indices[i+2] << "\n";
+        }
+    }
+    Mesh mesh; // Never uploaded, Save doesn't need a GL context.
+    mesh.SetVertices(vertices);
+    mesh.SetIndices(indices);
+    mesh.Save(binaryPath);
+    mesh.SetVertexFormat(VertexFormat::Compact());
+    mesh.Save(compactPath);
+
+    // The text side ends with the vertices and indices in memory, ready for glBufferData. Mesh::Load goes
+    // all the way: mapping, validation and the GL upload, without building a CPU copy.
+    float sink = 0;
+    double baseline = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            std::ifstream text(textPath);
+            size_t vertexCount, indexCount;
+            text >> vertexCount >> indexCount;
+            std::vector<Vertex> loaded(vertexCount);
+            std::vector<unsigned int> loadedIndices(indexCount);
+            std::string tag;
+            for (size_t i = 0; i < vertexCount; ++i) {
+                Vertex & v = loaded[i];
+                text >> tag >> v.Position[0] >> v.Position[1] >> v.Position[2] >> v.Normal[0] >> v.Normal[1] >> v.Normal[2]
+                    >> v.UV[0] >> v.UV[1] >> v.Color[0] >> v.Color[1] >> v.Color[2] >> v.Color[3];
+            }
+            for (size_t i = 0; i < indexCount; i += 3) {
+                text >> tag >> loadedIndices[i] >> loadedIndices[i+1] >> loadedIndices[i+2];
+            }
+            sink += loaded[vertexCount-1].Position[0] + loadedIndices[indexCount-1];
+        }
+    });
+    GLFWwindow * context = CreateHiddenContext();
+    if (context == NULL) {
+        std::cout << "Mesh loading: skipped, no GL context." << std::endl;
+    }
+    else {
+        const std::string paths[2] = { binaryPath, compactPath };
+        const std::string names[2] = { "Mesh loading (text vs Mesh::Load)", "Mesh loading, compact (text vs Mesh::Load)" };
+        for (size_t p = 0; p < 2; ++p) {
+            double optimized = Time([&]() {
+                for (int r = 0; r < rounds; ++r) {
+                    Mesh loaded = Mesh::Load(paths[p]);
+                    sink += loaded.NumberOfVertices() + loaded.GetBoundingSphere().Radius;
+                }
+                glFinish();
+            });
+            Report(names[p], baseline, optimized, sink);
+        }
+        GLDeletionQueue::Flush();
+        DestroyHiddenContext(context);
+    }
+    std::remove(textPath.c_str());
+    std::remove(binaryPath.c_str());
+    std::remove(compactPath.c_str());
+}
+
+static void BenchmarkOBJImport(size_t gridSize, int rounds) {
+    // A textured grid with one shared normal, every interior vertex referenced by four quads.
+    const std::string path = "benchmark_mesh.obj";
+    {
+        std::ofstream obj(path);
+        for (size_t y = 0; y <= gridSize; ++y) {
+            for (size_t x = 0; x <= gridSize; ++x) {
+                obj << "v " << x*0.01f << " " << y*0.01f << " " << RandomFloat() << "\n";
+                obj << "vt " << x/(float)gridSize << " " << y/(float)gridSize << "\n";
+            }
+        }
+        obj << "vn 0 0 1\nusemtl grid\n";
+        for (size_t y = 0; y < gridSize; ++y) {
+            for (size_t x = 0; x < gridSize; ++x) {
+                size_t a = y*(gridSize+1) + x + 1, b = a + 1, c = a + gridSize + 1, d = c + 1;
+                obj << "f " << a << "/" << a << "/1 " << b << "/" << b << "/1 " << d << "/" << d << "/1 " << c << "/" << c << "/1\n";
+            }
+        }
+    }
+
+    // The usual single threaded loader: getline, a stringstream per line and a map keyed on the corner text.
+    float sink = 0;
+    double baseline = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            std::ifstream obj(path);
+            std::vector<Vector3> positions, normals;
+            std::vector<Vector2> uvs;
+            std::vector<Vertex> loaded;
+            std::vector<unsigned int> loadedIndices;
+            std::map<std::string, unsigned int> corners;
+            std::string line, tag, corner;
+            while (std::getline(obj, line)) {
+                std::istringstream in(line);
+                in >> tag;
+                if (tag == "v" || tag == "vn") {
+                    Vector3 v;
+                    in >> v[0] >> v[1] >> v[2];
+                    (tag == "v" ? positions : normals).push_back(v);
+                }
+                else if (tag == "vt") {
+                    Vector2 uv;
+                    in >> uv[0] >> uv[1];
+                    uvs.push_back(uv);
+                }
+                else if (tag == "f") {
+                    std::vector<unsigned int> face;
+                    while (in >> corner) {
+                        auto found = corners.find(corner);
+                        if (found == corners.end()) {
+                            int p = 0, t = 0, n = 0;
+                            std::sscanf(corner.c_str(), "%d/%d/%d", &p, &t, &n);
+                            loaded.push_back({ positions[p-1], normals[n-1], uvs[t-1], Colors::WHITE });
+                            found = corners.emplace(corner, loaded.size() - 1).first;
+                        }
+                        face.push_back(found->second);
+                    }
+                    for (size_t i = 2; i < face.size(); ++i) {
+                        loadedIndices.insert(loadedIndices.end(), { face[0], face[i-1], face[i] });
+                    }
+                }
+            }
+            sink += loaded.back().Position[0] + loadedIndices.back();
+        }
+    });
+    double optimized = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            ModelData model;
+            ModelImporter::LoadOBJ(path, model);
+            sink += model.Vertices.back().Position[0] + model.Indices.back();
+        }
+    });
+    Report("OBJ import (stringstream vs ModelImporter)", baseline, optimized, sink);
+    std::remove(path.c_str());
+}
+
+static void BenchmarkNormals(size_t gridSize, int rounds) {
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    for (size_t y = 0; y <= gridSize; ++y) {
+        for (size_t x = 0; x <= gridSize; ++x) {
+            Vertex v = { Vector3(x, y, RandomFloat()), Vector3(0, 0, 0), Vector2(x/(float)gridSize, y/(float)gridSize), Colors::WHITE };
+            vertices.push_back(v);
+        }
+    }
+    for (size_t y = 0; y < gridSize; ++y) {
+        for (size_t x = 0; x < gridSize; ++x) {
+            unsigned int a = y*(gridSize+1) + x, b = a + 1, c = a + gridSize + 1, d = c + 1;
+            indices.insert(indices.end(), { a, b, c, b, d, c });
+        }
+    }
+
+    // The usual loop: scatter each face normal into its three vertices, then normalize.
+    float sink = 0;
+    double baseline = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            std::vector<Vector3> sums(vertices.size(), Vector3(0, 0, 0));
+            for (size_t i = 0; i < indices.size(); i += 3) {
+                const Vector3 & p0 = vertices[indices[i]].Position;
+                Vector3 normal = Vector3::CrossProduct(vertices[indices[i+1]].Position - p0, vertices[indices[i+2]].Position - p0);
+                sums[indices[i]] += normal;
+                sums[indices[i+1]] += normal;
+                sums[indices[i+2]] += normal;
+            }
+            for (size_t i = 0; i < vertices.size(); ++i) {
+                vertices[i].Normal = sums[i].Unit();
+            }
+            sink += vertices[vertices.size() / 2].Normal[0];
+        }
+    });
+    double optimized = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            MeshNormals::GenerateNormals(vertices, indices, NormalWeighting::Area);
+            sink += vertices[vertices.size() / 2].Normal[0];
+        }
+    });
+    Report("Area weighted normals (scatter vs MeshNormals)", baseline, optimized, sink);
+    double tangents = Time([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            sink += MeshNormals::GenerateTangents(vertices, indices)[vertices.size() / 2][0];
+        }
+    });
+    std::cout << "Tangents (MeshNormals): " << tangents << "ms" << std::endl;
+}
+
+int main() {
+    std::srand(1337);
+    std::cout << "Starsurge " << Starsurge::GetVersion() << " benchmarks (" << GetSIMDLevelName(GetSIMDLevel()) << ")" << std::endl;
+
+    BenchmarkVectorMath(1 << 16, 100);
+    BenchmarkMatrixMath(1 << 16, 100);
+    BenchmarkExpression<3>("Vector3 a + b - c + a (eager vs lazy)", 1 << 16, 100);
+    BenchmarkExpression<16>("Vector<16> a + b - c + a (eager vs lazy)", 1 << 14, 100);
+    BenchmarkVector3Array(1 << 16, 100);
+    BenchmarkDispatch(1 << 16, 100);
+    BenchmarkQuaternions(1 << 16, 20);
+    BenchmarkMeshLoading(300, 5);
+    BenchmarkOBJImport(300, 5);
+    BenchmarkNormals(1000, 5);
+    return 0;
+}